@@ -24,6 +24,7 @@
 #include <string.h>
 #include <sys/socket.h>
 #include <sys/un.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "cwc/ipc.h"
@@ -39,6 +40,11 @@ static char *help_txt =
     "  -s, --socket     path to cwc ipc socket\n"
     "  -c, --command    evaluate lua expression without entering repl\n"
     "  -f, --file       evaluate lua script from file\n"
+    "  -S, --subscribe  print comma separated signals as they are emitted\n"
+    "  -C, --call       call function registered with cwc.ipc_register, the\n"
+    "                   rest of the arguments are passed to the function\n"
+    "  -b, --bench      send the -c or -C request N times and print the\n"
+    "                   throughput instead of the result\n"
     "\n"
     "Commands:\n"
     "  client    Get all client information\n"
@@ -46,6 +52,7 @@ static char *help_txt =
     "  binds     Get all active keybinds information\n"
     "  plugin    Get all loaded plugin information\n"
     "  input     Get all input information\n"
+    "  query     Print clients, screens, tags or pools as JSON\n"
     "  reload    Reload currently running cwc session\n"
     "  help      Help about any command/subcommand\n"
     "  version   Print cwc version\n"
@@ -53,21 +60,93 @@ static char *help_txt =
     "Example:\n"
     "  cwctl -s /tmp/cwc.sock -c 'return cwc.client.focused().title'\n"
     "  cwctl -f ./show-all-client.lua\n"
+    "  cwctl -S 'client::focus,screen::prop::active_tag'\n"
+    "  cwctl -C set_volume 50\n"
+    "  cwctl -b 10000 -c 'return #cwc.client.get()'\n"
+    "  cwctl query clients\n"
     "  cwctl screen\n"
     "  cwctl -s /tmp/cwc.sock screen --filter 'DP-1' set enabled false";
 
 static struct option long_options[] = {
-    {"help",    NO_ARG, NULL, 'h'},
-    {"socket",  ARG,    NULL, 's'},
-    {"command", ARG,    NULL, 'c'},
-    {"file",    ARG,    NULL, 'f'},
-    {NULL,      0,      NULL, 0  },
+    {"help",      NO_ARG, NULL, 'h'},
+    {"socket",    ARG,    NULL, 's'},
+    {"command",   ARG,    NULL, 'c'},
+    {"file",      ARG,    NULL, 'f'},
+    {"subscribe", ARG,    NULL, 'S'},
+    {"call",      ARG,    NULL, 'C'},
+    {"bench",     ARG,    NULL, 'b'},
+    {NULL,        0,      NULL, 0  },
 };
 
 static char *socket_path = NULL;
 static char *input       = NULL;
-static char *result      = NULL;
 static int client_fd     = 0;
+static long bench_count  = 0;
+
+static struct ipc_buffer send_buffer;
+static struct ipc_buffer recv_buffer;
+static long last_frame_len = 0;
+static enum cwc_ipc_opcode last_opcode;
+
+static bool send_queued(int fd)
+{
+    while (send_buffer.len) {
+        ssize_t n = send(fd, ipc_buffer_head(&send_buffer), send_buffer.len,
+                         MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+
+        ipc_buffer_consume(&send_buffer, n);
+    }
+
+    return true;
+}
+
+/* block until a frame with the wanted opcode or IPC_ERROR arrive and return
+ * its body, the body is valid until the next call and the opcode is stored in
+ * last_opcode. Other frames are skipped.
+ */
+static const char *
+recv_message(int fd, enum cwc_ipc_opcode wanted, uint32_t *body_len)
+{
+    ipc_buffer_consume(&recv_buffer, last_frame_len);
+    last_frame_len = 0;
+
+    while (true) {
+        enum cwc_ipc_opcode opcode;
+        const char *body;
+        long frame_len = ipc_parse_frame(ipc_buffer_head(&recv_buffer),
+                                         recv_buffer.len, &opcode, &body,
+                                         body_len);
+        if (frame_len < 0)
+            return NULL;
+
+        if (frame_len > 0) {
+            if (opcode == wanted || opcode == IPC_ERROR) {
+                last_frame_len = frame_len;
+                last_opcode    = opcode;
+                return body;
+            }
+
+            ipc_buffer_consume(&recv_buffer, frame_len);
+            continue;
+        }
+
+        char *tail = ipc_buffer_reserve(&recv_buffer, 65536);
+        if (!tail)
+            return NULL;
+
+        ssize_t n = recv(fd, tail, 65536, 0);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return NULL;
+
+        recv_buffer.len += n;
+    }
+}
 
 void repl(char *cmd)
 {
@@ -77,31 +156,30 @@ void repl(char *cmd)
     setvbuf(stdout, NULL, _IONBF, 0);
     setvbuf(stderr, NULL, _IONBF, 0);
 
-    if (cmd && cmd != input) {
-        strncpy(input, cmd, BUFFER_SIZE);
-    } else if (!cmd) {
+    if (!cmd)
         printf("cwc# ");
-    }
 
     while (cmd || fgets(input, BUFFER_SIZE, stdin) != NULL) {
-        if (strlen(input) == 1)
+        const char *expr = cmd ? cmd : input;
+        if (!cmd && strlen(input) == 1)
             goto new_prompt;
 
-        int msg_size = ipc_create_message(result, BUFFER_SIZE, IPC_EVAL, input);
-        send(cfd, result, msg_size, 0);
-
-        int res_len = 0;
-        enum cwc_ipc_opcode opcode;
+        uint32_t res_len     = 0;
         const char *ipc_body = NULL;
-        do {
-            res_len  = recv(cfd, result, BUFFER_SIZE, 0);
-            ipc_body = ipc_get_body(result, &opcode);
-        } while (opcode != IPC_EVAL_RESPONSE);
+        if (ipc_buffer_append_message(&send_buffer, IPC_EVAL, expr,
+                                      strlen(expr))
+            && send_queued(cfd))
+            ipc_body = recv_message(cfd, IPC_EVAL_RESPONSE, &res_len);
+
+        if (!ipc_body) {
+            fprintf(stderr, "ipc connection error\n");
+            return;
+        }
 
-        if (res_len - HEADER_SIZE == 0) {
+        if (res_len == 0) {
             printf("<empty>");
         } else {
-            write(1, ipc_body, res_len - HEADER_SIZE);
+            write(1, ipc_body, res_len);
         }
 
         putchar('\n');
@@ -113,10 +191,154 @@ void repl(char *cmd)
     }
 }
 
+/* send the request and print the response */
+static int request(enum cwc_ipc_opcode opcode,
+                   enum cwc_ipc_opcode response,
+                   const char *body,
+                   size_t len)
+{
+    uint32_t res_len     = 0;
+    const char *ipc_body = NULL;
+    if (ipc_buffer_append_message(&send_buffer, opcode, body, len)
+        && send_queued(client_fd))
+        ipc_body = recv_message(client_fd, response, &res_len);
+
+    if (!ipc_body) {
+        fprintf(stderr, "ipc connection error\n");
+        return 1;
+    }
+
+    if (last_opcode == IPC_ERROR) {
+        fprintf(stderr, "%.*s\n", (int)res_len, ipc_body);
+        return 1;
+    }
+
+    write(1, ipc_body, res_len);
+    putchar('\n');
+    return 0;
+}
+
+/* null separated function name and arguments for IPC_CALL */
+static char *call_body(char *name, int argc, char **argv, size_t *len)
+{
+    size_t total = strlen(name);
+    for (int i = optind; i < argc; i++)
+        total += strlen(argv[i]) + 1;
+
+    char *body = malloc(total + 1);
+    if (!body)
+        return NULL;
+
+    char *tail = stpcpy(body, name);
+    for (int i = optind; i < argc; i++)
+        tail = stpcpy(tail + 1, argv[i]);
+
+    *len = total;
+    return body;
+}
+
+static double elapsed_ms(struct timespec *since)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - since->tv_sec) * 1e3
+           + (now.tv_nsec - since->tv_nsec) / 1e6;
+}
+
+/* pipeline the same request count times and report the throughput */
+#define BENCH_WINDOW 64
+static int bench(enum cwc_ipc_opcode opcode,
+                 enum cwc_ipc_opcode response,
+                 const char *body,
+                 size_t len,
+                 long count)
+{
+    struct timespec sent_at[BENCH_WINDOW], start;
+    long sent = 0, received = 0;
+    double total_latency = 0, max_latency = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    while (received < count) {
+        while (sent < count && sent - received < BENCH_WINDOW) {
+            clock_gettime(CLOCK_MONOTONIC, &sent_at[sent % BENCH_WINDOW]);
+            if (!ipc_buffer_append_message(&send_buffer, opcode, body, len))
+                return 1;
+            sent++;
+        }
+
+        uint32_t res_len;
+        const char *res_body;
+        if (!send_queued(client_fd)
+            || !(res_body = recv_message(client_fd, response, &res_len))) {
+            fprintf(stderr, "ipc connection error\n");
+            return 1;
+        }
+
+        if (last_opcode == IPC_ERROR) {
+            fprintf(stderr, "%.*s\n", (int)res_len, res_body);
+            return 1;
+        }
+
+        double latency = elapsed_ms(&sent_at[received % BENCH_WINDOW]);
+        total_latency += latency;
+        if (latency > max_latency)
+            max_latency = latency;
+        received++;
+    }
+
+    double total = elapsed_ms(&start);
+    printf("%ld requests in %.3f ms, %.0f req/s\n", count, total,
+           count / (total / 1e3));
+    printf("latency avg %.3f ms, max %.3f ms\n", total_latency / count,
+           max_latency);
+
+    return 0;
+}
+
+static int query(int argc, char **argv)
+{
+    if (optind >= argc) {
+        fprintf(stderr,
+                "missing object kind, use clients, screens, tags or pools\n");
+        return 1;
+    }
+
+    const char *kind = argv[optind++];
+    if (bench_count > 0)
+        return bench(IPC_QUERY, IPC_QUERY_RESPONSE, kind, strlen(kind),
+                     bench_count);
+
+    return request(IPC_QUERY, IPC_QUERY_RESPONSE, kind, strlen(kind));
+}
+
+/* subscribe to the signals and print the events until the connection close */
+static int subscribe(char *signals)
+{
+    for (char *c = signals; *c; c++)
+        if (*c == ',')
+            *c = '\n';
+
+    if (!ipc_buffer_append_message(&send_buffer, IPC_SIGNAL, signals,
+                                   strlen(signals))
+        || !send_queued(client_fd))
+        return 1;
+
+    setvbuf(stdout, NULL, _IONBF, 0);
+
+    uint32_t len;
+    const char *events;
+    while ((events = recv_message(client_fd, IPC_SIGNAL, &len)))
+        write(1, events, len);
+
+    return 0;
+}
+
+/* return the exit status of the command or NO_COMMAND when there is none */
+#define NO_COMMAND -1
 static int object_command(int argc, char **argv)
 {
     if (optind >= argc)
-        return 1;
+        return NO_COMMAND;
 
     char *command = argv[optind++];
 
@@ -132,6 +354,8 @@ static int object_command(int argc, char **argv)
         repl((char *)_cwctl_script_binds_lua);
     } else if (strcmp(command, "input") == 0) {
         repl((char *)_cwctl_script_input_lua);
+    } else if (strcmp(command, "query") == 0) {
+        return query(argc, argv);
     } else if (strcmp(command, "reload") == 0) {
         repl("return cwc.reload()");
     } else if (strcmp(command, "version") == 0) {
@@ -147,14 +371,46 @@ static int object_command(int argc, char **argv)
     return 0;
 }
 
+/* read the whole stream into a null terminated string */
+static char *read_stream(FILE *stream)
+{
+    size_t len = 0;
+    size_t cap = 4096;
+    char *buf  = malloc(cap);
+
+    while (buf) {
+        len += fread(buf + len, 1, cap - len - 1, stream);
+        if (len < cap - 1)
+            break;
+
+        cap *= 2;
+        char *newbuf = realloc(buf, cap);
+        if (!newbuf)
+            free(buf);
+        buf = newbuf;
+    }
+
+    if (!buf || ferror(stream)) {
+        free(buf);
+        return NULL;
+    }
+
+    buf[len] = '\0';
+    return buf;
+}
+
 int main(int argc, char **argv)
 {
-    socket_path = getenv("CWC_SOCK");
-    char *cmd   = NULL;
-    char *file  = NULL;
+    socket_path        = getenv("CWC_SOCK");
+    char *cmd          = NULL;
+    char *file         = NULL;
+    char *file_content = NULL;
+    char *signals      = NULL;
+    char *call         = NULL;
 
     int c;
-    while ((c = getopt_long(argc, argv, "+hs:c:f:", long_options, NULL)) != -1)
+    while ((c = getopt_long(argc, argv, "+hs:c:f:S:C:b:", long_options, NULL))
+           != -1)
         switch (c) {
         case 's':
             socket_path = optarg;
@@ -168,6 +424,15 @@ int main(int argc, char **argv)
         case 'f':
             file = optarg;
             break;
+        case 'S':
+            signals = optarg;
+            break;
+        case 'C':
+            call = optarg;
+            break;
+        case 'b':
+            bench_count = strtol(optarg, NULL, 10);
+            break;
         default:
             puts(help_txt);
             return 1;
@@ -192,33 +457,58 @@ int main(int argc, char **argv)
         return -1;
     }
 
-    input  = malloc(BUFFER_SIZE + 1);
-    result = malloc(BUFFER_SIZE + 1);
+    input = malloc(BUFFER_SIZE + 1);
+    if (!input) {
+        errno = ENOMEM;
+        goto error_cleanup;
+    }
 
-    int any_error = object_command(argc, argv);
+    if (signals) {
+        int ret = subscribe(signals);
+        close(client_fd);
+        return ret;
+    }
+
+    if (call || (bench_count > 0 && cmd)) {
+        enum cwc_ipc_opcode opcode = call ? IPC_CALL : IPC_EVAL;
+        size_t len                 = 0;
+        char *body = call ? call_body(call, argc, argv, &len) : strdup(cmd);
+        if (!body)
+            goto error_cleanup;
+        if (!call)
+            len = strlen(body);
+
+        int ret = bench_count > 0 ? bench(opcode, IPC_EVAL_RESPONSE, body,
+                                          len, bench_count)
+                                  : request(opcode, IPC_EVAL_RESPONSE, body,
+                                            len);
+        free(body);
+        close(client_fd);
+        return ret;
+    }
 
-    if (!any_error)
+    int status = object_command(argc, argv);
+    if (status != NO_COMMAND)
         goto cleanup;
 
-    if (!input || !result) {
-        errno = ENOMEM;
-        goto error_cleanup;
-    }
+    status = 0;
 
     if (file) {
         FILE *fstream = fopen(file, "r");
         if (!fstream)
             goto error_cleanup;
 
-        fread(input, 1, BUFFER_SIZE, fstream);
+        cmd = file_content = read_stream(fstream);
         fclose(fstream);
-        cmd = input;
+        if (!cmd)
+            goto error_cleanup;
     }
 
     repl(cmd);
 cleanup:
+    free(file_content);
     close(client_fd);
-    return 0;
+    return status;
 
 error_cleanup:
     perror(NULL);
@@ -18,6 +18,16 @@ struct cwc_layer_surface {
     bool mapped;
     struct wlr_scene_tree *popup_tree;
 
+    /* the last arrangement, the surface is skipped when the area it's
+     * arranged against doesn't change. Managed by layer_shell.c.
+     */
+    struct {
+        bool valid;
+        struct wlr_box full_area;
+        struct wlr_box bounds; // usable area before this surface
+        struct wlr_box usable; // usable area after this surface
+    } arranged;
+
     struct wl_listener new_popup_l;
     struct wl_listener destroy_l;
 
@@ -26,6 +36,9 @@ struct cwc_layer_surface {
     struct wl_listener commit_l;
 };
 
+/* arrange the layer surfaces if the output area or any layer surface geometry
+ * changed since the last arrangement, no op otherwise.
+ */
 void arrange_layers(struct cwc_output *output);
 
 #endif // !_CWC_LAYER_SHELL_H
@@ -10,6 +10,16 @@
 
 struct cwc_server;
 
+/* lua list cached in cwc_output_state.list_cache */
+enum cwc_output_list {
+    OUTPUT_LIST_CLIENTS, // cwc.client.get with screen filter
+    OUTPUT_LIST_TOPLEVELS,
+    OUTPUT_LIST_CONTAINERS,
+    OUTPUT_LIST_FOCUS_STACK,
+    OUTPUT_LIST_MINIMIZED,
+    OUTPUT_LIST_LENGTH,
+};
+
 /* output state that can be restored in case the output will come back.
  * wlroots patch 0f255b46 remove automatic reset on vt switch and switching vt
  * will destroy the wlr_output.
@@ -34,6 +44,14 @@ struct cwc_output_state {
 
     /* use array for now too lazy to manage the memory */
     struct cwc_tag_info tag_info[MAX_WORKSPACE + 1];
+
+    /* generation of the cached lua table, second index is the filter flag */
+    uint64_t list_cache[OUTPUT_LIST_LENGTH][2];
+
+    /* the only tag with valid tiled container cache, managed by master.c */
+    struct master_state *tiled_cache;
+    /* counter for cwc_container.output_order */
+    int64_t container_order;
 };
 
 /* wlr_output.data == cwc_output */
@@ -52,7 +70,11 @@ struct cwc_output {
     bool tearing_allowed;
     bool enabled;
 
-    struct timespec waiting_since;
+    int configure_pending; // managed by transaction.c
+
+    /* managed by layer_shell.c */
+    bool layers_dirty;
+    struct wlr_box layers_full_area; // full area of the last arrangement
 
     struct wlr_session_lock_surface_v1 *lock_surface;
 
@@ -88,6 +110,12 @@ void cwc_output_tiling_layout_update_container(struct cwc_container *container,
 
 void cwc_output_update_visible(struct cwc_output *output);
 
+/* invalidate the cached lua client/container list, call it after changing
+ * the toplevel/container/focus/minimized list of any output or anything that
+ * affect the visibility.
+ */
+void cwc_output_lists_changed();
+
 /* free it after use, NULL indicates the end of the array */
 struct cwc_toplevel **
 cwc_output_get_visible_toplevels(struct cwc_output *output);
@@ -135,6 +163,10 @@ void cwc_output_restore(struct cwc_output *output,
 struct cwc_output *
 cwc_output_get_other_available_output(struct cwc_output *reference);
 
+/* reapply opacity (container opacity * alpha modifier) to the node subtree */
+struct wlr_scene_node;
+void cwc_scene_node_update_opacity(struct wlr_scene_node *node);
+
 //================== TAGS ===================
 
 /* if workspace is 0, it will use the active workspace of the output */
@@ -22,6 +22,7 @@
 #include "cwc/types.h"
 
 struct cwc_server;
+struct cwc_output_state;
 struct xwayland_props;
 
 //================ XDG SHELL ================
@@ -60,17 +61,36 @@ struct cwc_toplevel {
     struct wlr_ext_foreign_toplevel_handle_v1 *ext_foreign_handle;
     struct wlr_foreign_toplevel_handle_v1 *wlr_foreign_handle;
     struct wlr_ext_image_capture_source_v1 *wlr_capture_source;
+    struct wl_event_source *capture_teardown_idle;
+    int capture_session_count;
 
     struct cwc_toplevel_decoration *decoration;
     bool mapped;
     bool tearing_hint;
     bool urgent;
-    uint32_t resize_serial;
+
+    uint32_t configure_serial; // last size configure sent
+
+    // managed by transaction.c
+    struct {
+        uint32_t serial;
+        uint64_t deadline;
+        struct cwc_output *output; // NULL when not waiting
+        struct wl_list link;
+    } configure_wait;
 
     char *xdg_tag;
     char *xdg_description;
 
     struct wl_list link_output_toplevels; // cwc_output.toplevels
+
+    /* what this toplevel currently contribute to cwc_tag_info counters */
+    struct {
+        struct cwc_output_state *state;
+        tag_bitfield_t tag;
+        bool urgent;
+        bool focused;
+    } tag_stats;
     struct wl_list link_container;        // cwc_container.toplevels
 
     struct wl_listener map_l;
@@ -171,6 +191,11 @@ void cwc_toplevel_set_above(struct cwc_toplevel *toplevel, bool set);
 void cwc_toplevel_set_below(struct cwc_toplevel *toplevel, bool set);
 void cwc_toplevel_set_urgent(struct cwc_toplevel *toplevel, bool set);
 
+/* recount the toplevel in the tag info client/urgent/focused counter, call it
+ * after changing anything that affect them.
+ */
+void cwc_toplevel_update_tag_stats(struct cwc_toplevel *toplevel);
+
 /* move the toplevel surface */
 void cwc_toplevel_set_position(struct cwc_toplevel *toplevel, int x, int y);
 void cwc_toplevel_set_position_global(struct cwc_toplevel *toplevel,
@@ -349,7 +374,20 @@ cwc_toplevel_set_size(struct cwc_toplevel *toplevel, int w, int h)
     }
 #endif // CWC_XWAYLAND
 
-    return wlr_xdg_toplevel_set_size(toplevel->xdg_toplevel, w, h);
+    toplevel->configure_serial =
+        wlr_xdg_toplevel_set_size(toplevel->xdg_toplevel, w, h);
+    return toplevel->configure_serial;
+}
+
+/* whether the last size configure isn't committed by the client yet */
+static inline bool
+cwc_toplevel_configure_pending(struct cwc_toplevel *toplevel)
+{
+    if (cwc_toplevel_is_x11(toplevel))
+        return false;
+
+    return toplevel->configure_serial
+           > toplevel->xdg_toplevel->base->current.configure_serial;
 }
 
 static inline bool cwc_toplevel_is_mapped(struct cwc_toplevel *toplevel)
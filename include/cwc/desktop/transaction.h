@@ -1,11 +1,33 @@
 #ifndef _CWC_TRANSACTION_H
 #define _CWC_TRANSACTION_H
 
+#include <stdbool.h>
+#include <stdint.h>
+
 #include "cwc/desktop/output.h"
 
+struct cwc_toplevel;
+
 void transaction_schedule_output(struct cwc_output *output);
 void transaction_schedule_tag(struct cwc_tag_info *tag);
 
+/* flush the deferred signal listener after the layout is processed */
+void transaction_schedule_signal();
+
+/* hold the output frame until the toplevel ack the configure serial */
+void transaction_wait_configure(struct cwc_toplevel *toplevel, uint32_t serial);
+void transaction_configure_acked(struct cwc_toplevel *toplevel,
+                                 uint32_t serial);
+void transaction_cancel_configure(struct cwc_toplevel *toplevel);
+void transaction_cancel_output(struct cwc_output *output);
+
+/* true when no client on the output still resizing */
+bool transaction_output_ready(struct cwc_output *output);
+
+/* present immediately e.g. on interactive resize, nestable */
+void transaction_inhibit_sync();
+void transaction_uninhibit_sync();
+
 void transaction_pause();
 void transaction_resume();
 
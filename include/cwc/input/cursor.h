@@ -8,6 +8,7 @@
 #include <wlr/util/box.h>
 
 struct cwc_server;
+struct cwc_output;
 
 enum cwc_cursor_state {
     CWC_CURSOR_STATE_NORMAL,
@@ -34,6 +35,19 @@ struct hyprcursor_buffer {
     cairo_surface_t *surface;
 };
 
+/* ready to use hyprcursor frames of one cursor shape */
+struct hyprcursor_image_set {
+    struct wl_list link; // cwc_cursor.image_cache
+    char *name;
+    uint32_t size;
+    float scale;
+
+    hyprcursor_cursor_image_data **images;
+    int images_count; // 0 means the shape is not in the theme
+    int frame_count;  // images with the buffer ready, <= images_count
+    struct wl_array buffers; // struct hyprcursor_buffer *
+};
+
 struct bsp_grab {
     struct bsp_node *horizontal;
     struct bsp_node *vertical;
@@ -60,16 +74,17 @@ struct cwc_cursor {
     const char *name_before_interactive;
     struct wlr_scene_rect *snap_overlay;
 
-    // resize scheduling
-    uint64_t last_resize_time_msec;
-    struct wlr_box pending_box;
+    // interactive pacing, applied on the grabbed output frame
+    bool interactive_dirty;
+    bool sync_inhibited; // holding transaction sync inhibit while resizing
+    uint64_t last_configure_msec;
 
     // hyprcursor
     struct hyprcursor_cursor_style_info info;
-    hyprcursor_cursor_image_data **images;
-    int images_count;
-    int frame_index; // point to animation frame in cursor_buffers
-    struct wl_array cursor_buffers; // struct hyprcursor_buffer *
+    struct hyprcursor_image_set *image_set; // currently displayed
+    struct wl_list image_cache; // hyprcursor_image_set.link, recent first
+    int image_cache_len;
+    int frame_index; // point to animation frame in image_set buffers
     struct wl_event_source *animation_timer;
     float scale;
 
@@ -190,6 +205,10 @@ void start_interactive_resize(struct cwc_toplevel *toplevel, uint32_t edges);
 /* no op when is not from interactive */
 void stop_interactive(struct cwc_cursor *cursor);
 
+/* apply the pending interactive move/resize, called on the output frame */
+void cwc_cursor_flush_interactive(struct cwc_cursor *cursor,
+                                  struct cwc_output *output);
+
 /* signal data struct */
 struct cwc_pointer_move_event {
     struct cwc_cursor *cursor;
@@ -27,8 +27,14 @@ struct cwc_keyboard_group {
 
     struct cwc_vec *handled_tracker;
 
+    /* keycode -> untransformed keysym table of the current keymap */
+    xkb_keysym_t *base_keysyms;
+    xkb_keycode_t base_keysyms_min;
+    xkb_keycode_t base_keysyms_len;
+
     struct wl_listener modifiers_l;
     struct wl_listener key_l;
+    struct wl_listener keymap_l;
 
     struct wl_listener config_commit_l; // for native
 };
@@ -84,6 +90,7 @@ enum cwc_keybind_type {
 struct cwc_keybind_info {
     enum cwc_keybind_type type;
     uint64_t key; // upper 32 bit is modifier and lower is the xkb_keysym_t
+    uint64_t serial; // unique per registration, the memory is pooled
     char *description;
     char *group;
     union {
@@ -125,6 +132,7 @@ void cwc_keybind_map_destroy(struct cwc_keybind_map *kmap);
 void cwc_keybind_map_clear(struct cwc_keybind_map *kmap);
 
 void cwc_keybind_map_stop_repeat(struct cwc_keybind_map *kmap);
+void cwc_keybind_map_set_active(struct cwc_keybind_map *kmap, bool active);
 
 struct lua_State;
 int cwc_keybind_map_register_bind_from_lua(struct lua_State *L,
@@ -156,6 +164,22 @@ bool keybind_kbd_execute(struct cwc_keybind_map *kmap,
                          uint32_t modifiers,
                          xkb_keysym_t key,
                          bool press);
+/* execute matching keybind from the default map and every active keyboard map
+ * in a single lookup, true if any keybind processed.
+ */
+bool keybind_kbd_dispatch(struct cwc_seat *seat,
+                          uint32_t modifiers,
+                          xkb_keysym_t key,
+                          bool press);
+
+/* mark the dispatch index to be rebuilt on the next key event, the keybind
+ * map functions already call this.
+ */
+void keybind_kbd_dispatch_invalidate();
+
+/* stop repeated keybind of every keyboard map */
+void keybind_kbd_stop_repeat();
+
 bool keybind_mouse_execute(struct cwc_keybind_map *kmap,
                            uint32_t modifiers,
                            uint32_t button,
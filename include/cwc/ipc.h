@@ -1,20 +1,58 @@
 #ifndef _CWC_IPC_H
 #define _CWC_IPC_H
 
-/* The ipc messaging format is:
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* The ipc messaging format is a stream of frames:
+ *
+ * ```
+ * cwc-ipc<opcode><body length>body...
+ * ```
+ *
+ * Each frame start with the 7 byte signature "cwc-ipc", followed by a byte of
+ * opcode and the body length as 32 bit unsigned integer in host byte order.
+ * The body is not null terminated. Frames can be sent back to back without
+ * waiting for the response, the compositor answer them in order.
+ *
+ * Sending IPC_SIGNAL with newline separated signal names subscribe to them, a
+ * name prefixed with '-' unsubscribe. The compositor then push IPC_SIGNAL
+ * frames containing one event per line:
  *
  * ```
- * cwc-ipc\n
- * <opcode>\n
- * body...
+ * <signal name>\t<arg>\t<arg>...\n
  * ```
  *
- * The first line contain the signature which is "cwc-ipc", the second line
- * contain a byte of opcode, and the rest is the message body.
+ * Object arguments are written as `<classname>:<pointer>`, strings have tab,
+ * newline and backslash escaped. Events are batched per event loop iteration
+ * and an event identical to the one right before it in the batch is sent
+ * once, so the last event of each object always reflect its state. When the
+ * client doesn't keep up, events are dropped and a `!dropped\t<count>` line
+ * is sent once it catches up.
+ *
+ * IPC_CALL call a function registered from lua with `cwc.ipc_register`
+ * without compiling any lua code, the body is the function name followed by
+ * the arguments, all null separated:
+ *
+ * ```
+ * <name>\0<arg>\0<arg>...
+ * ```
+ *
+ * The arguments are passed as lua string and the answer is an
+ * IPC_EVAL_RESPONSE just like IPC_EVAL.
+ *
+ * IPC_QUERY snapshot the compositor state without entering lua, the body is
+ * the object kind: `clients`, `screens`, `tags` or `pools`. The
+ * IPC_QUERY_RESPONSE body is a JSON array of objects. An unknown kind or a
+ * query that can't be served is answered with IPC_ERROR instead, the body is
+ * the error message.
  */
 
-#define IPC_HEADER  "cwc-ipc"
-#define HEADER_SIZE (sizeof(IPC_HEADER) + 2)
+#define IPC_HEADER        "cwc-ipc"
+#define IPC_HEADER_LEN    (sizeof(IPC_HEADER) - 1)
+#define HEADER_SIZE       (IPC_HEADER_LEN + 1 + sizeof(uint32_t))
+#define IPC_MAX_BODY_SIZE (64u << 20)
 
 /* Opcode is 1 byte after header */
 enum cwc_ipc_opcode {
@@ -25,11 +63,36 @@ enum cwc_ipc_opcode {
 
     /* compositor object signal such client, screen, etc. */
     IPC_SIGNAL,
+
+    /* call a function registered by `cwc.ipc_register` */
+    IPC_CALL,
+
+    /* snapshot of clients, screens or tags as JSON */
+    IPC_QUERY,
+    IPC_QUERY_RESPONSE,
+
+    /* the request can't be served, the body is the error message */
+    IPC_ERROR,
+};
+
+/* growable byte queue, bytes are appended at the tail and consumed from the
+ * head. The memory is kept around for the next message.
+ */
+struct ipc_buffer {
+    char *data;
+    size_t start; // offset of the first unconsumed byte
+    size_t len;   // unconsumed byte count
+    size_t cap;
 };
 
 /* check if msg header is valid */
 bool check_header(const char *msg);
 
+/* write frame header for a body with length of body_len */
+void ipc_write_header(char *dest,
+                      enum cwc_ipc_opcode opcode,
+                      uint32_t body_len);
+
 /* create message with known string length */
 int ipc_create_message_n(char *dest,
                          int maxlen,
@@ -46,4 +109,46 @@ int ipc_create_message(char *dest,
 /* return a pointer to the message body (a slice) in msg.  */
 const char *ipc_get_body(const char *msg, enum cwc_ipc_opcode *opcode);
 
+/* parse a frame at the start of data. Return the whole frame size when
+ * complete, 0 when more data is needed, and -1 when the frame is invalid.
+ */
+long ipc_parse_frame(const char *data,
+                     size_t len,
+                     enum cwc_ipc_opcode *opcode,
+                     const char **body,
+                     uint32_t *body_len);
+
+/* make room for n bytes at the tail, return the tail or NULL when out of
+ * memory. Add the written byte count to buf->len afterwards.
+ */
+char *ipc_buffer_reserve(struct ipc_buffer *buf, size_t n);
+
+/* append raw bytes, return false when out of memory */
+bool ipc_buffer_append(struct ipc_buffer *buf, const void *data, size_t n);
+
+/* append a whole frame, return false when out of memory */
+bool ipc_buffer_append_message(struct ipc_buffer *buf,
+                               enum cwc_ipc_opcode opcode,
+                               const char *body,
+                               size_t n);
+
+/* drop n bytes from the head */
+void ipc_buffer_consume(struct ipc_buffer *buf, size_t n);
+
+void ipc_buffer_fini(struct ipc_buffer *buf);
+
+/* check if the event repeat the last event of the batch which is last_len
+ * bytes long, only consecutive duplicate can be dropped without changing what
+ * the subscriber end up with.
+ */
+bool ipc_signal_batch_repeat(struct ipc_buffer *batch,
+                             size_t last_len,
+                             const char *event,
+                             size_t len);
+
+static inline char *ipc_buffer_head(struct ipc_buffer *buf)
+{
+    return buf->data + buf->start;
+}
+
 #endif // !_CWC_IPC_H
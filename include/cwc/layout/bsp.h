@@ -29,6 +29,11 @@ struct bsp_node {
 
     bool enabled;
 
+    /* leaf: reconfigure even if the area is unchanged.
+     * internal: one of the descendant is dirty.
+     */
+    bool dirty;
+
     enum bsp_split_type split_type;
 
     /* factor of the left leaf node */
@@ -63,9 +68,17 @@ void bsp_node_disable(struct bsp_node *node);
 
 struct bsp_node *bsp_get_root(struct bsp_node *node);
 
-/* update the bsp in O(n) complexity */
+/* update the bsp in O(n) complexity, only leaf which geometry changed get
+ * configured
+ */
 void bsp_update_root(struct cwc_output *output, int workspace);
 
+/* force the node to be reconfigured on the next update */
+void bsp_node_mark_dirty(struct bsp_node *node);
+
+/* set the left factor and update the subtree below it */
+void bsp_node_set_wfact(struct bsp_node *node, double wfact);
+
 void bsp_last_focused_update(struct cwc_container *container);
 
 struct bsp_root_entry *
@@ -21,9 +21,23 @@ enum container_state_mask {
 struct border_buffer {
     struct wlr_buffer base;
     struct _cairo_surface *surface;
-    struct wlr_scene_buffer *scene;
 };
 
+/* border is drawn as nine-slice without the center */
+enum border_slice {
+    BORDER_SLICE_TOP_LEFT,
+    BORDER_SLICE_TOP,
+    BORDER_SLICE_TOP_RIGHT,
+    BORDER_SLICE_RIGHT,
+    BORDER_SLICE_BOTTOM_RIGHT,
+    BORDER_SLICE_BOTTOM,
+    BORDER_SLICE_BOTTOM_LEFT,
+    BORDER_SLICE_LEFT,
+    BORDER_SLICE_COUNT,
+};
+
+struct border_tileset;
+
 struct cwc_border {
     enum cwc_data_type type;
     int thickness;     // border_width
@@ -34,7 +48,8 @@ struct cwc_border {
     bool enabled;
 
     struct wlr_scene_tree *attached_tree;
-    struct border_buffer *buffer[4]; // clockwise top to left
+    struct border_tileset *tiles; // shared with other border with same look
+    struct wlr_scene_buffer *scene[BORDER_SLICE_COUNT];
 };
 
 void cwc_border_init(struct cwc_border *border,
@@ -83,6 +98,12 @@ struct cwc_container {
     /* node that will be used in bsp layout */
     struct bsp_node *bsp_node;
 
+    /* slot in the master tiled cache and the position in the output container
+     * list as a sort key, both managed by master.c.
+     */
+    int tiled_index;
+    int64_t output_order;
+
     /* for restoring to original output when hotplugging or switching vt */
     struct old_output {
         struct cwc_output *output;
@@ -132,6 +153,12 @@ cwc_container_get_front_toplevel(struct cwc_container *cont);
 void cwc_container_set_enabled(struct cwc_container *container, bool set);
 void cwc_container_set_front_toplevel(struct cwc_toplevel *toplevel);
 void cwc_container_set_size(struct cwc_container *container, int w, int h);
+
+/* clamp the size to what cwc_container_set_size give a tiled container */
+void cwc_container_clamp_tiled_size(struct cwc_container *container,
+                                    int *w,
+                                    int *h);
+
 void cwc_container_set_position(struct cwc_container *container, int x, int y);
 void cwc_container_set_position_gap(struct cwc_container *container,
                                     int x,
@@ -164,6 +191,7 @@ bool cwc_container_is_currently_tiled(struct cwc_container *container);
 
 void cwc_container_move_to_tag(struct cwc_container *container, int workspace);
 void cwc_container_set_tag(struct cwc_container *container, tag_bitfield_t tag);
+void cwc_container_update_tag_stats(struct cwc_container *container);
 void cwc_container_to_center(struct cwc_container *container);
 
 void cwc_container_restore_floating_box(struct cwc_container *container);
@@ -6,6 +6,7 @@
 struct cwc_toplevel;
 struct cwc_output;
 struct cwc_cursor;
+struct cwc_container;
 
 struct master_state;
 
@@ -43,6 +44,15 @@ struct layout_interface *get_default_master_layout();
 
 void master_arrange_update(struct cwc_output *output);
 
+/* patch the tiled cache after the container tiled state may have changed */
+void master_tiled_update_container(struct cwc_container *container);
+
+/* must be called before the container leave the output container list */
+void master_tiled_remove_container(struct cwc_container *container);
+
+/* rebuild the tiled cache on the next arrange */
+void master_tiled_invalidate(struct cwc_output *output);
+
 void master_resize_start(struct cwc_output *output, struct cwc_cursor *cursor);
 void master_resize_update(struct cwc_output *output, struct cwc_cursor *cursor);
 void master_resize_end(struct cwc_output *output, struct cwc_cursor *cursor);
@@ -26,6 +26,7 @@
 #include <lauxlib.h>
 #include <lua.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <string.h>
 #include <wlr/util/box.h>
 
@@ -34,11 +35,24 @@ extern bool luacheck;
 extern char *config_path;
 extern char *library_path;
 
+/* registry table of function callable with IPC_CALL, indexed by name */
+extern const char *const LUAC_IPC_FUNCTION_REGISTRY_KEY;
+
 int luaC_init();
 void luaC_fini();
 
 void luaC_box_from_table(lua_State *L, int table_pos, struct wlr_box *box);
 
+/* push a copy of the table cached in the slot and return true if it's still
+ * from the generation, otherwise push nothing.
+ */
+bool luaC_list_cache_get(lua_State *L, uint64_t *slot, uint64_t generation);
+
+/* cache the table on top of the stack for the generation and replace it with
+ * a copy, so the caller can't modify the cached one.
+ */
+void luaC_list_cache_set(lua_State *L, uint64_t *slot, uint64_t generation);
+
 //========== MACRO =============
 
 static inline void luaC_dumpstack(lua_State *L)
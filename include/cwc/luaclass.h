@@ -26,8 +26,9 @@ void luaC_register_table(lua_State *L,
 
 // int luaC_client_create(lua_State *L, struct cwc_toplevel *toplevel)
 // {
-//     struct cwc_toplevel **c_udat = lua_newuserdata(L, sizeof(&toplevel));
-//     *c_udat                      = toplevel;
+//     struct luaC_object_udata *udata = lua_newuserdata(L, sizeof(*udata));
+//     udata->pointer                  = toplevel;
+//     udata->valid                    = false;
 //
 //     luaL_getmetatable(L, client_classname);
 //     lua_setmetatable(L, -2);
@@ -37,10 +38,11 @@ void luaC_register_table(lua_State *L,
 
 // struct cwc_toplevel *luaC_client_checkudata(lua_State *L, int ud)
 // {
-//     struct cwc_toplevel **udata = luaL_checkudata(L, ud, client_classname);
-//     if (luaC_object_valid(L, *udata))
-//          return *udata;
-//     luaL_error(L, "Object is not valid");
+//     struct luaC_object_udata *udata =
+//         luaL_checkudata(L, ud, client_classname);
+//     if (udata->valid)
+//         return udata->pointer;
+//     luaL_error(L, "object already destroyed or invalid");
 //     return NULL;
 // }
 
@@ -76,10 +78,10 @@ void luaC_register_table(lua_State *L,
     static inline struct cstruct_name *luaC_##obj_classname##_checkudata(     \
         lua_State *L, int ud)                                                 \
     {                                                                         \
-        struct cstruct_name **udata =                                         \
+        struct luaC_object_udata *udata =                                     \
             luaL_checkudata(L, ud, obj_classname##_classname);                \
-        if (luaC_object_valid(L, *udata))                                     \
-            return *udata;                                                    \
+        if (udata->valid)                                                     \
+            return udata->pointer;                                            \
         luaL_error(L, "object already destroyed or invalid");                 \
         return NULL;                                                          \
     }                                                                         \
@@ -87,8 +89,9 @@ void luaC_register_table(lua_State *L,
     static inline int luaC_##obj_classname##_create(                          \
         lua_State *L, struct cstruct_name *cstruct)                           \
     {                                                                         \
-        struct cstruct_name **udata = lua_newuserdata(L, sizeof(&cstruct));   \
-        *udata                      = cstruct;                                \
+        struct luaC_object_udata *udata = lua_newuserdata(L, sizeof(*udata)); \
+        udata->pointer                  = cstruct;                            \
+        udata->valid                    = false;                              \
         luaL_getmetatable(L, obj_classname##_classname);                      \
         lua_setmetatable(L, -2);                                              \
         return 1;                                                             \
@@ -24,28 +24,50 @@
 
 #include <lauxlib.h>
 #include <lua.h>
+#include <stdbool.h>
+#include <stdint.h>
 
 extern const char *const LUAC_OBJECT_REGISTRY_KEY;
 extern const char *const LUAC_OBJECT_UDATA_REGISTRY_KEY;
 
+/* integer keys of the registries in LUA_REGISTRYINDEX, the string keys above
+ * point to the same tables.
+ */
+extern int luaC_object_registry_ref;
+extern int luaC_object_udata_registry_ref;
+
+/* last serial given to a registered object */
+extern uint64_t luaC_object_serial;
+
+/* memory layout of a class object userdata */
+struct luaC_object_udata {
+    void *pointer;
+    bool valid;      // false once the object is unregistered
+    uint64_t serial; // tell apart objects that reuse the same pointer
+};
+
 /* get the object registry table */
 static inline void luaC_object_registry_push(lua_State *L)
 {
-    lua_pushstring(L, LUAC_OBJECT_REGISTRY_KEY);
-    lua_rawget(L, LUA_REGISTRYINDEX);
+    lua_rawgeti(L, LUA_REGISTRYINDEX, luaC_object_registry_ref);
 }
 
 /* get the object user data registry table */
 static inline void luaC_object_data_registry_push(lua_State *L)
 {
-    lua_pushstring(L, LUAC_OBJECT_UDATA_REGISTRY_KEY);
-    lua_rawget(L, LUA_REGISTRYINDEX);
+    lua_rawgeti(L, LUA_REGISTRYINDEX, luaC_object_udata_registry_ref);
 }
 
 /* put a lua object at idx to the object registry with the pointer as key */
 static inline int
 luaC_object_register(lua_State *L, int idx, const void *pointer)
 {
+    struct luaC_object_udata *udata = lua_touserdata(L, idx);
+    if (udata) {
+        udata->valid  = true;
+        udata->serial = ++luaC_object_serial;
+    }
+
     lua_pushvalue(L, idx);
     luaC_object_registry_push(L);
 
@@ -72,6 +94,14 @@ static inline int luaC_object_unregister(lua_State *L, const void *pointer)
 {
     luaC_object_registry_push(L);
 
+    /* invalidate the userdata still referenced by lua */
+    lua_pushlightuserdata(L, (void *)pointer);
+    lua_rawget(L, -2);
+    struct luaC_object_udata *udata = lua_touserdata(L, -1);
+    if (udata)
+        udata->valid = false;
+    lua_pop(L, 1);
+
     lua_pushlightuserdata(L, (void *)pointer);
     lua_pushnil(L);
     lua_rawset(L, -3);
@@ -100,7 +130,7 @@ static inline int luaC_object_push(lua_State *L, const void *pointer)
     luaC_object_registry_push(L);
     lua_pushlightuserdata(L, (void *)pointer);
     lua_rawget(L, -2);
-    lua_remove(L, -2);
+    lua_replace(L, -2);
     return 1;
 }
 
@@ -127,7 +157,7 @@ static inline int luaC_object_udata_push(lua_State *L, const void *pointer)
     luaC_object_data_registry_push(L);
     lua_pushlightuserdata(L, (void *)pointer);
     lua_rawget(L, -2);
-    lua_remove(L, -2);
+    lua_replace(L, -2);
     return 1;
 }
 
@@ -43,6 +43,11 @@ struct spawn_obj {
     } CWC_PRIVATE;
 };
 
+/* argv[1] that make cwc run as the spawn helper instead of the compositor */
+#define CWC_SPAWN_HELPER_ARG "--spawn-helper"
+
+int spawn_helper_main(int argc, char **argv);
+
 void spawn(char **argv);
 void spawn_easy_async(char **argv, struct cwc_process_callback_info info);
 
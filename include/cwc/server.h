@@ -20,6 +20,7 @@ struct cwc_server {
     struct wlr_renderer *renderer;
     struct wlr_allocator *allocator;
     struct wlr_compositor *compositor;
+    struct wl_listener new_surface_l;
     struct wlr_scene *scene;
     struct wlr_scene_output_layout *scene_layout;
     struct wlr_session *session;
@@ -84,6 +85,7 @@ struct cwc_server {
     struct wlr_ext_foreign_toplevel_image_capture_source_manager_v1
         *foreign_toplevel_image_capture_source_manager;
     struct wl_listener new_capture_source_request_l;
+    int capture_scene_count; // lazily created toplevel capture scene
 
     struct wlr_xdg_toplevel_tag_manager_v1 *xdg_toplevel_tag_manager;
     struct wl_listener xdg_toplevel_set_tag_l;
@@ -140,7 +142,8 @@ struct cwc_server {
     // server wide state
     struct cwc_container *insert_marked; // managed by container.c
     struct cwc_output *focused_output;   // managed by output.c
-    int resize_count;                    // frame synchronization
+    uint64_t list_generation;            // see cwc_output_lists_changed
+    bool scene_opacity_dirty;            // reapply opacity to whole scene
 };
 
 /* global server instance from main */
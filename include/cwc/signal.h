@@ -2,12 +2,20 @@
 #define _CWC_SIGNAL_H
 
 #include <lua.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <wayland-util.h>
 
 #include "cwc/luaobject.h"
 
 typedef void (*signal_callback_t)(void *data);
 
+/* interned signal name, the id is an index so emitting by id skip the string
+ * hashing. An id is valid for the lifetime of the compositor.
+ */
+typedef uint32_t cwc_signal_id_t;
+#define CWC_SIGNAL_INVALID 0
+
 struct signal_c_callback {
     struct wl_list link;
     signal_callback_t callback;
@@ -18,11 +26,69 @@ struct signal_lua_callback {
     int luaref;
 };
 
+struct cwc_imap;
+
+struct cwc_signal_deferred_stats {
+    uint64_t emitted;   // emission while a deferred listener is connected
+    uint64_t collapsed; // emission merged into an already queued one
+    uint64_t delivered; // queued notification flushed to the listener
+    uint64_t dropped;   // the object is destroyed before the flush
+};
+
+struct cwc_signal_emit_stats {
+    uint64_t dispatched; // emission that reach at least one listener
+    uint64_t skipped;    // nobody listen, the argument is never built
+};
+
 struct cwc_signal_entry {
+    cwc_signal_id_t id;
+    char *name;
+
     struct wl_list c_callbacks;   // struct signal_c_callback.link
     struct wl_list lua_callbacks; // struct signal_lua_callback.link
+    int ipc_subscribers;          // ipc client subscribed to this signal
+
+    /* listener that run once per transaction instead of every emission */
+    struct wl_list deferred_c_callbacks;   // struct signal_c_callback.link
+    struct wl_list deferred_lua_callbacks; // struct signal_lua_callback.link
+    struct cwc_imap *deferred_queued;      // object pointer to queue index + 1
+    struct cwc_signal_deferred_stats deferred_stats;
+
+    struct cwc_signal_emit_stats emit_stats;
 };
 
+/* Get the id of a signal, the signal is created if it's not exist yet */
+cwc_signal_id_t cwc_signal_intern(const char *name);
+
+/* Get the id of an existing signal or CWC_SIGNAL_INVALID */
+cwc_signal_id_t cwc_signal_lookup(const char *name);
+
+/* return NULL if the id is invalid */
+const char *cwc_signal_get_name(cwc_signal_id_t id);
+
+/* intern the signal once per call site */
+#define CWC_SIGNAL(name)                        \
+    ({                                          \
+        static cwc_signal_id_t __sig_id = 0;    \
+        if (!__sig_id)                          \
+            __sig_id = cwc_signal_intern(name); \
+        __sig_id;                               \
+    })
+
+/* true if there is any C, lua, deferred listener or ipc subscriber */
+bool cwc_signal_has_listener(cwc_signal_id_t id);
+
+/* Same as cwc_signal_has_listener but false is counted as skipped emission,
+ * use it to skip building the lua argument before calling cwc_signal_emit_id.
+ */
+bool cwc_signal_prepare_emit(cwc_signal_id_t id);
+
+/* Get the emit counter of a signal or the total if name is NULL, return false
+ * if the signal doesn't exist.
+ */
+bool cwc_signal_get_emit_stats(const char *name,
+                               struct cwc_signal_emit_stats *stats);
+
 /* Register a listener for C function */
 void cwc_signal_connect(const char *name, signal_callback_t callback);
 
@@ -35,12 +101,41 @@ void cwc_signal_disconnect(const char *name, signal_callback_t callback);
 /* Unregister a listener for lua */
 void cwc_signal_disconnect_lua(const char *name, lua_State *L, int idx);
 
+/* Register a listener that is notified at most once per object in a
+ * transaction no matter how many times the signal is emitted. The callback
+ * data is the object that emit the signal (see cwc_object_emit_signal_simple)
+ * or NULL if the signal is not emitted by an object.
+ */
+void cwc_signal_connect_deferred(const char *name, signal_callback_t callback);
+void cwc_signal_disconnect_deferred(const char *name,
+                                    signal_callback_t callback);
+
+/* lua variant of the deferred listener, the disconnect is done with
+ * cwc_signal_disconnect_lua.
+ */
+void cwc_signal_connect_lua_deferred(const char *name, lua_State *L, int idx);
+
+/* Run the queued deferred notification, called by the transaction */
+void cwc_signal_flush_deferred();
+
+/* Get the deferred counter of a signal or the total if name is NULL, return
+ * false if the signal doesn't exist.
+ */
+bool cwc_signal_get_deferred_stats(const char *name,
+                                   struct cwc_signal_deferred_stats *stats);
+
 /* Notify signal for C listener only */
 void cwc_signal_emit_c(const char *name, void *data);
 
 /* notify for lua listener only */
 void cwc_signal_emit_lua(const char *name, lua_State *L, int nargs);
 
+/* the emit function that take a name is a no-op for a signal that is never
+ * interned (connected, subscribed, or emitted by id), the id variant is a
+ * no-op for CWC_SIGNAL_INVALID.
+ */
+void cwc_signal_emit_c_id(cwc_signal_id_t id, void *data);
+
 /** Notify listener for both C and lua side
  *
  * \param name Signal name
@@ -49,6 +144,14 @@ void cwc_signal_emit_lua(const char *name, lua_State *L, int nargs);
  * \param n Length of element to pass to the lua callback
  */
 void cwc_signal_emit(const char *name, void *data, lua_State *L, int nargs);
+void cwc_signal_emit_id(cwc_signal_id_t id,
+                        void *data,
+                        lua_State *L,
+                        int nargs);
+
+/* Forward the signal to the ipc client, every subscribe need an unsubscribe */
+void cwc_signal_ipc_subscribe(const char *name);
+void cwc_signal_ipc_unsubscribe(const char *name);
 
 /* only for reloading lua config */
 struct cwc_hhmap;
@@ -62,11 +165,18 @@ void cwc_lua_signal_clear(struct cwc_hhmap *map);
 int cwc_object_emit_signal_simple(const char *name,
                                   lua_State *L,
                                   void *pointer);
+int cwc_object_emit_signal_simple_id(cwc_signal_id_t id,
+                                     lua_State *L,
+                                     void *pointer);
 
 /* the C listener data arg is a list of what is passed as by the varargs ... */
 void cwc_object_emit_signal_varr(const char *name,
                                  lua_State *L,
                                  int nargs,
                                  ...);
+void cwc_object_emit_signal_varr_id(cwc_signal_id_t id,
+                                    lua_State *L,
+                                    int nargs,
+                                    ...);
 
 #endif // !_CWC_SIGNAL_H
@@ -80,6 +80,16 @@ struct master_state {
     int column_count;
     double mwfact;
     struct layout_interface *current_layout;
+
+    // tiled toplevels reused across arrange, NULL terminated
+    struct wl_array tiled; // struct cwc_toplevel *
+
+    /* tiled containers of the view in the output order, patched when a
+     * container change and rebuilt only when stale. Managed by master.c.
+     */
+    struct wl_array tiled_containers; // struct cwc_container *
+    tag_bitfield_t tiled_view;        // active tag when the cache is built
+    bool tiled_unsorted;              // patched out of the output order
 };
 
 /* contains information of a single view only tag or a traditional workspace */
@@ -90,6 +100,13 @@ struct cwc_tag_info {
     bool pending_transaction;
     bool hidden;
 
+    /* managed toplevel in this tag, maintained by
+     * cwc_toplevel_update_tag_stats so reading it doesn't walk the clients.
+     */
+    int client_count;
+    int urgent_count;
+    int focused_count;
+
     int useless_gaps;
     struct bsp_root_entry bsp_root_entry;
     struct master_state master_state;
@@ -86,6 +86,109 @@ void cwc_hhmap_nremove(struct cwc_hhmap *map, const void *key, int key_len);
 /* rehash(map->alloc) will reset the linked list */
 void __cwc_hhmap_rehash_to_size(struct cwc_hhmap *map, uint64_t new_size);
 
+/* imap or integer map is open addressing hash map for uint64_t and pointer key.
+ * Unlike hhmap the key is stored so collision is handled properly and no
+ * string hashing involved, the key only go through a cheap mixer.
+ *
+ * The slot metadata is stored separately as control bytes in group of
+ * CWC_IMAP_GROUP_WIDTH (swiss table style) containing 7 bit of the hash or the
+ * empty/deleted marker so that a whole group can be checked at once (with SSE2
+ * if available) before touching the entries.
+ */
+#define CWC_IMAP_GROUP_WIDTH 16
+
+struct cwc_imap_entry {
+    uint64_t key;
+    void *data;
+};
+
+struct cwc_imap {
+    /* filled entry count */
+    uint64_t size;
+
+    /* allocated length (in size, not bytes), always power of 2 */
+    uint64_t alloc;
+
+    /* insertion to empty slot left before the table need to be rehashed */
+    uint64_t growth_left;
+
+    /* control bytes, the high bit set mean the slot is empty or deleted */
+    uint8_t *ctrl;
+
+    /* pointer to the array of entry */
+    struct cwc_imap_entry *table;
+};
+
+/* if prealloc_size < 16 it will still 16 entries allocated */
+struct cwc_imap *cwc_imap_create(int prealloc_size);
+void cwc_imap_destroy(struct cwc_imap *map);
+
+/* insert or replace element */
+void cwc_imap_insert(struct cwc_imap *map, uint64_t key, void *data);
+
+/* return the saved inserted data, NULL if not found */
+void *cwc_imap_get(struct cwc_imap *map, uint64_t key);
+
+/* return the entry instead of data, NULL if not found */
+struct cwc_imap_entry *cwc_imap_get_entry(struct cwc_imap *map, uint64_t key);
+
+/* return true if the key existed */
+bool cwc_imap_remove(struct cwc_imap *map, uint64_t key);
+
+/* remove all element but keep the allocation */
+void cwc_imap_clear(struct cwc_imap *map);
+
+static inline bool cwc_imap_slot_is_full(struct cwc_imap *map, uint64_t idx)
+{
+    return !(map->ctrl[idx] & 0x80);
+}
+
+#define cwc_imap_pinsert(map, ptr, data) \
+    cwc_imap_insert(map, (uint64_t)(uintptr_t)(ptr), data)
+#define cwc_imap_pget(map, ptr) cwc_imap_get(map, (uint64_t)(uintptr_t)(ptr))
+#define cwc_imap_premove(map, ptr) \
+    cwc_imap_remove(map, (uint64_t)(uintptr_t)(ptr))
+
+/* strmap is the string key variant of imap. The key is copied and owned by
+ * the map so the stored key pointer can be used as an interned string, two
+ * equal string always return the same pointer from cwc_strmap_intern.
+ */
+struct cwc_strmap_entry {
+    char *key;
+    size_t key_len;
+    uint64_t hash;
+    void *data;
+};
+
+struct cwc_strmap {
+    uint64_t size;
+    uint64_t alloc;
+    uint64_t growth_left;
+    uint8_t *ctrl;
+    struct cwc_strmap_entry *table;
+};
+
+struct cwc_strmap *cwc_strmap_create(int prealloc_size);
+void cwc_strmap_destroy(struct cwc_strmap *map);
+
+void cwc_strmap_insert(struct cwc_strmap *map, const char *key, void *data);
+void *cwc_strmap_get(struct cwc_strmap *map, const char *key);
+struct cwc_strmap_entry *cwc_strmap_get_entry(struct cwc_strmap *map,
+                                              const char *key);
+bool cwc_strmap_remove(struct cwc_strmap *map, const char *key);
+
+/* return the canonical copy of the string owned by the map, the key is inserted
+ * with NULL data if it's not exist yet. The pointer is valid until the key is
+ * removed or the map destroyed.
+ */
+const char *cwc_strmap_intern(struct cwc_strmap *map, const char *key);
+
+static inline bool cwc_strmap_slot_is_full(struct cwc_strmap *map,
+                                           uint64_t idx)
+{
+    return !(map->ctrl[idx] & 0x80);
+}
+
 struct cwc_vec {
     /* element count */
     uint64_t count;
@@ -111,6 +214,69 @@ void cwc_vec_pop_at(struct cwc_vec *vec, size_t idx);
 void *cwc_vec_at(struct cwc_vec *vec, size_t idx);
 int cwc_vec_find(struct cwc_vec *vec, void *value);
 
+/* pool is a typed slab allocator for small fixed size object that is created
+ * and destroyed often (bsp node, keybind, signal callback, listener, etc.).
+ * Object is carved from slab of `slab_len` object and the freed object is
+ * kept in a free list for reuse. The slab is never given back to the system so
+ * config reload and window churn recycle the same memory instead of
+ * fragmenting the heap.
+ *
+ * The pool is statically initialized with CWC_POOL_INIT and registered on the
+ * first allocation so the stats can be listed with cwc_pool_for_each.
+ */
+struct cwc_pool_stats {
+    uint64_t live;   // allocated object currently in use
+    uint64_t peak;   // highest live count
+    uint64_t reuse;  // allocation served from the free list
+    uint64_t allocs; // total allocation
+    uint64_t slabs;  // slab count, multiply by slab_len for the capacity
+};
+
+struct cwc_pool {
+    const char *name;
+    size_t elem_size;
+    uint32_t slab_len;
+
+    void *free_list;
+    struct cwc_pool_slab *slabs; // newest first
+    uint32_t slab_used;          // carved object in the newest slab
+
+    struct cwc_pool_stats stats;
+    struct cwc_pool *next; // registered pool
+    bool registered;
+};
+
+#define CWC_POOL_INIT(NAME, TYPE, SLAB_LEN) \
+    {.name = (NAME), .elem_size = sizeof(TYPE), .slab_len = (SLAB_LEN)}
+
+/* define a static pool with typed PREFIX_alloc and PREFIX_free */
+#define CWC_POOL_DEFINE(PREFIX, TYPE, SLAB_LEN) \
+    static struct cwc_pool PREFIX##_pool =      \
+        CWC_POOL_INIT(#PREFIX, TYPE, SLAB_LEN); \
+    static inline TYPE *PREFIX##_alloc()        \
+    {                                           \
+        return cwc_pool_alloc(&PREFIX##_pool);  \
+    }                                           \
+    static inline void PREFIX##_free(TYPE *ptr) \
+    {                                           \
+        cwc_pool_free(&PREFIX##_pool, ptr);     \
+    }
+
+/* return zeroed object, NULL if out of memory */
+void *cwc_pool_alloc(struct cwc_pool *pool);
+
+/* no op for NULL like free */
+void cwc_pool_free(struct cwc_pool *pool, void *ptr);
+
+/* release every slab, all the object from the pool become invalid */
+void cwc_pool_fini(struct cwc_pool *pool);
+
+void cwc_pool_for_each(void (*fn)(struct cwc_pool *pool, void *data),
+                       void *data);
+
+/* wl_listener for LISTEN_CREATE */
+extern struct cwc_pool cwc_listener_pool;
+
 bool wl_list_length_at_least(struct wl_list *list, int more_than_or_equal_to);
 
 void wl_list_swap(struct wl_list *x, struct wl_list *y);
@@ -176,17 +342,17 @@ bool _cwc_assert(bool condition, const char *format, ...);
 #define MAX(A, B)            ((A) > (B) ? (A) : (B))
 #define CLAMP(val, min, max) MIN(MAX(val, min), max)
 #define LENGTH(X)            (sizeof X / sizeof X[0])
-#define LISTEN_CREATE(E, H)                           \
-    do {                                              \
-        struct wl_listener *_l = malloc(sizeof(*_l)); \
-        _l->notify             = (H);                 \
-        wl_signal_add((E), _l);                       \
+#define LISTEN_CREATE(E, H)                                          \
+    do {                                                             \
+        struct wl_listener *_l = cwc_pool_alloc(&cwc_listener_pool); \
+        _l->notify             = (H);                                \
+        wl_signal_add((E), _l);                                      \
     } while (0)
 
-#define LISTEN_DESTROY(L)           \
-    do {                            \
-        wl_list_remove(&(L)->link); \
-        free(L);                    \
+#define LISTEN_DESTROY(L)                       \
+    do {                                        \
+        wl_list_remove(&(L)->link);             \
+        cwc_pool_free(&cwc_listener_pool, (L)); \
     } while (0)
 
 static inline uint64_t timespec_to_msec(struct timespec *t)
@@ -1,3 +1,6 @@
+#include <stdbool.h>
+#include <stddef.h>
+
 struct cwc_server;
 struct cwc_input_manager;
 
@@ -41,5 +44,19 @@ extern void setup_transaction(struct cwc_server *s);
 extern void setup_ipc(struct cwc_server *s);
 extern void cleanup_ipc(struct cwc_server *s);
 
+/* queue the signal to the subscribed ipc client, the nargs argument is on top
+ * of the lua stack.
+ */
+struct lua_State;
+extern void
+ipc_signal_forward(const char *name, struct lua_State *L, int nargs);
+
+/* write the json snapshot of the object kind to buf, return false when the
+ * kind is unknown.
+ */
+struct ipc_buffer;
+extern bool
+ipc_query_snapshot(struct ipc_buffer *buf, const char *kind, size_t len);
+
 extern void setup_process(struct cwc_server *s);
 extern void cleanup_process(struct cwc_server *s);
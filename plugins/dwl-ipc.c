@@ -111,19 +111,11 @@ get_ipc_output_tag_state(struct cwc_output *cwc_o,
     if (cwc_o->state->active_tag & 1 << (tag->index - 1))
         state->state |= ZDWL_IPC_OUTPUT_V2_TAG_STATE_ACTIVE;
 
-    struct cwc_toplevel *toplevel;
-    wl_list_for_each(toplevel, &cwc_o->state->toplevels, link_output_toplevels)
-    {
-        if (toplevel->container->tag & 1 << (tag->index - 1)) {
-            state->clients++;
-
-            if (toplevel == cwc_toplevel_get_focused())
-                state->focused = true;
+    if (tag->urgent_count)
+        state->state |= ZDWL_IPC_OUTPUT_V2_TAG_STATE_URGENT;
 
-            if (cwc_toplevel_is_urgent(toplevel))
-                state->state |= ZDWL_IPC_OUTPUT_V2_TAG_STATE_URGENT;
-        }
-    }
+    state->clients = tag->client_count;
+    state->focused = tag->focused_count > 0;
 }
 
 static const char *get_layout_symbol(struct cwc_output *output)
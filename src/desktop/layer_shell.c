@@ -45,7 +45,8 @@ static void on_layer_surface_destroy(struct wl_listener *listener, void *data)
             lsurf->output, lsurf->wlr_layer_surface);
 
     lua_State *L = g_config_get_lua_State();
-    cwc_object_emit_signal_simple("layer_shell::destroy", L, lsurf);
+    cwc_object_emit_signal_simple_id(CWC_SIGNAL("layer_shell::destroy"), L,
+                                     lsurf);
     luaC_object_unregister(L, lsurf);
 
     wl_list_remove(&lsurf->link);
@@ -77,6 +78,22 @@ layer_shell_get_scene(struct cwc_output *output,
     return output->layers.bottom;
 }
 
+/* geometry state that affect the arrangement */
+#define ARRANGE_STATE_MASK                       \
+    (WLR_LAYER_SURFACE_V1_STATE_DESIRED_SIZE     \
+     | WLR_LAYER_SURFACE_V1_STATE_ANCHOR         \
+     | WLR_LAYER_SURFACE_V1_STATE_EXCLUSIVE_ZONE \
+     | WLR_LAYER_SURFACE_V1_STATE_MARGIN         \
+     | WLR_LAYER_SURFACE_V1_STATE_LAYER          \
+     | WLR_LAYER_SURFACE_V1_STATE_EXCLUSIVE_EDGE)
+
+static void layer_surface_invalidate(struct cwc_layer_surface *lsurf)
+{
+    lsurf->arranged.valid = false;
+    if (cwc_output_is_exist(lsurf->output))
+        lsurf->output->layers_dirty = true;
+}
+
 static void arrange_surface(struct cwc_output *output,
                             const struct wlr_box *full_area,
                             struct wlr_box *usable_area,
@@ -101,11 +118,25 @@ static void arrange_surface(struct cwc_output *output,
             != exclusive)
             continue;
 
+        // same input same result, only the exclusive zone need to be applied
+        if (surface->arranged.valid
+            && wlr_box_equal(&surface->arranged.full_area, full_area)
+            && wlr_box_equal(&surface->arranged.bounds, usable_area)) {
+            *usable_area = surface->arranged.usable;
+            continue;
+        }
+
+        surface->arranged.full_area = *full_area;
+        surface->arranged.bounds    = *usable_area;
+
         wlr_scene_layer_surface_v1_configure(surface->scene_layer, full_area,
                                              usable_area);
         wlr_scene_node_set_position(&surface->popup_tree->node,
                                     surface->scene_layer->tree->node.x,
                                     surface->scene_layer->tree->node.y);
+
+        surface->arranged.usable = *usable_area;
+        surface->arranged.valid  = true;
     }
 }
 
@@ -132,6 +163,13 @@ void arrange_layers(struct cwc_output *output)
                                     &usable_area.height);
     const struct wlr_box full_area = usable_area;
 
+    if (!output->layers_dirty
+        && wlr_box_equal(&full_area, &output->layers_full_area))
+        return;
+
+    output->layers_dirty     = false;
+    output->layers_full_area = full_area;
+
     // clang-format off
     arrange_surface(output, &full_area, &usable_area, output->layers.overlay, true);
     arrange_surface(output, &full_area, &usable_area, output->layers.top, true);
@@ -149,8 +187,14 @@ void arrange_layers(struct cwc_output *output)
         transaction_schedule_tag(cwc_output_get_current_tag_info(output));
         cwc_output_maximized_toplevel_update(output);
     }
+}
 
-    // lazy implementation: just focus to newest exclusive
+/* the newest mapped exclusive surface take the keyboard, only updated when a
+ * surface is mapped, unmapped or change its keyboard interactivity.
+ */
+static void exclusive_keyboard_update(struct cwc_output *output)
+{
+    struct cwc_layer_surface *exclusive = NULL;
     struct cwc_layer_surface *lsurf;
     wl_list_for_each(lsurf, &server.layer_shells, link)
     {
@@ -159,12 +203,21 @@ void arrange_layers(struct cwc_output *output)
 
         if (lsurf->wlr_layer_surface->current.keyboard_interactive
             == ZWLR_LAYER_SURFACE_V1_KEYBOARD_INTERACTIVITY_EXCLUSIVE) {
-            keyboard_focus_surface(server.seat,
-                                   lsurf->wlr_layer_surface->surface);
-            server.seat->exclusive_kbd_interactive = lsurf;
+            exclusive = lsurf;
             break;
         }
     }
+
+    struct cwc_seat *seat = server.seat;
+    if (exclusive == seat->exclusive_kbd_interactive)
+        return;
+
+    // set first so the focus change listener doesn't pull it back
+    seat->exclusive_kbd_interactive = exclusive;
+    if (exclusive)
+        keyboard_focus_surface(seat, exclusive->wlr_layer_surface->surface);
+    else
+        cwc_output_focus_newest_focus_visible_toplevel(output);
 }
 
 static void on_layer_surface_map(struct wl_listener *listener, void *data)
@@ -174,14 +227,18 @@ static void on_layer_surface_map(struct wl_listener *listener, void *data)
     struct wlr_layer_surface_v1 *wlr_layer_surface =
         layer_surface->wlr_layer_surface;
 
+    layer_surface->mapped = true;
+    layer_surface_invalidate(layer_surface);
+    arrange_layers(layer_surface->output);
+
     if (wlr_layer_surface->current.keyboard_interactive
         && (wlr_layer_surface->current.layer
                 == ZWLR_LAYER_SHELL_V1_LAYER_OVERLAY
             || wlr_layer_surface->current.layer
-                   == ZWLR_LAYER_SHELL_V1_LAYER_TOP)) {
+                   == ZWLR_LAYER_SHELL_V1_LAYER_TOP))
         keyboard_focus_surface(server.seat, wlr_layer_surface->surface);
-        arrange_layers(layer_surface->output);
-    }
+
+    exclusive_keyboard_update(layer_surface->output);
 }
 
 static void on_layer_surface_unmap(struct wl_listener *listener, void *data)
@@ -190,16 +247,14 @@ static void on_layer_surface_unmap(struct wl_listener *listener, void *data)
         wl_container_of(listener, layer_surface, unmap_l);
 
     layer_surface->mapped = false;
-
-    if (layer_surface == server.seat->exclusive_kbd_interactive) {
-        server.seat->exclusive_kbd_interactive = NULL;
-        cwc_output_focus_newest_focus_visible_toplevel(layer_surface->output);
-    }
+    exclusive_keyboard_update(layer_surface->output);
 
     struct wlr_layer_surface_v1_state *state =
         &layer_surface->wlr_layer_surface->current;
-    if (state->exclusive_zone || state->exclusive_edge)
+    if (state->exclusive_zone > 0) {
+        layer_surface_invalidate(layer_surface);
         arrange_layers(layer_surface->output);
+    }
 }
 
 static void on_layer_surface_commit(struct wl_listener *listener, void *data)
@@ -222,11 +277,15 @@ static void on_layer_surface_commit(struct wl_listener *listener, void *data)
                                 output_layer);
     }
 
-    if (wlr_layer_surface->initial_commit || committed
-        || wlr_layer_surface->surface->mapped != layer_surface->mapped) {
-        layer_surface->mapped = wlr_layer_surface->surface->mapped;
+    // buffer only commit like a clock redraw doesn't touch the arrangement,
+    // the initial commit always need a configure
+    if (wlr_layer_surface->initial_commit || (committed & ARRANGE_STATE_MASK)) {
+        layer_surface_invalidate(layer_surface);
         arrange_layers(layer_surface->output);
     }
+
+    if (committed & WLR_LAYER_SURFACE_V1_STATE_KEYBOARD_INTERACTIVITY)
+        exclusive_keyboard_update(layer_surface->output);
 }
 
 static void on_new_surface(struct wl_listener *listener, void *data)
@@ -272,7 +331,7 @@ static void on_new_surface(struct wl_listener *listener, void *data)
 
     lua_State *L = g_config_get_lua_State();
     luaC_object_layer_shell_register(L, surf);
-    cwc_object_emit_signal_simple("layer_shell::new", L, surf);
+    cwc_object_emit_signal_simple_id(CWC_SIGNAL("layer_shell::new"), L, surf);
 }
 
 void setup_layer_shell(struct cwc_server *s)
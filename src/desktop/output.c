@@ -27,6 +27,7 @@
 #include <wlr/backend.h>
 #include <wlr/backend/headless.h>
 #include <wlr/types/wlr_alpha_modifier_v1.h>
+#include <wlr/types/wlr_compositor.h>
 #include <wlr/types/wlr_ext_workspace_v1.h>
 #include <wlr/types/wlr_foreign_toplevel_management_v1.h>
 #include <wlr/types/wlr_layer_shell_v1.h>
@@ -35,6 +36,7 @@
 #include <wlr/types/wlr_scene.h>
 #include <wlr/types/wlr_tearing_control_v1.h>
 #include <wlr/types/wlr_xdg_output_v1.h>
+#include <wlr/types/wlr_xdg_shell.h>
 
 #include "cwc/config.h"
 #include "cwc/desktop/idle.h"
@@ -42,6 +44,7 @@
 #include "cwc/desktop/output.h"
 #include "cwc/desktop/toplevel.h"
 #include "cwc/desktop/transaction.h"
+#include "cwc/input/cursor.h"
 #include "cwc/input/manager.h"
 #include "cwc/input/seat.h"
 #include "cwc/layout/bsp.h"
@@ -69,10 +72,11 @@ void cwc_output_focus(struct cwc_output *output)
     cwc_output_focus_newest_focus_visible_toplevel(output);
 
     lua_State *L = g_config_get_lua_State();
-    cwc_object_emit_signal_simple("screen::focus", L, output);
+    cwc_object_emit_signal_simple_id(CWC_SIGNAL("screen::focus"), L, output);
 
     if (unfocused_output)
-        cwc_object_emit_signal_simple("screen::unfocus", L, unfocused_output);
+        cwc_object_emit_signal_simple_id(CWC_SIGNAL("screen::unfocus"), L,
+                                         unfocused_output);
 }
 
 void cwc_output_tiling_layout_update(struct cwc_output *output, int workspace)
@@ -177,6 +181,7 @@ void cwc_output_restore(struct cwc_output *output,
         container->workspace = container->old_prop.workspace;
 
         container->old_prop = (struct old_output){0};
+        cwc_container_update_tag_stats(container);
     }
 
     struct cwc_toplevel *toplevel;
@@ -190,6 +195,7 @@ void cwc_output_restore(struct cwc_output *output,
         wl_list_reattach(&output->state->toplevels,
                          &toplevel->link_output_toplevels);
     }
+    cwc_output_lists_changed();
 
     /* update output for the layer shell */
     struct cwc_layer_surface *layer_surface;
@@ -201,6 +207,8 @@ void cwc_output_restore(struct cwc_output *output,
         }
     }
 
+    master_tiled_invalidate(output);
+
     /* reset pending_transaction state */
     for (int i = 0; i < MAX_WORKSPACE; i++) {
         struct cwc_tag_info *tag_info = &output->state->tag_info[i];
@@ -241,9 +249,8 @@ static inline void cwc_output_state_destroy(struct cwc_output_state *state)
     // free(state);
 }
 
-static void _output_configure_scene(struct cwc_output *output,
-                                    struct wlr_scene_node *node,
-                                    float opacity)
+static void _scene_node_apply_opacity(struct wlr_scene_node *node,
+                                      float opacity)
 {
     if (node->data) {
         struct cwc_container *container =
@@ -272,61 +279,152 @@ static void _output_configure_scene(struct cwc_output *output,
         struct wlr_scene_node *node;
         wl_list_for_each(node, &tree->children, link)
         {
-            _output_configure_scene(output, node, opacity);
+            _scene_node_apply_opacity(node, opacity);
         }
     }
 }
 
-static bool output_can_tear(struct cwc_output *output)
+void cwc_scene_node_update_opacity(struct wlr_scene_node *node)
 {
-    struct cwc_toplevel *toplevel = cwc_toplevel_get_focused();
+    float opacity = 1.0f;
 
-    if (!toplevel)
-        return false;
+    /* the opacity is inherited from the nearest container above the node */
+    struct wlr_scene_tree *parent;
+    for (parent = node->parent; parent; parent = parent->node.parent) {
+        if (!parent->node.data)
+            continue;
 
-    if (cwc_toplevel_is_allow_tearing(toplevel)
-        && cwc_output_is_allow_tearing(output))
-        return true;
+        struct cwc_container *container =
+            cwc_container_try_from_data_descriptor(parent->node.data);
+        if (container) {
+            opacity = container->opacity;
+            break;
+        }
+    }
 
-    return false;
+    _scene_node_apply_opacity(node, opacity);
 }
 
-static bool allow_render(struct cwc_output *output, struct timespec *now)
+/* find the scene subtree that display the surface, NULL if unknown */
+static struct wlr_scene_node *
+scene_node_try_from_wlr_surface(struct wlr_surface *surface)
 {
-    bool is_waiting = output->waiting_since.tv_sec;
-    if (is_waiting) {
-        uint64_t delta_waiting =
-            timespec_to_msec(now) - timespec_to_msec(&output->waiting_since);
+    struct wlr_surface *root = wlr_surface_get_root_surface(surface);
 
-        if (delta_waiting > 500) {
-            server.resize_count = -1;
-            goto reset;
-        }
+    struct wlr_xdg_popup *xdg_popup = wlr_xdg_popup_try_from_wlr_surface(root);
+    if (xdg_popup) {
+        struct cwc_popup *popup = xdg_popup->base->data;
+        if (popup && popup->scene_tree)
+            return &popup->scene_tree->node;
+
+        return NULL;
     }
 
-    if (server.resize_count > 0) {
-        if (!is_waiting)
-            clock_gettime(CLOCK_MONOTONIC, &output->waiting_since);
+    struct cwc_toplevel *toplevel = cwc_toplevel_try_from_wlr_surface(root);
+    if (toplevel)
+        return toplevel->surf_tree ? &toplevel->surf_tree->node : NULL;
 
-        return false;
+    struct wlr_layer_surface_v1 *layer_surface =
+        wlr_layer_surface_v1_try_from_wlr_surface(root);
+    if (layer_surface && layer_surface->data) {
+        struct cwc_layer_surface *lsurf = layer_surface->data;
+        return &lsurf->scene_layer->tree->node;
     }
 
-reset:
-    output->waiting_since.tv_sec = 0;
-    return true;
+    return NULL;
+}
+
+/* track alpha modifier multiplier of every surface so that the opacity is only
+ * reapplied when it's actually changed.
+ */
+struct surface_opacity_tracker {
+    struct wlr_surface *surface;
+    double multiplier; // negative mean never applied
+
+    struct wl_listener commit_l;
+    struct wl_listener destroy_l;
+};
+
+static void on_tracked_surface_commit(struct wl_listener *listener, void *data)
+{
+    struct surface_opacity_tracker *tracker =
+        wl_container_of(listener, tracker, commit_l);
+
+    const struct wlr_alpha_modifier_surface_v1_state *alpha_modifier_state =
+        wlr_alpha_modifier_v1_get_surface_state(tracker->surface);
+    double multiplier =
+        alpha_modifier_state ? alpha_modifier_state->multiplier : 1.0;
+
+    if (multiplier == tracker->multiplier)
+        return;
+
+    tracker->multiplier = multiplier;
+
+    struct wlr_scene_node *node =
+        scene_node_try_from_wlr_surface(tracker->surface);
+    if (node)
+        cwc_scene_node_update_opacity(node);
+    else
+        server.scene_opacity_dirty = true;
+}
+
+static void on_tracked_surface_destroy(struct wl_listener *listener,
+                                       void *data)
+{
+    struct surface_opacity_tracker *tracker =
+        wl_container_of(listener, tracker, destroy_l);
+
+    wl_list_remove(&tracker->commit_l.link);
+    wl_list_remove(&tracker->destroy_l.link);
+    free(tracker);
+}
+
+static void on_new_surface(struct wl_listener *listener, void *data)
+{
+    struct wlr_surface *surface = data;
+
+    struct surface_opacity_tracker *tracker = calloc(1, sizeof(*tracker));
+    if (!tracker) {
+        cwc_log(CWC_ERROR, "failed to allocate surface_opacity_tracker");
+        return;
+    }
+
+    tracker->surface    = surface;
+    tracker->multiplier = -1.0;
+
+    tracker->commit_l.notify  = on_tracked_surface_commit;
+    tracker->destroy_l.notify = on_tracked_surface_destroy;
+    wl_signal_add(&surface->events.commit, &tracker->commit_l);
+    wl_signal_add(&surface->events.destroy, &tracker->destroy_l);
+}
+
+static bool output_can_tear(struct cwc_output *output)
+{
+    struct cwc_toplevel *toplevel = cwc_toplevel_get_focused();
+
+    if (!toplevel)
+        return false;
+
+    if (cwc_toplevel_is_allow_tearing(toplevel)
+        && cwc_output_is_allow_tearing(output))
+        return true;
+
+    return false;
 }
 
 static void output_repaint(struct cwc_output *output,
-                           struct wlr_scene_output *scene_output,
-                           struct timespec *now)
+                           struct wlr_scene_output *scene_output)
 {
-    _output_configure_scene(output, &server.scene->tree.node, 1.0f);
+    if (server.scene_opacity_dirty) {
+        _scene_node_apply_opacity(&server.scene->tree.node, 1.0f);
+        server.scene_opacity_dirty = false;
+    }
 
     if (!wlr_scene_output_needs_frame(scene_output))
         return;
 
     bool can_tear = output_can_tear(output);
-    if (!allow_render(output, now) && !can_tear)
+    if (!transaction_output_ready(output) && !can_tear)
         return;
 
     struct wlr_output_state pending;
@@ -366,8 +464,10 @@ static void on_output_frame(struct wl_listener *listener, void *data)
     if (!scene_output)
         return;
 
+    cwc_cursor_flush_interactive(server.seat->cursor, output);
+
     clock_gettime(CLOCK_MONOTONIC, &now);
-    output_repaint(output, scene_output, &now);
+    output_repaint(output, scene_output);
 
     wlr_scene_output_send_frame_done(scene_output, &now);
 }
@@ -412,6 +512,7 @@ void cwc_output_rescue_toplevel_container(struct cwc_output *source,
         wl_list_reattach(target->state->toplevels.prev,
                          &toplevel->link_output_toplevels);
     }
+    cwc_output_lists_changed();
 }
 
 struct cwc_output *
@@ -485,8 +586,8 @@ static void on_output_destroy(struct wl_listener *listener, void *data)
 {
     struct cwc_output *output = wl_container_of(listener, output, destroy_l);
     cwc_output_state_save(output);
-    cwc_object_emit_signal_simple("screen::destroy", g_config_get_lua_State(),
-                                  output);
+    cwc_object_emit_signal_simple_id(CWC_SIGNAL("screen::destroy"),
+                                     g_config_get_lua_State(), output);
 
     cwc_log(CWC_INFO, "destroying output (%s): %p %p", output->wlr_output->name,
             output, output->wlr_output);
@@ -501,6 +602,7 @@ static void on_output_destroy(struct wl_listener *listener, void *data)
     wlr_ext_workspace_group_handle_v1_output_leave(
         output->state->ext_workspace_group, output->wlr_output);
     wlr_output_state_finish(&output->pending);
+    transaction_cancel_output(output);
     output_layers_fini(output);
     wlr_scene_output_destroy(output->scene_output);
 
@@ -686,7 +788,8 @@ static struct cwc_output *cwc_output_create(struct wlr_output *wlr_output)
     output->output_layout_box.width  = wlr_output->width;
     output->output_layout_box.height = wlr_output->height;
 
-    output->usable_area = output->output_layout_box;
+    output->usable_area  = output->output_layout_box;
+    output->layers_dirty = true;
 
     if (cwc_output_state_try_restore(output))
         output->restored = true;
@@ -772,8 +875,8 @@ static void on_new_output(struct wl_listener *listener, void *data)
     transaction_schedule_tag(cwc_output_get_current_tag_info(output));
 
     luaC_object_screen_register(g_config_get_lua_State(), output);
-    cwc_object_emit_signal_simple("screen::new", g_config_get_lua_State(),
-                                  output);
+    cwc_object_emit_signal_simple_id(CWC_SIGNAL("screen::new"),
+                                     g_config_get_lua_State(), output);
 
     if (wl_list_length(&server.outputs) == 1)
         cwc_output_focus(output);
@@ -964,6 +1067,10 @@ static void on_ext_workspace_manager_commit(struct wl_listener *listener,
 
 void setup_output(struct cwc_server *s)
 {
+    // opacity tracking of the surface for alpha modifier
+    s->new_surface_l.notify = on_new_surface;
+    wl_signal_add(&s->compositor->events.new_surface, &s->new_surface_l);
+
     // wlr output layout
     s->output_layout                 = wlr_output_layout_create(s->wl_display);
     s->output_layout_change_l.notify = on_output_layout_change;
@@ -1011,6 +1118,8 @@ void setup_output(struct cwc_server *s)
 
 void cleanup_output(struct cwc_server *s)
 {
+    wl_list_remove(&s->new_surface_l.link);
+
     wl_list_remove(&s->new_output_l.link);
 
     wl_list_remove(&s->output_layout_change_l.link);
@@ -1073,6 +1182,11 @@ void cwc_output_update_visible(struct cwc_output *output)
         cwc_output_focus_newest_focus_visible_toplevel(output);
 }
 
+void cwc_output_lists_changed()
+{
+    server.list_generation++;
+}
+
 struct cwc_output *cwc_output_get_focused()
 {
     return server.focused_output;
@@ -1299,16 +1413,20 @@ void cwc_output_set_view_only(struct cwc_output *output, int workspace)
     else
         output->state->active_tag = 0;
     output->state->active_workspace = workspace;
+    cwc_output_lists_changed();
 
     transaction_schedule_tag(cwc_output_get_current_tag_info(output));
     transaction_schedule_output(output);
     cwc_output_update_ext_workspace_state(output);
 
     lua_State *L = g_config_get_lua_State();
-    cwc_object_emit_signal_simple("screen::prop::active_tag", L, output);
-    cwc_object_emit_signal_simple("screen::prop::active_workspace", L, output);
-    cwc_object_emit_signal_simple("screen::prop::selected_tag", L,
-                                  cwc_output_get_current_tag_info(output));
+    cwc_object_emit_signal_simple_id(CWC_SIGNAL("screen::prop::active_tag"), L,
+                                     output);
+    cwc_object_emit_signal_simple_id(
+        CWC_SIGNAL("screen::prop::active_workspace"), L, output);
+    cwc_object_emit_signal_simple_id(CWC_SIGNAL("screen::prop::selected_tag"),
+                                     L,
+                                     cwc_output_get_current_tag_info(output));
 }
 
 void cwc_output_set_active_tag(struct cwc_output *output, tag_bitfield_t newtag)
@@ -1320,12 +1438,13 @@ void cwc_output_set_active_tag(struct cwc_output *output, tag_bitfield_t newtag)
         output->state->active_workspace = cwc_tag_find_first_tag(newtag);
 
     output->state->active_tag = newtag;
+    cwc_output_lists_changed();
     transaction_schedule_output(output);
     transaction_schedule_tag(cwc_output_get_current_tag_info(output));
     cwc_output_update_ext_workspace_state(output);
 
-    cwc_object_emit_signal_simple("screen::prop::active_tag",
-                                  g_config_get_lua_State(), output);
+    cwc_object_emit_signal_simple_id(CWC_SIGNAL("screen::prop::active_tag"),
+                                     g_config_get_lua_State(), output);
 }
 
 static void restore_floating_box_for_all(struct cwc_output *output)
@@ -1358,6 +1477,7 @@ void cwc_output_set_layout_mode(struct cwc_output *output,
     if (tag->layout_mode != mode) {
         changed          = true;
         tag->layout_mode = mode;
+        master_tiled_invalidate(output);
     }
 
     switch (mode) {
@@ -1373,8 +1493,8 @@ void cwc_output_set_layout_mode(struct cwc_output *output,
 
     transaction_schedule_tag(cwc_output_get_tag(output, workspace));
     if (changed) {
-        cwc_object_emit_signal_simple("tag::prop::layout_mode",
-                                      g_config_get_lua_State(), tag);
+        cwc_object_emit_signal_simple_id(CWC_SIGNAL("tag::prop::layout_mode"),
+                                         g_config_get_lua_State(), tag);
     }
 }
 
@@ -1479,8 +1599,8 @@ void cwc_tag_info_set_label(struct cwc_tag_info *tag, const char *label)
     if (tag->ext_workspace)
         wlr_ext_workspace_handle_v1_set_name(tag->ext_workspace, label);
 
-    cwc_object_emit_signal_simple("tag::prop::label", g_config_get_lua_State(),
-                                  tag);
+    cwc_object_emit_signal_simple_id(CWC_SIGNAL("tag::prop::label"),
+                                     g_config_get_lua_State(), tag);
 }
 
 void cwc_tag_info_set_hidden(struct cwc_tag_info *tag, bool set)
@@ -1492,6 +1612,6 @@ void cwc_tag_info_set_hidden(struct cwc_tag_info *tag, bool set)
     if (tag->ext_workspace)
         wlr_ext_workspace_handle_v1_set_hidden(tag->ext_workspace, set);
 
-    cwc_object_emit_signal_simple("tag::prop::hidden", g_config_get_lua_State(),
-                                  tag);
+    cwc_object_emit_signal_simple_id(CWC_SIGNAL("tag::prop::hidden"),
+                                     g_config_get_lua_State(), tag);
 }
@@ -21,8 +21,11 @@
 #include <lua.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <wayland-server-core.h>
 #include <wayland-util.h>
+#include <wlr/interfaces/wlr_ext_image_capture_source_v1.h>
+#include <wlr/render/drm_format_set.h>
 #include <wlr/types/wlr_ext_foreign_toplevel_list_v1.h>
 #include <wlr/types/wlr_ext_image_capture_source_v1.h>
 #include <wlr/types/wlr_ext_image_copy_capture_v1.h>
@@ -45,6 +48,7 @@
 #include "cwc/desktop/layer_shell.h"
 #include "cwc/desktop/output.h"
 #include "cwc/desktop/toplevel.h"
+#include "cwc/desktop/transaction.h"
 #include "cwc/input/cursor.h"
 #include "cwc/input/keyboard.h"
 #include "cwc/input/seat.h"
@@ -118,10 +122,74 @@ static void on_foreign_destroy(struct wl_listener *listener, void *data)
     wl_list_remove(&toplevel->foreign_destroy_l.link);
 }
 
-static void _init_capture_scene(struct cwc_toplevel *toplevel)
+#ifdef CWC_XWAYLAND
+static void _capture_scene_attach_unmanaged(struct cwc_toplevel *toplevel,
+                                            struct cwc_toplevel *parent)
 {
-    toplevel->capture_scene                            = wlr_scene_create();
-    toplevel->capture_scene->restack_xwayland_surfaces = false;
+    toplevel->capture_scene_tree = wlr_scene_subsurface_tree_create(
+        parent->capture_scene_tree, toplevel->xwsurface->surface);
+    wlr_scene_node_set_position(
+        &toplevel->capture_scene_tree->node,
+        toplevel->container->tree->node.x - parent->container->tree->node.x,
+        toplevel->container->tree->node.y - parent->container->tree->node.y);
+}
+#endif /* ifdef CWC_XWAYLAND */
+
+/* mirror the popups that already exist when the capture scene is created
+ * lazily, pass NULL parent to forget them when the scene is gone.
+ */
+static void _capture_scene_sync_popups(struct wlr_xdg_surface *xdg_surface,
+                                       struct wlr_scene_tree *parent)
+{
+    struct wlr_xdg_popup *xdg_popup;
+    wl_list_for_each(xdg_popup, &xdg_surface->popups, link)
+    {
+        struct cwc_popup *popup = xdg_popup->base->data;
+        if (!popup || !popup->scene_tree)
+            continue;
+
+        popup->capture_scene_tree =
+            parent ? wlr_scene_xdg_surface_create(parent, xdg_popup->base)
+                   : NULL;
+        _capture_scene_sync_popups(xdg_popup->base,
+                                   popup->capture_scene_tree);
+    }
+}
+
+static void _capture_scene_sync_children(struct cwc_toplevel *toplevel,
+                                         bool attach)
+{
+#ifdef CWC_XWAYLAND
+    if (cwc_toplevel_is_x11(toplevel)) {
+        struct cwc_toplevel *child;
+        wl_list_for_each(child, &server.toplevels, link)
+        {
+            if (!cwc_toplevel_is_unmanaged(child)
+                || child->xwsurface->parent != toplevel->xwsurface)
+                continue;
+
+            if (!attach)
+                child->capture_scene_tree = NULL;
+            else if (cwc_toplevel_is_mapped(child))
+                _capture_scene_attach_unmanaged(child, toplevel);
+        }
+        return;
+    }
+#endif /* ifdef CWC_XWAYLAND */
+
+    _capture_scene_sync_popups(toplevel->xdg_toplevel->base,
+                               attach ? toplevel->capture_scene_tree : NULL);
+}
+
+/* The capture scene is a second scene graph with a copy of the toplevel
+ * surface tree, every commit has to update it too so the copy only exist
+ * while someone capturing the toplevel. The scene root itself stay until unmap
+ * since the capture source handed to the client is bound to it.
+ */
+static void _init_capture_scene_content(struct cwc_toplevel *toplevel)
+{
+    if (toplevel->capture_scene_tree)
+        return;
 
 #ifdef CWC_XWAYLAND
     if (cwc_toplevel_is_x11(toplevel)) {
@@ -134,11 +202,49 @@ static void _init_capture_scene(struct cwc_toplevel *toplevel)
         toplevel->capture_scene_tree = wlr_scene_xdg_surface_create(
             &toplevel->capture_scene->tree, toplevel->xdg_toplevel->base);
     }
+
+    _capture_scene_sync_children(toplevel, true);
+    server.capture_scene_count++;
+}
+
+static void _fini_capture_scene_content(struct cwc_toplevel *toplevel)
+{
+    if (!toplevel->capture_scene_tree)
+        return;
+
+    _capture_scene_sync_children(toplevel, false);
+
+    struct wlr_scene_tree *tree  = toplevel->capture_scene_tree;
+    toplevel->capture_scene_tree = NULL;
+    wlr_scene_node_destroy(&tree->node);
+
+    server.capture_scene_count--;
+}
+
+static void _init_capture_scene(struct cwc_toplevel *toplevel)
+{
+    toplevel->capture_scene                            = wlr_scene_create();
+    toplevel->capture_scene->restack_xwayland_surfaces = false;
+
+    _init_capture_scene_content(toplevel);
 }
 
 static void _fini_capture_scene(struct cwc_toplevel *toplevel)
 {
-    wlr_scene_node_destroy(&toplevel->capture_scene->tree.node);
+    if (!toplevel->capture_scene)
+        return;
+
+    if (toplevel->capture_teardown_idle) {
+        wl_event_source_remove(toplevel->capture_teardown_idle);
+        toplevel->capture_teardown_idle = NULL;
+    }
+
+    _fini_capture_scene_content(toplevel);
+
+    // the scene node capture source destroy itself along with the node
+    struct wlr_scene *scene = toplevel->capture_scene;
+    toplevel->capture_scene = NULL;
+    wlr_scene_node_destroy(&scene->tree.node);
 }
 
 static inline void _init_mapped_managed_toplevel(struct cwc_toplevel *toplevel)
@@ -148,6 +254,8 @@ static inline void _init_mapped_managed_toplevel(struct cwc_toplevel *toplevel)
 
     wl_list_insert(&server.focused_output->state->toplevels,
                    &toplevel->link_output_toplevels);
+    cwc_toplevel_update_tag_stats(toplevel);
+    cwc_output_lists_changed();
     if (!cwc_toplevel_is_floating(toplevel))
         cwc_toplevel_set_tiled(toplevel, WLR_EDGE_TOP | WLR_EDGE_BOTTOM
                                              | WLR_EDGE_LEFT | WLR_EDGE_RIGHT);
@@ -193,8 +301,6 @@ static inline void _init_mapped_managed_toplevel(struct cwc_toplevel *toplevel)
                   &toplevel->foreign_request_close_l);
     wl_signal_add(&toplevel->wlr_foreign_handle->events.destroy,
                   &toplevel->foreign_destroy_l);
-
-    _init_capture_scene(toplevel);
 }
 
 static inline void _fini_unmap_managed_toplevel(struct cwc_toplevel *toplevel)
@@ -203,6 +309,8 @@ static inline void _fini_unmap_managed_toplevel(struct cwc_toplevel *toplevel)
         return;
 
     wl_list_remove(&toplevel->link_output_toplevels);
+    cwc_toplevel_update_tag_stats(toplevel);
+    cwc_output_lists_changed();
 
     if (toplevel->wlr_foreign_handle) {
         wlr_foreign_toplevel_handle_v1_destroy(toplevel->wlr_foreign_handle);
@@ -263,17 +371,8 @@ static void _init_mapped_unmanaged_toplevel(struct cwc_toplevel *toplevel)
     struct wlr_xwayland_surface *parent = toplevel->xwsurface->parent;
     if (parent) {
         struct cwc_toplevel *parent_toplevel = parent->data;
-        if (parent_toplevel->capture_scene_tree) {
-            toplevel->capture_scene_tree = wlr_scene_subsurface_tree_create(
-                parent_toplevel->capture_scene_tree,
-                toplevel->xwsurface->surface);
-            wlr_scene_node_set_position(
-                &toplevel->capture_scene_tree->node,
-                toplevel->container->tree->node.x
-                    - parent_toplevel->container->tree->node.x,
-                toplevel->container->tree->node.y
-                    - parent_toplevel->container->tree->node.y);
-        }
+        if (parent_toplevel->capture_scene_tree)
+            _capture_scene_attach_unmanaged(toplevel, parent_toplevel);
     }
 }
 
@@ -310,9 +409,10 @@ static void on_surface_map(struct wl_listener *listener, void *data)
 
     lua_State *L = g_config_get_lua_State();
     if (toplevel->urgent)
-        cwc_object_emit_signal_simple("client::prop::urgent", L, toplevel);
+        cwc_object_emit_signal_simple_id(CWC_SIGNAL("client::prop::urgent"), L,
+                                         toplevel);
 
-    cwc_object_emit_signal_simple("client::map", L, toplevel);
+    cwc_object_emit_signal_simple_id(CWC_SIGNAL("client::map"), L, toplevel);
 
     _decide_should_tiled_part2(toplevel);
 }
@@ -334,11 +434,14 @@ static void on_surface_unmap(struct wl_listener *listener, void *data)
     _fini_unmap_unmanaged_toplevel(toplevel);
 
     toplevel->mapped = false;
-    cwc_object_emit_signal_simple("client::unmap", g_config_get_lua_State(),
-                                  toplevel);
+    cwc_object_emit_signal_simple_id(CWC_SIGNAL("client::unmap"),
+                                     g_config_get_lua_State(), toplevel);
 
     // some toplevel lua property depends on the container so remove it last
     cwc_container_remove_toplevel(toplevel);
+
+    // don't hold the output for a configure that will never be acked
+    transaction_cancel_configure(toplevel);
 }
 
 static void _surface_initial_commit(struct cwc_toplevel *toplevel)
@@ -365,12 +468,13 @@ static void on_surface_commit(struct wl_listener *listener, void *data)
         return;
     }
 
-    if (toplevel->resize_serial
-        && toplevel->resize_serial
-               <= toplevel->xdg_toplevel->base->current.configure_serial) {
-        server.resize_count--;
-        toplevel->resize_serial = 0;
-    }
+    transaction_configure_acked(
+        toplevel, toplevel->xdg_toplevel->base->current.configure_serial);
+
+    // the grabbed client is ready for the next interactive resize
+    struct cwc_cursor *cursor = server.seat->cursor;
+    if (cursor->grabbed_toplevel == toplevel && cursor->interactive_dirty)
+        wlr_output_schedule_frame(container->output->wlr_output);
 
     /* nothing to do when geometry is unchanged */
     struct wlr_box geom = cwc_toplevel_get_geometry(toplevel);
@@ -479,7 +583,10 @@ static void on_toplevel_destroy(struct wl_listener *listener, void *data)
             cwc_toplevel_get_title(toplevel), toplevel);
 
     lua_State *L = g_config_get_lua_State();
-    cwc_object_emit_signal_simple("client::destroy", L, toplevel);
+    cwc_object_emit_signal_simple_id(CWC_SIGNAL("client::destroy"), L,
+                                     toplevel);
+
+    transaction_cancel_configure(toplevel);
 
     wl_list_remove(&toplevel->link);
     wl_list_remove(&toplevel->destroy_l.link);
@@ -539,8 +646,8 @@ static void on_set_title(struct wl_listener *listener, void *data)
         wlr_foreign_toplevel_handle_v1_set_title(toplevel->wlr_foreign_handle,
                                                  title);
 
-    cwc_object_emit_signal_simple("client::prop::title",
-                                  g_config_get_lua_State(), toplevel);
+    cwc_object_emit_signal_simple_id(CWC_SIGNAL("client::prop::title"),
+                                     g_config_get_lua_State(), toplevel);
 }
 
 static void on_set_app_id(struct wl_listener *listener, void *data)
@@ -555,8 +662,8 @@ static void on_set_app_id(struct wl_listener *listener, void *data)
         wlr_foreign_toplevel_handle_v1_set_app_id(toplevel->wlr_foreign_handle,
                                                   app_id);
 
-    cwc_object_emit_signal_simple("client::prop::appid",
-                                  g_config_get_lua_State(), toplevel);
+    cwc_object_emit_signal_simple_id(CWC_SIGNAL("client::prop::appid"),
+                                     g_config_get_lua_State(), toplevel);
 }
 
 /* shared stuff between toplevel for xwayland and xdg_toplevel */
@@ -614,7 +721,7 @@ static void cwc_toplevel_init_common_stuff(struct cwc_toplevel *toplevel)
 
     lua_State *L = g_config_get_lua_State();
     luaC_object_client_register(L, toplevel);
-    cwc_object_emit_signal_simple("client::new", L, toplevel);
+    cwc_object_emit_signal_simple_id(CWC_SIGNAL("client::new"), L, toplevel);
 }
 
 static void on_new_xdg_toplevel(struct wl_listener *listener, void *data)
@@ -715,6 +822,7 @@ create_popup:
     popup->scene_tree =
         wlr_scene_xdg_surface_create(parent_stree, xdg_popup->base);
     popup->scene_tree->node.data = popup;
+    cwc_scene_node_update_opacity(&popup->scene_tree->node);
 
     if (parent_stree_capture)
         popup->capture_scene_tree =
@@ -778,6 +886,229 @@ static void on_activation_request_activate(struct wl_listener *listener,
     }
 }
 
+/* wlroots doesn't tell when a capture session start or end, the source handed
+ * to the client is our own implementation that forward everything to the
+ * scene node source and count the session on the way.
+ */
+struct cwc_capture_source {
+    struct wlr_ext_image_capture_source_v1 base;
+    struct wlr_ext_image_capture_source_v1 *scene_source;
+    struct cwc_toplevel *toplevel;
+
+    struct wl_listener scene_constraints_update_l;
+    struct wl_listener scene_frame_l;
+    struct wl_listener scene_destroy_l;
+};
+
+static inline struct cwc_capture_source *
+capture_source_from_base(struct wlr_ext_image_capture_source_v1 *base)
+{
+    struct cwc_capture_source *source = wl_container_of(base, source, base);
+    return source;
+}
+
+static void capture_scene_teardown_idle(void *data)
+{
+    struct cwc_toplevel *toplevel   = data;
+    toplevel->capture_teardown_idle = NULL;
+
+    if (toplevel->capture_session_count)
+        return;
+
+    // the client may start another session on the same source, keep it
+    cwc_log(CWC_DEBUG, "clearing idle capture scene for toplevel: %p",
+            toplevel);
+    _fini_capture_scene_content(toplevel);
+}
+
+static void capture_source_start(struct wlr_ext_image_capture_source_v1 *base,
+                                 bool with_cursors)
+{
+    struct cwc_capture_source *source = capture_source_from_base(base);
+    struct cwc_toplevel *toplevel     = source->toplevel;
+
+    toplevel->capture_session_count++;
+    if (toplevel->capture_teardown_idle) {
+        wl_event_source_remove(toplevel->capture_teardown_idle);
+        toplevel->capture_teardown_idle = NULL;
+    }
+
+    _init_capture_scene_content(toplevel);
+
+    source->scene_source->impl->start(source->scene_source, with_cursors);
+}
+
+static void capture_source_stop(struct wlr_ext_image_capture_source_v1 *base)
+{
+    struct cwc_capture_source *source = capture_source_from_base(base);
+    struct cwc_toplevel *toplevel     = source->toplevel;
+
+    // sessions are stopped by the finish in on_scene_source_destroy
+    if (source->scene_source)
+        source->scene_source->impl->stop(source->scene_source);
+
+    if (!toplevel->capture_session_count)
+        return;
+
+    // the source is still in use by the caller so clear it later
+    if (--toplevel->capture_session_count == 0
+        && !toplevel->capture_teardown_idle)
+        toplevel->capture_teardown_idle = wl_event_loop_add_idle(
+            server.wl_event_loop, capture_scene_teardown_idle, toplevel);
+}
+
+static void
+capture_source_schedule_frame(struct wlr_ext_image_capture_source_v1 *base)
+{
+    struct wlr_ext_image_capture_source_v1 *scene_source =
+        capture_source_from_base(base)->scene_source;
+
+    if (scene_source->impl->schedule_frame)
+        scene_source->impl->schedule_frame(scene_source);
+}
+
+static void capture_source_copy_frame(
+    struct wlr_ext_image_capture_source_v1 *base,
+    struct wlr_ext_image_copy_capture_frame_v1 *dst_frame,
+    struct wlr_ext_image_capture_source_v1_frame_event *frame_event)
+{
+    struct wlr_ext_image_capture_source_v1 *scene_source =
+        capture_source_from_base(base)->scene_source;
+
+    scene_source->impl->copy_frame(scene_source, dst_frame, frame_event);
+}
+
+static struct wlr_ext_image_capture_source_v1_cursor *
+capture_source_get_pointer_cursor(struct wlr_ext_image_capture_source_v1 *base,
+                                  struct wlr_seat *seat)
+{
+    struct wlr_ext_image_capture_source_v1 *scene_source =
+        capture_source_from_base(base)->scene_source;
+
+    if (!scene_source->impl->get_pointer_cursor)
+        return NULL;
+
+    return scene_source->impl->get_pointer_cursor(scene_source, seat);
+}
+
+static const struct wlr_ext_image_capture_source_v1_interface
+    capture_source_impl = {
+        .start              = capture_source_start,
+        .stop               = capture_source_stop,
+        .schedule_frame     = capture_source_schedule_frame,
+        .copy_frame         = capture_source_copy_frame,
+        .get_pointer_cursor = capture_source_get_pointer_cursor,
+};
+
+/* copy the buffer constraints of the scene source, the source own its copy
+ * since wlr_ext_image_capture_source_v1_finish free them.
+ */
+static void capture_source_sync_constraints(struct cwc_capture_source *source)
+{
+    struct wlr_ext_image_capture_source_v1 *dst = &source->base;
+    struct wlr_ext_image_capture_source_v1 *src = source->scene_source;
+
+    dst->width  = src->width;
+    dst->height = src->height;
+
+    free(dst->shm_formats);
+    dst->shm_formats     = NULL;
+    dst->shm_formats_len = 0;
+    if (src->shm_formats_len) {
+        size_t size      = src->shm_formats_len * sizeof(*src->shm_formats);
+        dst->shm_formats = malloc(size);
+        if (dst->shm_formats) {
+            memcpy(dst->shm_formats, src->shm_formats, size);
+            dst->shm_formats_len = src->shm_formats_len;
+        }
+    }
+
+    dst->dmabuf_device = src->dmabuf_device;
+    wlr_drm_format_set_finish(&dst->dmabuf_formats);
+    wlr_drm_format_set_copy(&dst->dmabuf_formats, &src->dmabuf_formats);
+}
+
+static void on_scene_source_constraints_update(struct wl_listener *listener,
+                                               void *data)
+{
+    struct cwc_capture_source *source =
+        wl_container_of(listener, source, scene_constraints_update_l);
+
+    capture_source_sync_constraints(source);
+    wl_signal_emit_mutable(&source->base.events.constraints_update, NULL);
+}
+
+static void on_scene_source_frame(struct wl_listener *listener, void *data)
+{
+    struct cwc_capture_source *source =
+        wl_container_of(listener, source, scene_frame_l);
+
+    // the event is handed back to copy_frame which forward it as is
+    wl_signal_emit_mutable(&source->base.events.frame, data);
+}
+
+/* the scene source is destroyed along with the capture scene */
+static void on_scene_source_destroy(struct wl_listener *listener, void *data)
+{
+    struct cwc_capture_source *source =
+        wl_container_of(listener, source, scene_destroy_l);
+    struct cwc_toplevel *toplevel = source->toplevel;
+
+    wl_list_remove(&source->scene_constraints_update_l.link);
+    wl_list_remove(&source->scene_frame_l.link);
+    wl_list_remove(&source->scene_destroy_l.link);
+
+    source->scene_source = NULL;
+    wlr_ext_image_capture_source_v1_finish(&source->base);
+    free(source);
+
+    toplevel->wlr_capture_source    = NULL;
+    toplevel->capture_session_count = 0;
+
+    // no session left to stop, drop the mirrored content now
+    if (toplevel->capture_teardown_idle) {
+        wl_event_source_remove(toplevel->capture_teardown_idle);
+        toplevel->capture_teardown_idle = NULL;
+    }
+    _fini_capture_scene_content(toplevel);
+}
+
+static bool _init_capture_source(struct cwc_toplevel *toplevel)
+{
+    struct cwc_capture_source *source = calloc(1, sizeof(*source));
+    if (!source)
+        return false;
+
+    struct wlr_ext_image_capture_source_v1 *scene_source =
+        wlr_ext_image_capture_source_v1_create_with_scene_node(
+            &toplevel->capture_scene->tree.node, server.wl_event_loop,
+            server.allocator, server.renderer);
+    if (!scene_source) {
+        free(source);
+        return false;
+    }
+
+    wlr_ext_image_capture_source_v1_init(&source->base, &capture_source_impl);
+    source->scene_source = scene_source;
+    source->toplevel     = toplevel;
+    capture_source_sync_constraints(source);
+
+    source->scene_constraints_update_l.notify =
+        on_scene_source_constraints_update;
+    source->scene_frame_l.notify   = on_scene_source_frame;
+    source->scene_destroy_l.notify = on_scene_source_destroy;
+    wl_signal_add(&source->scene_source->events.constraints_update,
+                  &source->scene_constraints_update_l);
+    wl_signal_add(&source->scene_source->events.frame, &source->scene_frame_l);
+    wl_signal_add(&source->scene_source->events.destroy,
+                  &source->scene_destroy_l);
+
+    toplevel->wlr_capture_source    = &source->base;
+    toplevel->capture_session_count = 0;
+
+    return true;
+}
+
 static void on_toplevel_capture_source_new_request(struct wl_listener *listener,
                                                    void *data)
 {
@@ -785,13 +1116,12 @@ static void on_toplevel_capture_source_new_request(struct wl_listener *listener,
         *req                      = data;
     struct cwc_toplevel *toplevel = req->toplevel_handle->data;
 
-    if (!toplevel->wlr_capture_source) {
-        toplevel->wlr_capture_source =
-            wlr_ext_image_capture_source_v1_create_with_scene_node(
-                &toplevel->capture_scene->tree.node, server.wl_event_loop,
-                server.allocator, server.renderer);
-        if (!toplevel->wlr_capture_source)
-            return;
+    if (!toplevel->capture_scene)
+        _init_capture_scene(toplevel);
+
+    if (!toplevel->wlr_capture_source && !_init_capture_source(toplevel)) {
+        _fini_capture_scene(toplevel);
+        return;
     }
 
     wlr_ext_foreign_toplevel_image_capture_source_manager_v1_request_accept(
@@ -806,8 +1136,8 @@ static void on_xdg_toplevel_set_tag(struct wl_listener *listener, void *data)
     free(toplevel->xdg_tag);
     toplevel->xdg_tag = strdup(event->tag);
 
-    cwc_object_emit_signal_simple("client::prop::xdg_tag",
-                                  g_config_get_lua_State(), toplevel);
+    cwc_object_emit_signal_simple_id(CWC_SIGNAL("client::prop::xdg_tag"),
+                                     g_config_get_lua_State(), toplevel);
 }
 
 static void on_xdg_toplevel_set_description(struct wl_listener *listener,
@@ -819,8 +1149,8 @@ static void on_xdg_toplevel_set_description(struct wl_listener *listener,
     free(toplevel->xdg_description);
     toplevel->xdg_description = strdup(event->description);
 
-    cwc_object_emit_signal_simple("client::prop::xdg_desc",
-                                  g_config_get_lua_State(), toplevel);
+    cwc_object_emit_signal_simple_id(CWC_SIGNAL("client::prop::xdg_desc"),
+                                     g_config_get_lua_State(), toplevel);
 }
 
 void setup_xdg_shell(struct cwc_server *s)
@@ -879,9 +1209,13 @@ void cwc_toplevel_focus(struct cwc_toplevel *toplevel, bool raise)
     struct wlr_surface *wlr_surface  = cwc_toplevel_get_wlr_surface(toplevel);
     struct wlr_surface *prev_surface = seat->keyboard_state.focused_surface;
 
-    if (!cwc_toplevel_is_unmanaged(toplevel))
+    if (!cwc_toplevel_is_unmanaged(toplevel)
+        && toplevel->container->output->state->focus_stack.next
+               != &toplevel->container->link_output_fstack) {
         wl_list_reattach(&toplevel->container->output->state->focus_stack,
                          &toplevel->container->link_output_fstack);
+        cwc_output_lists_changed();
+    }
 
     if (wlr_surface == prev_surface)
         return;
@@ -1233,12 +1567,13 @@ void cwc_toplevel_swap(struct cwc_toplevel *source, struct cwc_toplevel *target)
     wl_list_swap(&source->link_output_toplevels,
                  &target->link_output_toplevels);
     wl_list_swap(&source->link, &target->link);
+    cwc_output_lists_changed();
 
     cwc_container_refresh(c_src);
     cwc_container_refresh(d_src);
 
-    cwc_object_emit_signal_varr("client::swap", g_config_get_lua_State(), 2,
-                                source, target);
+    cwc_object_emit_signal_varr_id(CWC_SIGNAL("client::swap"),
+                                   g_config_get_lua_State(), 2, source, target);
 }
 
 struct cwc_toplevel *
@@ -1568,8 +1903,55 @@ void cwc_toplevel_set_urgent(struct cwc_toplevel *toplevel, bool set)
         wlr_ext_workspace_handle_v1_set_urgent(tag->ext_workspace, set);
 
     toplevel->urgent = set;
-    cwc_object_emit_signal_simple("client::prop::urgent",
-                                  g_config_get_lua_State(), toplevel);
+    cwc_toplevel_update_tag_stats(toplevel);
+    cwc_object_emit_signal_simple_id(CWC_SIGNAL("client::prop::urgent"),
+                                     g_config_get_lua_State(), toplevel);
+}
+
+static void _tag_stats_apply(struct cwc_toplevel *toplevel, int delta)
+{
+    struct cwc_output_state *state = toplevel->tag_stats.state;
+    tag_bitfield_t tag             = toplevel->tag_stats.tag;
+
+    for (int i = 1; tag && i <= MAX_WORKSPACE; i++, tag >>= 1) {
+        if (!(tag & 1))
+            continue;
+
+        struct cwc_tag_info *tag_info = &state->tag_info[i];
+        tag_info->client_count += delta;
+        if (toplevel->tag_stats.urgent)
+            tag_info->urgent_count += delta;
+        if (toplevel->tag_stats.focused)
+            tag_info->focused_count += delta;
+    }
+}
+
+void cwc_toplevel_update_tag_stats(struct cwc_toplevel *toplevel)
+{
+    // only count what's in the output toplevel list
+    bool counted = toplevel->container && toplevel->link_output_toplevels.next;
+
+    struct cwc_output_state *state =
+        counted ? toplevel->container->output->state : NULL;
+    tag_bitfield_t tag = counted ? toplevel->container->tag : 0;
+    bool urgent        = counted && toplevel->urgent;
+    bool focused       = counted && toplevel == cwc_toplevel_get_focused();
+
+    if (toplevel->tag_stats.state == state && toplevel->tag_stats.tag == tag
+        && toplevel->tag_stats.urgent == urgent
+        && toplevel->tag_stats.focused == focused)
+        return;
+
+    if (toplevel->tag_stats.state)
+        _tag_stats_apply(toplevel, -1);
+
+    toplevel->tag_stats.state   = state;
+    toplevel->tag_stats.tag     = tag;
+    toplevel->tag_stats.urgent  = urgent;
+    toplevel->tag_stats.focused = focused;
+
+    if (state)
+        _tag_stats_apply(toplevel, 1);
 }
 
 void layout_coord_to_surface_coord(
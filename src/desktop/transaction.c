@@ -1,4 +1,4 @@
-/* transaction.c - actually just a simple scheduler
+/* transaction.c - layout scheduler and configure synchronization
  *
  * Copyright (C) 2025 Dwi Asmoro Bangun <dwiaceromo@gmail.com>
  *
@@ -19,10 +19,17 @@
 #include <stdio.h>
 #include <wayland-server-core.h>
 #include <wayland-util.h>
+#include <wlr/types/wlr_output.h>
 
 #include "cwc/desktop/layer_shell.h"
+#include "cwc/desktop/toplevel.h"
 #include "cwc/desktop/transaction.h"
 #include "cwc/server.h"
+#include "cwc/signal.h"
+#include "cwc/util.h"
+
+/* how long an output wait for a single client to ack its configure */
+#define CONFIGURE_TIMEOUT_MSEC 200
 
 static struct transaction {
     struct wl_event_source *idle_source;
@@ -30,8 +37,17 @@ static struct transaction {
     struct wl_array tags; // struct cwc_tag_info*
 
     bool output_pending;
+    bool signal_pending;
     bool paused;
     bool processing; // prevent scheduling loop
+
+    struct wl_list configure_waits; // cwc_toplevel.configure_wait.link
+
+    /* expire the configure wait, armed to the earliest deadline */
+    struct wl_event_source *configure_timer;
+    uint64_t timer_deadline; // 0 when disarmed
+
+    int sync_inhibitor;
 } T = {0};
 
 static inline void _process_pending_outputs(struct cwc_output *output)
@@ -87,6 +103,13 @@ static void process_pending(void *data)
 
     T.idle_source = NULL;
     T.processing  = false;
+
+    // last so the listener see the arranged state, anything the listener
+    // schedule goes to the next transaction
+    if (T.signal_pending) {
+        T.signal_pending = false;
+        cwc_signal_flush_deferred();
+    }
 }
 
 static void transaction_start()
@@ -135,7 +158,161 @@ void transaction_schedule_tag(struct cwc_tag_info *tag)
     transaction_start();
 }
 
+void transaction_schedule_signal()
+{
+    if (T.signal_pending)
+        return;
+
+    T.signal_pending = true;
+    if (!T.processing)
+        transaction_start();
+}
+
+/* The layout change is applied to the scene right away but the output doesn't
+ * present it until every visible client on it ack the configure sent by the
+ * layout, so the screen keep showing the last complete frame instead of a
+ * half-resized one. Each output only wait for its own clients and a client
+ * that doesn't respond within CONFIGURE_TIMEOUT_MSEC is dropped from the
+ * wait list.
+ */
+
+static void configure_timer_arm(uint64_t deadline)
+{
+    if (T.timer_deadline && T.timer_deadline <= deadline)
+        return;
+
+    uint64_t now     = get_current_time_msec();
+    T.timer_deadline = deadline;
+    wl_event_source_timer_update(T.configure_timer,
+                                 deadline > now ? deadline - now : 1);
+}
+
+static void configure_wait_remove(struct cwc_toplevel *toplevel)
+{
+    toplevel->configure_wait.output->configure_pending--;
+    toplevel->configure_wait.output = NULL;
+    toplevel->configure_wait.serial = 0;
+    wl_list_remove(&toplevel->configure_wait.link);
+}
+
+/* the frame held by the pending configure can be presented now */
+static void configure_wait_frame_if_ready(struct cwc_output *output)
+{
+    if (!output->configure_pending)
+        wlr_output_schedule_frame(output->wlr_output);
+}
+
+static void configure_wait_finish(struct cwc_toplevel *toplevel)
+{
+    struct cwc_output *output = toplevel->configure_wait.output;
+    configure_wait_remove(toplevel);
+    configure_wait_frame_if_ready(output);
+}
+
+static int on_configure_timeout(void *data)
+{
+    uint64_t now     = get_current_time_msec();
+    uint64_t next    = 0;
+    T.timer_deadline = 0;
+
+    struct cwc_toplevel *toplevel, *tmp;
+    wl_list_for_each_safe(toplevel, tmp, &T.configure_waits,
+                          configure_wait.link)
+    {
+        uint64_t deadline = toplevel->configure_wait.deadline;
+        if (deadline <= now) {
+            cwc_log(CWC_DEBUG, "configure timeout (%s): %p",
+                    cwc_toplevel_get_title(toplevel), toplevel);
+            configure_wait_finish(toplevel);
+        } else if (!next || deadline < next) {
+            next = deadline;
+        }
+    }
+
+    if (next)
+        configure_timer_arm(next);
+
+    return 0;
+}
+
+void transaction_wait_configure(struct cwc_toplevel *toplevel, uint32_t serial)
+{
+    if (T.sync_inhibitor || !serial || !toplevel->container)
+        return;
+
+    struct cwc_output *output = toplevel->container->output;
+
+    // the deadline isn't extended so a configure storm can't stall the output
+    struct cwc_output *old = toplevel->configure_wait.output;
+    if (!old) {
+        toplevel->configure_wait.deadline =
+            get_current_time_msec() + CONFIGURE_TIMEOUT_MSEC;
+        wl_list_insert(T.configure_waits.prev, &toplevel->configure_wait.link);
+        configure_timer_arm(toplevel->configure_wait.deadline);
+        output->configure_pending++;
+    } else if (old != output) {
+        // moved to another output, the old one may only wait for this one
+        old->configure_pending--;
+        configure_wait_frame_if_ready(old);
+        output->configure_pending++;
+    }
+
+    toplevel->configure_wait.serial = serial;
+    toplevel->configure_wait.output = output;
+}
+
+void transaction_configure_acked(struct cwc_toplevel *toplevel, uint32_t serial)
+{
+    if (toplevel->configure_wait.output
+        && toplevel->configure_wait.serial <= serial)
+        configure_wait_finish(toplevel);
+}
+
+void transaction_cancel_configure(struct cwc_toplevel *toplevel)
+{
+    if (toplevel->configure_wait.output)
+        configure_wait_finish(toplevel);
+}
+
+void transaction_cancel_output(struct cwc_output *output)
+{
+    struct cwc_toplevel *toplevel, *tmp;
+    wl_list_for_each_safe(toplevel, tmp, &T.configure_waits,
+                          configure_wait.link)
+    {
+        if (toplevel->configure_wait.output == output)
+            configure_wait_remove(toplevel);
+    }
+}
+
+bool transaction_output_ready(struct cwc_output *output)
+{
+    return !output->configure_pending;
+}
+
+void transaction_inhibit_sync()
+{
+    if (T.sync_inhibitor++)
+        return;
+
+    struct cwc_toplevel *toplevel, *tmp;
+    wl_list_for_each_safe(toplevel, tmp, &T.configure_waits,
+                          configure_wait.link)
+    {
+        configure_wait_finish(toplevel);
+    }
+}
+
+void transaction_uninhibit_sync()
+{
+    if (T.sync_inhibitor)
+        T.sync_inhibitor--;
+}
+
 void setup_transaction(struct cwc_server *s)
 {
     wl_array_init(&T.tags);
+    wl_list_init(&T.configure_waits);
+    T.configure_timer =
+        wl_event_loop_add_timer(s->wl_event_loop, on_configure_timeout, NULL);
 }
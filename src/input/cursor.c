@@ -143,42 +143,6 @@ static void process_cursor_move_floating(struct cwc_cursor *cursor)
                                 overlay_rect.y);
 }
 
-/* scheduling the resize will prevent the compositor flooding configure request.
- * While it is not a problem in wayland, it is an issue for xwayland windows in
- * my case it's chromium that has the issue.
- */
-static inline void schedule_resize(struct cwc_toplevel *toplevel,
-                                   struct cwc_cursor *cursor,
-                                   struct wlr_box *new_box)
-{
-    struct timespec now;
-    clock_gettime(CLOCK_MONOTONIC, &now);
-    int interval_msec = 8; // default to 120hz
-    int refresh_rate  = toplevel->container->output->wlr_output->refresh;
-    if (refresh_rate) {
-        refresh_rate /= 1000;
-        refresh_rate  = MAX(refresh_rate, 1);
-        interval_msec = 1000.0 / refresh_rate;
-    }
-
-    uint64_t delta_t_msec =
-        timespec_to_msec(&now) - cursor->last_resize_time_msec;
-
-    if (delta_t_msec > interval_msec) {
-        if (new_box) {
-            cwc_container_set_box_global(toplevel->container, new_box);
-            clock_gettime(CLOCK_MONOTONIC, &now);
-        } else {
-            transaction_schedule_tag(
-                cwc_output_get_current_tag_info(toplevel->container->output));
-        }
-
-        cursor->last_resize_time_msec = timespec_to_msec(&now);
-    } else if (new_box) {
-        cursor->pending_box = *new_box;
-    }
-}
-
 static void process_cursor_resize(struct cwc_cursor *cursor)
 {
     struct cwc_toplevel *toplevel = cursor->grabbed_toplevel;
@@ -219,14 +183,13 @@ static void process_cursor_resize(struct cwc_cursor *cursor)
         .height = new_bottom - new_top,
     };
 
-    schedule_resize(toplevel, cursor, &new_box);
+    cwc_container_set_box_global(toplevel->container, &new_box);
 }
 
 static void process_cursor_resize_bsp(struct cwc_cursor *cursor)
 {
-    struct cwc_toplevel *toplevel = cursor->grabbed_toplevel;
-    double cx                     = cursor->wlr_cursor->x;
-    double cy                     = cursor->wlr_cursor->y;
+    double cx = cursor->wlr_cursor->x;
+    double cy = cursor->wlr_cursor->y;
 
     double diff_x = cx - cursor->grab_x;
     double diff_y = cy - cursor->grab_y;
@@ -235,18 +198,17 @@ static void process_cursor_resize_bsp(struct cwc_cursor *cursor)
     struct bsp_node *horizontal = grab_bsp->horizontal;
     struct bsp_node *vertical   = grab_bsp->vertical;
 
+    // only the subtree below the fence get updated
     if (horizontal) {
         double newfact =
             grab_bsp->wfact_horizontal + diff_x / horizontal->width;
-        horizontal->left_wfact = CLAMP(newfact, 0.05, 0.95);
+        bsp_node_set_wfact(horizontal, CLAMP(newfact, 0.05, 0.95));
     }
 
     if (vertical) {
         double newfact = grab_bsp->wfact_vertical + diff_y / vertical->height;
-        vertical->left_wfact = CLAMP(newfact, 0.05, 0.95);
+        bsp_node_set_wfact(vertical, CLAMP(newfact, 0.05, 0.95));
     }
-
-    schedule_resize(toplevel, cursor, NULL);
 }
 
 static void process_cursor_resize_master(struct cwc_cursor *cursor)
@@ -255,6 +217,98 @@ static void process_cursor_resize_master(struct cwc_cursor *cursor)
     master_resize_update(output, cursor);
 }
 
+/* Interactive motion only mark the grab dirty, the geometry is applied once
+ * per frame of the grabbed output. Resize also wait until the grabbed client
+ * commit the previous configure so a slow client (e.g. chromium) doesn't get
+ * flooded, the latest pointer position is applied on the frame after the
+ * commit and when the grab end so the final size never get lost.
+ */
+#define INTERACTIVE_ACK_TIMEOUT_MSEC 100
+
+static inline bool cursor_state_is_resize(enum cwc_cursor_state state)
+{
+    return state == CWC_CURSOR_STATE_RESIZE
+           || state == CWC_CURSOR_STATE_RESIZE_BSP
+           || state == CWC_CURSOR_STATE_RESIZE_MASTER;
+}
+
+/* waiting for every configure ack would make resizing sluggish so the sync is
+ * inhibited for as long as the state is resize, whatever the state leave to.
+ */
+static void cursor_update_sync_inhibit(struct cwc_cursor *cursor)
+{
+    bool resizing = cursor_state_is_resize(cursor->state);
+    if (resizing == cursor->sync_inhibited)
+        return;
+
+    cursor->sync_inhibited = resizing;
+    if (resizing)
+        transaction_inhibit_sync();
+    else
+        transaction_uninhibit_sync();
+}
+
+static void schedule_interactive(struct cwc_cursor *cursor)
+{
+    cursor->interactive_dirty = true;
+    wlr_output_schedule_frame(
+        cursor->grabbed_toplevel->container->output->wlr_output);
+}
+
+static bool interactive_client_busy(struct cwc_cursor *cursor)
+{
+    struct cwc_toplevel *toplevel = cursor->grabbed_toplevel;
+
+    // xwayland has no configure serial, pacing by frame is all we can do
+    if (!cursor_state_is_resize(cursor->state)
+        || !cwc_toplevel_configure_pending(toplevel))
+        return false;
+
+    return get_current_time_msec() - cursor->last_configure_msec
+           < INTERACTIVE_ACK_TIMEOUT_MSEC;
+}
+
+static void apply_interactive(struct cwc_cursor *cursor)
+{
+    cursor->interactive_dirty   = false;
+    cursor->last_configure_msec = get_current_time_msec();
+
+    switch (cursor->state) {
+    case CWC_CURSOR_STATE_MOVE:
+        process_cursor_move_floating(cursor);
+        break;
+    case CWC_CURSOR_STATE_MOVE_MASTER:
+    case CWC_CURSOR_STATE_MOVE_BSP:
+        process_cursor_move(cursor);
+        break;
+    case CWC_CURSOR_STATE_RESIZE:
+        process_cursor_resize(cursor);
+        break;
+    case CWC_CURSOR_STATE_RESIZE_BSP:
+        process_cursor_resize_bsp(cursor);
+        break;
+    case CWC_CURSOR_STATE_RESIZE_MASTER:
+        process_cursor_resize_master(cursor);
+        break;
+    default:
+        break;
+    }
+}
+
+void cwc_cursor_flush_interactive(struct cwc_cursor *cursor,
+                                  struct cwc_output *output)
+{
+    if (!cursor->interactive_dirty
+        || cursor->grabbed_toplevel->container->output != output)
+        return;
+
+    // the commit of the grabbed client will schedule another frame
+    if (interactive_client_busy(cursor))
+        return;
+
+    apply_interactive(cursor);
+}
+
 static void cwc_cursor_unhide(struct cwc_cursor *cursor)
 {
     if (!cursor->hidden)
@@ -277,6 +331,10 @@ static inline void _send_pointer_move_signal(struct cwc_cursor *cursor,
                                              double dx_unaccel,
                                              double dy_unaccel)
 {
+    cwc_signal_id_t signal = CWC_SIGNAL("pointer::move");
+    if (!cwc_signal_prepare_emit(signal))
+        return;
+
     struct cwc_pointer_move_event event = {
         .cursor     = cursor,
         .dx         = dx,
@@ -292,7 +350,7 @@ static inline void _send_pointer_move_signal(struct cwc_cursor *cursor,
     lua_pushnumber(L, dy);
     lua_pushnumber(L, dx_unaccel);
     lua_pushnumber(L, dy_unaccel);
-    cwc_signal_emit("pointer::move", &event, L, 6);
+    cwc_signal_emit_id(signal, &event, L, 6);
 }
 
 void cwc_cursor_notify_activity(struct cwc_cursor *cursor)
@@ -309,40 +367,12 @@ static bool cwc_cursor_check_interactive(struct cwc_cursor *cursor,
                                          double dx,
                                          double dy)
 {
-    struct wlr_cursor *wlr_cursor = cursor->wlr_cursor;
-
-    switch (cursor->state) {
-    case CWC_CURSOR_STATE_MOVE:
-        wlr_cursor_move(wlr_cursor, device, dx, dy);
-        process_cursor_move_floating(cursor);
-        return true;
-    case CWC_CURSOR_STATE_MOVE_MASTER:
-    case CWC_CURSOR_STATE_MOVE_BSP:
-        wlr_cursor_move(wlr_cursor, device, dx, dy);
-        process_cursor_move(cursor);
-        return true;
-    case CWC_CURSOR_STATE_RESIZE:
-        // skip synchronization otherwise it'll make resizing sluggish
-        server.resize_count = -1e6;
-        wlr_cursor_move(wlr_cursor, device, dx, dy);
-        process_cursor_resize(cursor);
-        return true;
-    case CWC_CURSOR_STATE_RESIZE_BSP:
-        server.resize_count = -1e6;
-        wlr_cursor_move(wlr_cursor, device, dx, dy);
-        process_cursor_resize_bsp(cursor);
-        return true;
-    case CWC_CURSOR_STATE_RESIZE_MASTER:
-        server.resize_count = -1e6;
-        wlr_cursor_move(wlr_cursor, device, dx, dy);
-        process_cursor_resize_master(cursor);
-        return true;
-    default:
+    if (cursor->state == CWC_CURSOR_STATE_NORMAL)
         return false;
-        break;
-    };
 
-    unreachable_();
+    wlr_cursor_move(cursor->wlr_cursor, device, dx, dy);
+    schedule_interactive(cursor);
+    return true;
 }
 
 void process_cursor_motion(struct cwc_cursor *cursor,
@@ -367,11 +397,12 @@ void process_cursor_motion(struct cwc_cursor *cursor,
 
     if (cursor->last_output != output) {
         lua_State *L = g_config_get_lua_State();
-        cwc_object_emit_signal_simple("screen::mouse_enter", L, output);
+        cwc_object_emit_signal_simple_id(CWC_SIGNAL("screen::mouse_enter"), L,
+                                         output);
 
         if (cursor->last_output)
-            cwc_object_emit_signal_simple("screen::mouse_leave", L,
-                                          cursor->last_output);
+            cwc_object_emit_signal_simple_id(CWC_SIGNAL("screen::mouse_leave"),
+                                             L, cursor->last_output);
 
         cursor->last_output = output;
     }
@@ -473,11 +504,13 @@ static void _notify_mouse_signal(struct wlr_surface *old_surface,
 
     lua_State *L = g_config_get_lua_State();
     if (old && cwc_toplevel_is_mapped(old) && !cwc_toplevel_is_unmanaged(old)) {
-        cwc_object_emit_signal_simple("client::mouse_leave", L, old);
+        cwc_object_emit_signal_simple_id(CWC_SIGNAL("client::mouse_leave"), L,
+                                         old);
     }
 
     if (new && cwc_toplevel_is_mapped(new) && !cwc_toplevel_is_unmanaged(new)) {
-        cwc_object_emit_signal_simple("client::mouse_enter", L, new);
+        cwc_object_emit_signal_simple_id(CWC_SIGNAL("client::mouse_enter"), L,
+                                         new);
     }
 }
 
@@ -535,6 +568,10 @@ static inline void
 _send_pointer_axis_signal(struct cwc_cursor *cursor,
                           struct wlr_pointer_axis_event *event)
 {
+    cwc_signal_id_t signal = CWC_SIGNAL("pointer::axis");
+    if (!cwc_signal_prepare_emit(signal))
+        return;
+
     struct cwc_pointer_axis_event cwc_event = {
         .cursor = cursor,
         .event  = event,
@@ -547,7 +584,7 @@ _send_pointer_axis_signal(struct cwc_cursor *cursor,
     lua_pushboolean(L, event->orientation);
     lua_pushnumber(L, event->delta);
     lua_pushnumber(L, event->delta_discrete);
-    cwc_signal_emit("pointer::axis", &cwc_event, L, 5);
+    cwc_signal_emit_id(signal, &cwc_event, L, 5);
 }
 
 /* true means client shouldn't get notified */
@@ -649,6 +686,9 @@ void start_interactive_move(struct cwc_toplevel *toplevel)
     cursor->grab_y           = cy - toplevel->container->tree->node.y;
     cursor->grabbed_toplevel = toplevel;
     toplevel->container->state |= CONTAINER_STATE_MOVING;
+
+    // a resize grab may turn into a move
+    cursor_update_sync_inhibit(cursor);
 }
 
 /* geo_box is wlr_surface box */
@@ -694,8 +734,7 @@ static void start_interactive_resize_floating(struct cwc_cursor *cursor,
     struct cwc_toplevel *toplevel = cursor->grabbed_toplevel;
     struct wlr_box geo_box        = cwc_container_get_box(toplevel->container);
 
-    cursor->grab_float  = geo_box;
-    cursor->pending_box = geo_box;
+    cursor->grab_float = geo_box;
 
     double border_x =
         geo_box.x + ((edges & WLR_EDGE_RIGHT) ? geo_box.width : 0);
@@ -789,8 +828,7 @@ void start_interactive_resize(struct cwc_toplevel *toplevel, uint32_t edges)
         start_interactive_resize_master(cursor, edges, cx, cy);
     }
 
-    // init resize schedule
-    cursor->last_resize_time_msec = get_current_time_msec();
+    cursor_update_sync_inhibit(cursor);
 }
 
 static void end_interactive_move_floating(struct cwc_cursor *cursor)
@@ -823,9 +861,6 @@ static void end_interactive_move_floating(struct cwc_cursor *cursor)
 
 static void end_interactive_resize_floating(struct cwc_cursor *cursor)
 {
-    // apply pending change from schedule
-    cwc_container_set_box_global(cursor->grabbed_toplevel->container,
-                                 &cursor->pending_box);
     cursor->grab_float = (struct wlr_box){0};
 }
 
@@ -841,9 +876,17 @@ static void end_interactive_move_master(struct cwc_cursor *cursor)
 
     if (toplevel_under_cursor
         && cwc_toplevel_is_visible(toplevel_under_cursor)) {
-        wl_list_swap(&toplevel_under_cursor->container->link_output_container,
+        struct cwc_container *under = toplevel_under_cursor->container;
+        wl_list_swap(&under->link_output_container,
                      &grabbed->link_output_container);
-        wl_list_swap(&toplevel_under_cursor->container->link, &grabbed->link);
+        wl_list_swap(&under->link, &grabbed->link);
+
+        // keep the sort key of the master tiled cache in the list order
+        int64_t order         = under->output_order;
+        under->output_order   = grabbed->output_order;
+        grabbed->output_order = order;
+        cwc_output_lists_changed();
+        master_tiled_invalidate(grabbed->output);
     }
 
     transaction_schedule_tag(cwc_output_get_current_tag_info(grabbed->output));
@@ -896,6 +939,10 @@ void stop_interactive(struct cwc_cursor *cursor)
     if (cursor->state == CWC_CURSOR_STATE_NORMAL)
         return;
 
+    // the last motion may still waiting for a frame
+    if (cursor->interactive_dirty)
+        apply_interactive(cursor);
+
     switch (cursor->state) {
     case CWC_CURSOR_STATE_MOVE:
         end_interactive_move_floating(cursor);
@@ -921,6 +968,7 @@ void stop_interactive(struct cwc_cursor *cursor)
 
     // cursor fallback
     cursor->state = CWC_CURSOR_STATE_NORMAL;
+    cursor_update_sync_inhibit(cursor);
     if (cursor->name_before_interactive)
         cwc_cursor_set_image_by_name(cursor, cursor->name_before_interactive);
     else if (cursor->client_surface) {
@@ -945,6 +993,10 @@ _send_pointer_button_signal(struct cwc_cursor *cursor,
                             struct wlr_pointer_button_event *event,
                             bool press)
 {
+    cwc_signal_id_t signal = CWC_SIGNAL("pointer::button");
+    if (!cwc_signal_prepare_emit(signal))
+        return;
+
     struct cwc_pointer_button_event cwc_event = {
         .cursor = cursor,
         .event  = event,
@@ -955,7 +1007,7 @@ _send_pointer_button_signal(struct cwc_cursor *cursor,
     lua_pushnumber(L, event->time_msec);
     lua_pushnumber(L, event->button);
     lua_pushboolean(L, event->state);
-    cwc_signal_emit("pointer::button", &cwc_event, L, 4);
+    cwc_signal_emit_id(signal, &cwc_event, L, 4);
 }
 
 void process_cursor_button(struct cwc_cursor *cursor,
@@ -1043,6 +1095,10 @@ static inline void
 _send_pointer_swipe_begin_signal(struct cwc_cursor *cursor,
                                  struct wlr_pointer_swipe_begin_event *event)
 {
+    cwc_signal_id_t signal = CWC_SIGNAL("pointer::swipe::begin");
+    if (!cwc_signal_prepare_emit(signal))
+        return;
+
     struct cwc_pointer_swipe_begin_event signal_data = {
         .cursor = cursor,
         .event  = event,
@@ -1053,7 +1109,7 @@ _send_pointer_swipe_begin_signal(struct cwc_cursor *cursor,
     lua_pushnumber(L, event->time_msec);
     lua_pushnumber(L, event->fingers);
 
-    cwc_signal_emit("pointer::swipe::begin", &signal_data, L, 3);
+    cwc_signal_emit_id(signal, &signal_data, L, 3);
 }
 
 static void on_swipe_begin(struct wl_listener *listener, void *data)
@@ -1074,6 +1130,10 @@ static inline void
 _send_pointer_swipe_update_signal(struct cwc_cursor *cursor,
                                   struct wlr_pointer_swipe_update_event *event)
 {
+    cwc_signal_id_t signal = CWC_SIGNAL("pointer::swipe::update");
+    if (!cwc_signal_prepare_emit(signal))
+        return;
+
     struct cwc_pointer_swipe_update_event signal_data = {
         .cursor = cursor,
         .event  = event,
@@ -1086,7 +1146,7 @@ _send_pointer_swipe_update_signal(struct cwc_cursor *cursor,
     lua_pushnumber(L, event->dx);
     lua_pushnumber(L, event->dy);
 
-    cwc_signal_emit("pointer::swipe::update", &signal_data, L, 5);
+    cwc_signal_emit_id(signal, &signal_data, L, 5);
 }
 
 static void on_swipe_update(struct wl_listener *listener, void *data)
@@ -1107,6 +1167,10 @@ static inline void
 _send_pointer_swipe_end_signal(struct cwc_cursor *cursor,
                                struct wlr_pointer_swipe_end_event *event)
 {
+    cwc_signal_id_t signal = CWC_SIGNAL("pointer::swipe::end");
+    if (!cwc_signal_prepare_emit(signal))
+        return;
+
     struct cwc_pointer_swipe_end_event signal_data = {
         .cursor = cursor,
         .event  = event,
@@ -1117,7 +1181,7 @@ _send_pointer_swipe_end_signal(struct cwc_cursor *cursor,
     lua_pushnumber(L, event->time_msec);
     lua_pushboolean(L, event->cancelled);
 
-    cwc_signal_emit("pointer::swipe::end", &signal_data, L, 3);
+    cwc_signal_emit_id(signal, &signal_data, L, 3);
 }
 
 static void on_swipe_end(struct wl_listener *listener, void *data)
@@ -1137,6 +1201,10 @@ static inline void
 _send_pointer_pinch_begin_signal(struct cwc_cursor *cursor,
                                  struct wlr_pointer_pinch_begin_event *event)
 {
+    cwc_signal_id_t signal = CWC_SIGNAL("pointer::pinch::begin");
+    if (!cwc_signal_prepare_emit(signal))
+        return;
+
     struct cwc_pointer_pinch_begin_event signal_data = {
         .cursor = cursor,
         .event  = event,
@@ -1147,7 +1215,7 @@ _send_pointer_pinch_begin_signal(struct cwc_cursor *cursor,
     lua_pushnumber(L, event->time_msec);
     lua_pushnumber(L, event->fingers);
 
-    cwc_signal_emit("pointer::pinch::begin", &signal_data, L, 3);
+    cwc_signal_emit_id(signal, &signal_data, L, 3);
 }
 
 static void on_pinch_begin(struct wl_listener *listener, void *data)
@@ -1168,6 +1236,10 @@ static inline void
 _send_pointer_pinch_update_signal(struct cwc_cursor *cursor,
                                   struct wlr_pointer_pinch_update_event *event)
 {
+    cwc_signal_id_t signal = CWC_SIGNAL("pointer::pinch::update");
+    if (!cwc_signal_prepare_emit(signal))
+        return;
+
     struct cwc_pointer_pinch_update_event signal_data = {
         .cursor = cursor,
         .event  = event,
@@ -1182,7 +1254,7 @@ _send_pointer_pinch_update_signal(struct cwc_cursor *cursor,
     lua_pushnumber(L, event->scale);
     lua_pushnumber(L, event->rotation);
 
-    cwc_signal_emit("pointer::pinch::update", &signal_data, L, 7);
+    cwc_signal_emit_id(signal, &signal_data, L, 7);
 }
 
 static void on_pinch_update(struct wl_listener *listener, void *data)
@@ -1203,6 +1275,10 @@ static inline void
 _send_pointer_pinch_end_signal(struct cwc_cursor *cursor,
                                struct wlr_pointer_pinch_end_event *event)
 {
+    cwc_signal_id_t signal = CWC_SIGNAL("pointer::pinch::end");
+    if (!cwc_signal_prepare_emit(signal))
+        return;
+
     struct cwc_pointer_pinch_end_event signal_data = {
         .cursor = cursor,
         .event  = event,
@@ -1213,7 +1289,7 @@ _send_pointer_pinch_end_signal(struct cwc_cursor *cursor,
     lua_pushnumber(L, event->time_msec);
     lua_pushboolean(L, event->cancelled);
 
-    cwc_signal_emit("pointer::pinch::end", &signal_data, L, 3);
+    cwc_signal_emit_id(signal, &signal_data, L, 3);
 }
 
 static void on_pinch_end(struct wl_listener *listener, void *data)
@@ -1233,6 +1309,10 @@ static inline void
 _send_pointer_hold_begin_signal(struct cwc_cursor *cursor,
                                 struct wlr_pointer_hold_begin_event *event)
 {
+    cwc_signal_id_t signal = CWC_SIGNAL("pointer::hold::begin");
+    if (!cwc_signal_prepare_emit(signal))
+        return;
+
     struct cwc_pointer_hold_begin_event signal_data = {
         .cursor = cursor,
         .event  = event,
@@ -1243,7 +1323,7 @@ _send_pointer_hold_begin_signal(struct cwc_cursor *cursor,
     lua_pushnumber(L, event->time_msec);
     lua_pushnumber(L, event->fingers);
 
-    cwc_signal_emit("pointer::hold::begin", &signal_data, L, 3);
+    cwc_signal_emit_id(signal, &signal_data, L, 3);
 }
 
 static void on_hold_begin(struct wl_listener *listener, void *data)
@@ -1263,6 +1343,10 @@ static inline void
 _send_pointer_hold_end_signal(struct cwc_cursor *cursor,
                               struct wlr_pointer_hold_end_event *event)
 {
+    cwc_signal_id_t signal = CWC_SIGNAL("pointer::hold::end");
+    if (!cwc_signal_prepare_emit(signal))
+        return;
+
     struct cwc_pointer_hold_end_event signal_data = {
         .cursor = cursor,
         .event  = event,
@@ -1273,7 +1357,7 @@ _send_pointer_hold_end_signal(struct cwc_cursor *cursor,
     lua_pushnumber(L, event->time_msec);
     lua_pushboolean(L, event->cancelled);
 
-    cwc_signal_emit("pointer::hold::end", &signal_data, L, 3);
+    cwc_signal_emit_id(signal, &signal_data, L, 3);
 }
 
 static void on_hold_end(struct wl_listener *listener, void *data)
@@ -1423,20 +1507,24 @@ static int animation_loop(void *data)
 {
     struct cwc_cursor *cursor = data;
 
+    struct hyprcursor_image_set *set = cursor->image_set;
+    if (set == NULL)
+        return 1;
+
     size_t i = ++cursor->frame_index;
-    if (i >= cursor->images_count) {
+    if (i >= set->frame_count) {
         i = cursor->frame_index = 0;
     }
 
-    struct hyprcursor_buffer **buffer_array = cursor->cursor_buffers.data;
+    struct hyprcursor_buffer **buffer_array = set->buffers.data;
 
     wlr_cursor_set_buffer(cursor->wlr_cursor, &buffer_array[i]->base,
-                          cursor->images[i]->hotspotX / cursor->scale,
-                          cursor->images[i]->hotspotY / cursor->scale,
+                          set->images[i]->hotspotX / cursor->scale,
+                          set->images[i]->hotspotY / cursor->scale,
                           cursor->scale);
 
     wl_event_source_timer_update(cursor->animation_timer,
-                                 cursor->images[i]->delay);
+                                 set->images[i]->delay);
     return 1;
 }
 
@@ -1515,6 +1603,7 @@ struct cwc_cursor *cwc_cursor_create(struct wlr_seat *seat)
     cursor->scale       = 1.0f;
     cursor->state       = CWC_CURSOR_STATE_NORMAL;
     cursor->send_events = true;
+    wl_list_init(&cursor->image_cache);
 
     // set_xcursor must after creating manager to load the theme
     cursor->xcursor_mgr = wlr_xcursor_manager_create(NULL, cursor->info.size);
@@ -1612,17 +1701,18 @@ struct cwc_cursor *cwc_cursor_create(struct wlr_seat *seat)
     return cursor;
 }
 
-static void hyprcursor_buffer_fini(struct cwc_cursor *cursor);
+static void hyprcursor_image_cache_clear(struct cwc_cursor *cursor);
 
 void cwc_cursor_destroy(struct cwc_cursor *cursor)
 {
     lua_State *L = g_config_get_lua_State();
     luaC_object_unregister(L, cursor);
 
+    if (cursor->sync_inhibited)
+        transaction_uninhibit_sync();
+
     // clean hyprcursor leftover
-    if (cursor->images != NULL)
-        hyprcursor_cursor_image_data_free(cursor->images, cursor->images_count);
-    hyprcursor_buffer_fini(cursor);
+    hyprcursor_image_cache_clear(cursor);
 
     hyprcursor_style_done(cursor->hyprcursor_mgr, cursor->info);
     hyprcursor_manager_free(cursor->hyprcursor_mgr);
@@ -1664,12 +1754,15 @@ void cwc_cursor_destroy(struct cwc_cursor *cursor)
     free(cursor);
 }
 
+/* maximum cursor shapes kept rasterized per cursor */
+#define HYPRCURSOR_IMAGE_CACHE_MAX 16
+
 /* load hyprcursor buffer */
-static void hyprcursor_buffer_init(struct cwc_cursor *cursor)
+static void hyprcursor_buffer_init(struct hyprcursor_image_set *set)
 {
-    wl_array_init(&cursor->cursor_buffers);
-    for (int i = 0; i < cursor->images_count; ++i) {
-        hyprcursor_cursor_image_data *image_data = cursor->images[i];
+    wl_array_init(&set->buffers);
+    for (int i = 0; i < set->images_count; ++i) {
+        hyprcursor_cursor_image_data *image_data = set->images[i];
         struct hyprcursor_buffer *buffer         = calloc(1, sizeof(*buffer));
         if (buffer == NULL) {
             cwc_log(CWC_ERROR, "failed to allocate hyprcursor_buffer");
@@ -1680,25 +1773,104 @@ static void hyprcursor_buffer_init(struct cwc_cursor *cursor)
                         image_data->size);
 
         struct hyprcursor_buffer **buffer_array =
-            wl_array_add(&cursor->cursor_buffers, sizeof(&image_data));
+            wl_array_add(&set->buffers, sizeof(buffer));
         *buffer_array = buffer;
+        set->frame_count++;
     }
 }
 
 /* free hyprcursor buffer */
-static void hyprcursor_buffer_fini(struct cwc_cursor *cursor)
+static void hyprcursor_buffer_fini(struct hyprcursor_image_set *set)
 {
-    if (cursor->cursor_buffers.size == 0)
-        return;
-
-    struct hyprcursor_buffer **buffer_array = cursor->cursor_buffers.data;
+    struct hyprcursor_buffer **buffer_array = set->buffers.data;
 
-    int len = cursor->cursor_buffers.size / sizeof(buffer_array);
+    int len = set->buffers.size / sizeof(*buffer_array);
     for (int i = 0; i < len; i++) {
         wlr_buffer_drop(&buffer_array[i]->base);
     }
-    wl_array_release(&cursor->cursor_buffers);
-    cursor->cursor_buffers.size = 0;
+    wl_array_release(&set->buffers);
+}
+
+static void hyprcursor_image_set_destroy(struct hyprcursor_image_set *set)
+{
+    hyprcursor_buffer_fini(set);
+    if (set->images != NULL)
+        hyprcursor_cursor_image_data_free(set->images, set->images_count);
+
+    wl_list_remove(&set->link);
+    free(set->name);
+    free(set);
+}
+
+/* drop every cached image set, must be called before the style they are
+ * loaded from is released.
+ */
+static void hyprcursor_image_cache_clear(struct cwc_cursor *cursor)
+{
+    // make sure wlr_cursor doesn't hold buffer that point to freed surface
+    if (cursor->image_set != NULL) {
+        wl_event_source_timer_update(cursor->animation_timer, 0);
+        wlr_cursor_unset_image(cursor->wlr_cursor);
+        cursor->image_set = NULL;
+    }
+
+    struct hyprcursor_image_set *set, *tmp;
+    wl_list_for_each_safe(set, tmp, &cursor->image_cache, link)
+    {
+        hyprcursor_image_set_destroy(set);
+    }
+    cursor->image_cache_len = 0;
+}
+
+/* return image set for the name in current style and scale, the set is moved
+ * to the front of the cache. Return NULL on allocation failure.
+ */
+static struct hyprcursor_image_set *
+hyprcursor_image_set_get(struct cwc_cursor *cursor, const char *name)
+{
+    struct hyprcursor_image_set *set;
+    wl_list_for_each(set, &cursor->image_cache, link)
+    {
+        if (set->size == cursor->info.size && set->scale == cursor->scale
+            && strcmp(set->name, name) == 0) {
+            wl_list_remove(&set->link);
+            wl_list_insert(&cursor->image_cache, &set->link);
+            return set;
+        }
+    }
+
+    set = calloc(1, sizeof(*set));
+    if (set == NULL) {
+        cwc_log(CWC_ERROR, "failed to allocate hyprcursor_image_set");
+        return NULL;
+    }
+
+    set->name   = strdup(name);
+    set->size   = cursor->info.size;
+    set->scale  = cursor->scale;
+    set->images = hyprcursor_get_cursor_image_data(
+        cursor->hyprcursor_mgr, name, cursor->info, &set->images_count);
+
+    // keep the miss so the next lookup goes straight to xcursor
+    if (!set->images_count) {
+        hyprcursor_cursor_image_data_free(set->images, set->images_count);
+        set->images = NULL;
+    }
+
+    hyprcursor_buffer_init(set);
+
+    wl_list_insert(&cursor->image_cache, &set->link);
+    cursor->image_cache_len++;
+
+    // evict the least recently used, current set is always at the front
+    if (cursor->image_cache_len > HYPRCURSOR_IMAGE_CACHE_MAX) {
+        struct hyprcursor_image_set *last =
+            wl_container_of(cursor->image_cache.prev, last, link);
+        hyprcursor_image_set_destroy(last);
+        cursor->image_cache_len--;
+    }
+
+    return set;
 }
 
 void cwc_cursor_set_image_by_name(struct cwc_cursor *cursor, const char *name)
@@ -1722,8 +1894,8 @@ void cwc_cursor_set_image_by_name(struct cwc_cursor *cursor, const char *name)
 
     cursor->current_name       = name;
     cursor->name_before_hidden = NULL;
-
-    hyprcursor_buffer_fini(cursor);
+    cursor->image_set          = NULL;
+    wl_event_source_timer_update(cursor->animation_timer, 0);
 
     // xcursor fallback
     if (!hyprcursor_manager_valid(cursor->hyprcursor_mgr)) {
@@ -1731,37 +1903,27 @@ void cwc_cursor_set_image_by_name(struct cwc_cursor *cursor, const char *name)
         return;
     }
 
-    // free prev images
-    if (cursor->images != NULL)
-        hyprcursor_cursor_image_data_free(cursor->images, cursor->images_count);
-
-    cursor->images = hyprcursor_get_cursor_image_data(
-        cursor->hyprcursor_mgr, name, cursor->info, &cursor->images_count);
+    struct hyprcursor_image_set *set = hyprcursor_image_set_get(cursor, name);
 
     // xcursor fallback
-    if (!cursor->images_count) {
-        hyprcursor_cursor_image_data_free(cursor->images, cursor->images_count);
-        cursor->images = NULL;
+    if (set == NULL || !set->frame_count) {
         wlr_cursor_set_xcursor(cursor->wlr_cursor, cursor->xcursor_mgr, name);
         return;
     }
 
-    // cache buffer
-    hyprcursor_buffer_init(cursor);
+    cursor->image_set = set;
 
-    struct hyprcursor_buffer **buffer_array = cursor->cursor_buffers.data;
+    struct hyprcursor_buffer **buffer_array = set->buffers.data;
 
     wlr_cursor_set_buffer(cursor->wlr_cursor, &buffer_array[0]->base,
-                          cursor->images[0]->hotspotX / cursor->scale,
-                          cursor->images[0]->hotspotY / cursor->scale,
+                          set->images[0]->hotspotX / cursor->scale,
+                          set->images[0]->hotspotY / cursor->scale,
                           cursor->scale);
 
-    if (cursor->images_count > 1) {
+    if (set->frame_count > 1) {
         cursor->frame_index = 0;
         wl_event_source_timer_update(cursor->animation_timer,
-                                     cursor->images[0]->delay);
-    } else {
-        wl_event_source_timer_update(cursor->animation_timer, 0);
+                                     set->images[0]->delay);
     }
 }
 
@@ -1789,6 +1951,8 @@ void cwc_cursor_set_surface(struct cwc_cursor *cursor,
         wl_list_init(&cursor->client_side_surface_destroy_l.link);
     }
     cursor->current_name = NULL;
+    cursor->image_set    = NULL;
+    wl_event_source_timer_update(cursor->animation_timer, 0);
     wlr_cursor_set_surface(cursor->wlr_cursor, surface, hotspot_x, hotspot_y);
 }
 
@@ -1798,6 +1962,8 @@ void cwc_cursor_hide_cursor(struct cwc_cursor *cursor)
         return;
 
     cursor->current_name = NULL;
+    cursor->image_set    = NULL;
+    wl_event_source_timer_update(cursor->animation_timer, 0);
     wlr_cursor_unset_image(cursor->wlr_cursor);
 }
 
@@ -1832,7 +1998,7 @@ bool cwc_cursor_hyprcursor_change_style(
     // force reset image
     cursor->current_name = NULL;
 
-    hyprcursor_buffer_fini(cursor);
+    hyprcursor_image_cache_clear(cursor);
     hyprcursor_style_done(cursor->hyprcursor_mgr, cursor->info);
 
     info.size = g_config.cursor_size * cursor->scale;
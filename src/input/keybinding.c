@@ -43,6 +43,8 @@
 #include "cwc/signal.h"
 #include "cwc/util.h"
 
+CWC_POOL_DEFINE(keybind_info, struct cwc_keybind_info, 128)
+
 #define GENERATED_KEY_LENGTH 8
 uint64_t keybind_generate_key(uint32_t modifiers, uint32_t keysym)
 {
@@ -71,6 +73,182 @@ static int repeat_loop(void *data)
     return 1;
 }
 
+/* Compiled lookup of every active keyboard binding map so that a key press
+ * only need a single search no matter how many maps are active. Bindings with
+ * the same key from multiple maps are stored contiguously following the map
+ * order (default map first, then server.kbd_kmaps order).
+ */
+struct kbd_dispatch_bind {
+    struct cwc_keybind_map *kmap;
+    struct cwc_keybind_info *info;
+    uint64_t serial; // info serial when collected
+};
+
+struct kbd_dispatch_entry {
+    uint64_t key;
+    int start; // index of the first bind in the binds array
+    int count;
+};
+
+static struct {
+    bool dirty;
+
+    struct kbd_dispatch_entry *entries; // sorted by key
+    int entries_len;
+
+    struct kbd_dispatch_bind *binds;
+    int binds_len;
+} kbd_dispatch = {.dirty = true};
+
+void keybind_kbd_dispatch_invalidate()
+{
+    kbd_dispatch.dirty = true;
+}
+
+static int _count_binds(struct cwc_keybind_map *kmap)
+{
+    return kmap->map->size;
+}
+
+/* append every binding in the map, return the new length */
+static int _collect_binds(struct cwc_keybind_map *kmap,
+                          struct kbd_dispatch_bind *binds,
+                          int len)
+{
+    struct cwc_hhmap *map = kmap->map;
+    for (size_t i = 0; i < map->alloc; i++) {
+        struct hhash_entry *elem = &map->table[i];
+        if (!elem->hash)
+            continue;
+
+        binds[len].kmap   = kmap;
+        binds[len].info   = elem->data;
+        binds[len].serial = binds[len].info->serial;
+        len++;
+    }
+
+    return len;
+}
+
+struct kbd_dispatch_tagged_bind {
+    struct kbd_dispatch_bind bind;
+    int order;
+};
+
+static int _dispatch_bind_cmp(const void *a, const void *b)
+{
+    const struct kbd_dispatch_tagged_bind *x = a;
+    const struct kbd_dispatch_tagged_bind *y = b;
+
+    if (x->bind.info->key != y->bind.info->key)
+        return x->bind.info->key < y->bind.info->key ? -1 : 1;
+
+    // same key, preserve the collected order which is the map order
+    return x->order - y->order;
+}
+
+static void kbd_dispatch_rebuild()
+{
+    free(kbd_dispatch.entries);
+    free(kbd_dispatch.binds);
+    kbd_dispatch.entries     = NULL;
+    kbd_dispatch.binds       = NULL;
+    kbd_dispatch.entries_len = 0;
+    kbd_dispatch.binds_len   = 0;
+    kbd_dispatch.dirty       = false;
+
+    struct cwc_keybind_map *kmap;
+    int total = _count_binds(server.main_kbd_kmap);
+    wl_list_for_each(kmap, &server.kbd_kmaps, link)
+    {
+        if (kmap->active)
+            total += _count_binds(kmap);
+    }
+
+    if (!total)
+        return;
+
+    struct kbd_dispatch_bind *binds    = calloc(total, sizeof(*binds));
+    struct kbd_dispatch_entry *entries = calloc(total, sizeof(*entries));
+    if (!binds || !entries) {
+        free(binds);
+        free(entries);
+        kbd_dispatch.dirty = true;
+        return;
+    }
+
+    int len = _collect_binds(server.main_kbd_kmap, binds, 0);
+    wl_list_for_each(kmap, &server.kbd_kmaps, link)
+    {
+        if (kmap->active)
+            len = _collect_binds(kmap, binds, len);
+    }
+
+    /* qsort isn't stable, tag each bind with its position so that the
+     * comparator can fall back to it.
+     */
+    struct kbd_dispatch_tagged_bind *tagged = calloc(len, sizeof(*tagged));
+    if (!tagged) {
+        free(binds);
+        free(entries);
+        kbd_dispatch.dirty = true;
+        return;
+    }
+
+    for (int i = 0; i < len; i++) {
+        tagged[i].bind  = binds[i];
+        tagged[i].order = i;
+    }
+
+    qsort(tagged, len, sizeof(*tagged), _dispatch_bind_cmp);
+
+    int entries_len = 0;
+    for (int i = 0; i < len; i++) {
+        binds[i] = tagged[i].bind;
+
+        uint64_t key = binds[i].info->key;
+        if (entries_len && entries[entries_len - 1].key == key) {
+            entries[entries_len - 1].count++;
+            continue;
+        }
+
+        entries[entries_len].key   = key;
+        entries[entries_len].start = i;
+        entries[entries_len].count = 1;
+        entries_len++;
+    }
+
+    free(tagged);
+
+    kbd_dispatch.binds       = binds;
+    kbd_dispatch.binds_len   = len;
+    kbd_dispatch.entries     = entries;
+    kbd_dispatch.entries_len = entries_len;
+}
+
+static struct kbd_dispatch_entry *kbd_dispatch_lookup(uint64_t key)
+{
+    if (kbd_dispatch.dirty)
+        kbd_dispatch_rebuild();
+
+    int lo = 0;
+    int hi = kbd_dispatch.entries_len - 1;
+    while (lo <= hi) {
+        int mid                          = lo + (hi - lo) / 2;
+        struct kbd_dispatch_entry *entry = &kbd_dispatch.entries[mid];
+
+        if (entry->key == key)
+            return entry;
+
+        if (entry->key < key)
+            lo = mid + 1;
+        else
+            hi = mid - 1;
+    }
+
+    return NULL;
+}
+
 static void _register_kmap_object(void *data)
 {
     struct cwc_keybind_map *kmap = data;
@@ -85,6 +263,7 @@ struct cwc_keybind_map *cwc_keybind_map_create(struct wl_list *list)
     kmap->active                 = true;
     kmap->repeat_timer =
         wl_event_loop_add_timer(server.wl_event_loop, repeat_loop, kmap);
+    keybind_kbd_dispatch_invalidate();
 
     if (list)
         wl_list_insert(list->prev, &kmap->link);
@@ -112,6 +291,7 @@ void cwc_keybind_map_destroy(struct cwc_keybind_map *kmap)
     wl_event_source_remove(kmap->repeat_timer);
 
     wl_list_remove(&kmap->link);
+    keybind_kbd_dispatch_invalidate();
 
     free(kmap);
 }
@@ -137,7 +317,7 @@ static void cwc_keybind_info_destroy(struct cwc_keybind_info *info)
         break;
     }
 
-    free(info);
+    keybind_info_free(info);
 }
 
 static void _keybind_clear(struct cwc_hhmap *kmap)
@@ -156,10 +336,26 @@ void cwc_keybind_map_clear(struct cwc_keybind_map *kmap)
     _keybind_clear(*map);
     cwc_hhmap_destroy(*map);
     *map = cwc_hhmap_create(8);
+    kmap->repeated_bind = NULL;
+    wl_event_source_timer_update(kmap->repeat_timer, 0);
+    keybind_kbd_dispatch_invalidate();
+}
+
+void cwc_keybind_map_set_active(struct cwc_keybind_map *kmap, bool active)
+{
+    if (kmap->active == active)
+        return;
+
+    kmap->active = active;
+    keybind_kbd_dispatch_invalidate();
 }
 
 void cwc_keybind_map_stop_repeat(struct cwc_keybind_map *kmap)
 {
+    // timer only armed when there's repeated bind
+    if (!kmap->repeated_bind)
+        return;
+
     wl_event_source_timer_update(kmap->repeat_timer, 0);
     kmap->repeated_bind = NULL;
 }
@@ -174,14 +370,18 @@ void keybind_register(struct cwc_keybind_map *kmap,
 {
     uint64_t generated_key = keybind_generate_key(modifiers, key);
 
-    struct cwc_keybind_info *info_dup = malloc(sizeof(*info_dup));
+    static uint64_t serial = 0;
+
+    struct cwc_keybind_info *info_dup = keybind_info_alloc();
     memcpy(info_dup, &info, sizeof(*info_dup));
-    info_dup->key = generated_key;
+    info_dup->key    = generated_key;
+    info_dup->serial = ++serial;
 
     _keybind_remove_if_exist(kmap, generated_key);
 
     cwc_hhmap_ninsert(kmap->map, &generated_key, GENERATED_KEY_LENGTH,
                       info_dup);
+    keybind_kbd_dispatch_invalidate();
 
     luaC_object_kbind_register(g_config_get_lua_State(), info_dup);
 }
@@ -194,8 +394,12 @@ static void _keybind_remove_if_exist(struct cwc_keybind_map *kmap,
     if (!existed)
         return;
 
+    if (kmap->repeated_bind == existed)
+        cwc_keybind_map_stop_repeat(kmap);
+
     cwc_keybind_info_destroy(existed);
     cwc_hhmap_nremove(kmap->map, &generated_key, GENERATED_KEY_LENGTH);
+    keybind_kbd_dispatch_invalidate();
 }
 
 void keybind_remove(struct cwc_keybind_map *kmap,
@@ -268,6 +472,80 @@ bool keybind_kbd_execute(struct cwc_keybind_map *kmap,
     return _keybind_execute(kmap, info, press);
 }
 
+/* check if the bind still valid after the maps is modified by a callback */
+static bool _dispatch_bind_is_alive(struct kbd_dispatch_bind *bind,
+                                    uint64_t key)
+{
+    bool found = bind->kmap == server.main_kbd_kmap;
+
+    struct cwc_keybind_map *kmap;
+    wl_list_for_each(kmap, &server.kbd_kmaps, link)
+    {
+        if (found)
+            break;
+
+        if (kmap == bind->kmap)
+            found = kmap->active;
+    }
+
+    if (!found)
+        return false;
+
+    // a freed bind address may be reused by a new bind, compare the serial
+    struct cwc_keybind_info *info =
+        cwc_hhmap_nget(bind->kmap->map, &key, GENERATED_KEY_LENGTH);
+    return info == bind->info && info->serial == bind->serial;
+}
+
+bool keybind_kbd_dispatch(struct cwc_seat *seat,
+                          uint32_t modifiers,
+                          xkb_keysym_t key,
+                          bool press)
+{
+    struct kbd_dispatch_entry *entry =
+        kbd_dispatch_lookup(keybind_generate_key(modifiers, key));
+
+    if (entry == NULL)
+        return false;
+
+    bool locked  = server.session_lock->locked || seat->kbd_inhibitor;
+    bool handled = false;
+
+    /* copy the binds since executing lua callback may modify the maps and
+     * rebuild the index in the middle of the loop.
+     */
+    uint64_t genkey = entry->key;
+    int count       = entry->count;
+    struct kbd_dispatch_bind binds[count];
+    memcpy(binds, &kbd_dispatch.binds[entry->start], sizeof(binds));
+
+    for (int i = 0; i < count; i++) {
+        // the bind or the map may be removed by previous callback
+        if (kbd_dispatch.dirty && !_dispatch_bind_is_alive(&binds[i], genkey))
+            continue;
+
+        struct cwc_keybind_info *info = binds[i].info;
+
+        if (!info->exclusive && locked)
+            continue;
+
+        handled |= _keybind_execute(binds[i].kmap, info, press);
+    }
+
+    return handled;
+}
+
+void keybind_kbd_stop_repeat()
+{
+    cwc_keybind_map_stop_repeat(server.main_kbd_kmap);
+
+    struct cwc_keybind_map *kmap;
+    wl_list_for_each(kmap, &server.kbd_kmaps, link)
+    {
+        cwc_keybind_map_stop_repeat(kmap);
+    }
+}
+
 bool keybind_mouse_execute(struct cwc_keybind_map *kmap,
                            uint32_t modifiers,
                            uint32_t button,
@@ -100,8 +100,8 @@ static void on_kbd_group_modifiers(struct wl_listener *listener, void *data)
                                    XKB_STATE_LAYOUT_EFFECTIVE);
 
     if (kbd_group->layout_idx != active_index) {
-        cwc_object_emit_signal_simple("kbd::prop::layout_index",
-                                      g_config_get_lua_State(), kbd_group);
+        cwc_object_emit_signal_simple_id(CWC_SIGNAL("kbd::prop::layout_index"),
+                                         g_config_get_lua_State(), kbd_group);
         kbd_group->layout_idx = active_index;
     }
 
@@ -112,8 +112,21 @@ static void _send_kbd_key_signal(struct cwc_keyboard_group *kbd_group,
                                  struct wlr_keyboard_key_event *event,
                                  xkb_keysym_t keysym)
 {
+    cwc_signal_id_t signal;
+    switch (event->state) {
+    case WL_KEYBOARD_KEY_STATE_PRESSED:
+        signal = CWC_SIGNAL("kbd::pressed");
+        break;
+    case WL_KEYBOARD_KEY_STATE_RELEASED:
+        signal = CWC_SIGNAL("kbd::released");
+        break;
+    default:
+        cwc_log(CWC_ERROR, "TODO: handle repeat");
+        return;
+    }
+
     lua_State *L = g_config_get_lua_State();
-    if (!luaC_object_valid(L, kbd_group))
+    if (!cwc_signal_prepare_emit(signal) || !luaC_object_valid(L, kbd_group))
         return;
 
     char keyname[65] = {0};
@@ -130,17 +143,71 @@ static void _send_kbd_key_signal(struct cwc_keyboard_group *kbd_group,
                                                .time_msec = event->time_msec,
                                                .keycode   = xkb_keycode};
 
-    switch (event->state) {
-    case WL_KEYBOARD_KEY_STATE_PRESSED:
-        cwc_signal_emit("kbd::pressed", &cwc_event, L, 3);
-        break;
-    case WL_KEYBOARD_KEY_STATE_RELEASED:
-        cwc_signal_emit("kbd::released", &cwc_event, L, 3);
-        break;
-    default:
-        cwc_log(CWC_ERROR, "TODO: handle repeat");
-        break;
+    cwc_signal_emit_id(signal, &cwc_event, L, 3);
+}
+
+/* build keycode to keysym table from an empty state to get untransformed keysym
+ * so that for keybinds we don't need to account keyname change when the
+ * modifier is changed. It will also look more readable e.g.
+ * MOD + "1" | MOD + SHIFT + "1" while using transformed is
+ * MOD + "1" + MOD | SHIFT + "exclam".
+ */
+static void keysym_table_rebuild(struct cwc_keyboard_group *kbd_group)
+{
+    struct xkb_keymap *keymap = kbd_group->wlr_kbd_group->keyboard.keymap;
+
+    free(kbd_group->base_keysyms);
+    kbd_group->base_keysyms     = NULL;
+    kbd_group->base_keysyms_min = 0;
+    kbd_group->base_keysyms_len = 0;
+
+    if (!keymap)
+        return;
+
+    xkb_keycode_t min = xkb_keymap_min_keycode(keymap);
+    xkb_keycode_t max = xkb_keymap_max_keycode(keymap);
+    if (max < min)
+        return;
+
+    kbd_group->base_keysyms =
+        calloc(max - min + 1, sizeof(*kbd_group->base_keysyms));
+    if (!kbd_group->base_keysyms)
+        return;
+
+    kbd_group->base_keysyms_min = min;
+    kbd_group->base_keysyms_len = max - min + 1;
+
+    struct xkb_state *state = xkb_state_new(keymap);
+    for (xkb_keycode_t keycode = min; keycode <= max; keycode++) {
+        const xkb_keysym_t *syms;
+        int nsyms = xkb_state_key_get_syms(state, keycode, &syms);
+
+        kbd_group->base_keysyms[keycode - min] =
+            nsyms ? syms[0] : XKB_KEY_NoSymbol;
+
+        if (keycode == max) // prevent overflow when max is UINT32_MAX
+            break;
     }
+    xkb_state_unref(state);
+}
+
+static inline xkb_keysym_t
+keysym_table_get(struct cwc_keyboard_group *kbd_group, xkb_keycode_t keycode)
+{
+    xkb_keycode_t idx = keycode - kbd_group->base_keysyms_min;
+    if (keycode < kbd_group->base_keysyms_min
+        || idx >= kbd_group->base_keysyms_len)
+        return XKB_KEY_NoSymbol;
+
+    return kbd_group->base_keysyms[idx];
+}
+
+static void on_kbd_group_keymap(struct wl_listener *listener, void *data)
+{
+    struct cwc_keyboard_group *kbd_group =
+        wl_container_of(listener, kbd_group, keymap_l);
+
+    keysym_table_rebuild(kbd_group);
 }
 
 static void process_key_event(struct cwc_keyboard_group *kbd_group,
@@ -155,23 +222,11 @@ static void process_key_event(struct cwc_keyboard_group *kbd_group,
     // translate libinput keycode -> xkbcommon
     int keycode = event->keycode + 8;
 
-    // create an empty state to get untransformed keysym so that for keybinds we
-    // don't need to account keyname change when the modifier is changed.
-    // It will also look more readable e.g. MOD + "1" | MOD + SHIFT + "1"
-    // while using transformed is MOD + "1" + MOD | SHIFT + "exclam".
-    struct xkb_state *state = xkb_state_new(wlr_kbd->keymap);
-    const xkb_keysym_t *syms;
-    int nsyms = xkb_state_key_get_syms(state, keycode, &syms);
-    xkb_state_unref(state);
-
-    uint32_t keysym = XKB_KEY_NoSymbol;
-    if (nsyms)
-        keysym = syms[0];
+    uint32_t keysym = keysym_table_get(kbd_group, keycode);
 
     uint32_t modifiers = wlr_keyboard_get_modifiers(wlr_kbd);
     bool handled       = 0;
 
-    struct cwc_keybind_map *kmap;
     int vec_idx;
     switch (event->state) {
     case WL_KEYBOARD_KEY_STATE_PRESSED:
@@ -184,14 +239,7 @@ static void process_key_event(struct cwc_keyboard_group *kbd_group,
             cwc_vec_push(kbd_group->handled_tracker,
                          (void *)(uintptr_t)keycode);
 
-        handled |= keybind_kbd_execute(server.main_kbd_kmap, seat, modifiers,
-                                       keysym, true);
-        wl_list_for_each(kmap, &server.kbd_kmaps, link)
-        {
-            if (kmap->active)
-                handled |=
-                    keybind_kbd_execute(kmap, seat, modifiers, keysym, true);
-        }
+        handled |= keybind_kbd_dispatch(seat, modifiers, keysym, true);
 
         if (!handled)
             cwc_vec_pop(kbd_group->handled_tracker);
@@ -205,17 +253,8 @@ static void process_key_event(struct cwc_keyboard_group *kbd_group,
             cwc_vec_pop_at(kbd_group->handled_tracker, vec_idx);
         }
 
-        keybind_kbd_execute(server.main_kbd_kmap, seat, modifiers, keysym,
-                            false);
-        cwc_keybind_map_stop_repeat(server.main_kbd_kmap);
-
-        wl_list_for_each(kmap, &server.kbd_kmaps, link)
-        {
-            if (kmap->active)
-                keybind_kbd_execute(kmap, seat, modifiers, keysym, false);
-
-            cwc_keybind_map_stop_repeat(kmap);
-        }
+        keybind_kbd_dispatch(seat, modifiers, keysym, false);
+        keybind_kbd_stop_repeat();
         break;
     default:
         cwc_log(CWC_ERROR, "TODO: HANDLE REPEAT");
@@ -266,6 +305,11 @@ static void _notify_focus_signal(struct wlr_surface *old_surface,
     struct cwc_toplevel *old = cwc_toplevel_try_from_wlr_surface(old_surface);
     struct cwc_toplevel *new = cwc_toplevel_try_from_wlr_surface(new_surface);
 
+    if (old)
+        cwc_toplevel_update_tag_stats(old);
+    if (new)
+        cwc_toplevel_update_tag_stats(new);
+
     if (new) {
         if (new->container->bsp_node)
             bsp_last_focused_update(new->container);
@@ -290,13 +334,13 @@ static void _notify_focus_signal(struct wlr_surface *old_surface,
             return;
 
         cwc_toplevel_set_activated(old, false);
-        cwc_object_emit_signal_simple("client::unfocus",
-                                      g_config_get_lua_State(), old);
+        cwc_object_emit_signal_simple_id(CWC_SIGNAL("client::unfocus"),
+                                         g_config_get_lua_State(), old);
     }
 
     if (new && cwc_toplevel_is_mapped(new)) {
-        cwc_object_emit_signal_simple("client::focus", g_config_get_lua_State(),
-                                      new);
+        cwc_object_emit_signal_simple_id(CWC_SIGNAL("client::focus"),
+                                         g_config_get_lua_State(), new);
     }
 }
 
@@ -374,10 +418,13 @@ cwc_keyboard_group_create(struct cwc_seat *seat,
 
     kbd_group->modifiers_l.notify = on_kbd_group_modifiers;
     kbd_group->key_l.notify       = on_kbd_group_key;
+    kbd_group->keymap_l.notify    = on_kbd_group_keymap;
     wl_signal_add(&kbd_group->wlr_kbd_group->keyboard.events.modifiers,
                   &kbd_group->modifiers_l);
     wl_signal_add(&kbd_group->wlr_kbd_group->keyboard.events.key,
                   &kbd_group->key_l);
+    wl_signal_add(&kbd_group->wlr_kbd_group->keyboard.events.keymap,
+                  &kbd_group->keymap_l);
 
     if (virtual) {
         kbd_group->vkbd = virtual;
@@ -408,11 +455,13 @@ void cwc_keyboard_group_destroy(struct cwc_keyboard_group *kbd_group)
 
     wl_list_remove(&kbd_group->modifiers_l.link);
     wl_list_remove(&kbd_group->key_l.link);
+    wl_list_remove(&kbd_group->keymap_l.link);
 
     wl_list_remove(&kbd_group->config_commit_l.link);
 
     wlr_keyboard_group_destroy(kbd_group->wlr_kbd_group);
     cwc_vec_destroy(kbd_group->handled_tracker);
+    free(kbd_group->base_keysyms);
     free(kbd_group);
 }
 
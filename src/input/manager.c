@@ -47,7 +47,7 @@ static void on_libinput_device_destroy(struct wl_listener *listener, void *data)
     struct cwc_libinput_device *dev = wl_container_of(listener, dev, destroy_l);
 
     lua_State *L = g_config_get_lua_State();
-    cwc_object_emit_signal_simple("input::destroy", L, dev);
+    cwc_object_emit_signal_simple_id(CWC_SIGNAL("input::destroy"), L, dev);
     luaC_object_unregister(L, dev);
 
     wl_list_remove(&dev->link);
@@ -95,7 +95,8 @@ static void on_new_input(struct wl_listener *listener, void *data)
 
         lua_State *L = g_config_get_lua_State();
         luaC_object_input_register(L, libinput_dev);
-        cwc_object_emit_signal_simple("input::new", L, libinput_dev);
+        cwc_object_emit_signal_simple_id(CWC_SIGNAL("input::new"), L,
+                                         libinput_dev);
     }
 }
 
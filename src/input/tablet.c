@@ -295,7 +295,7 @@ void process_tablet_tool_button(struct cwc_cursor *cursor,
 static void _cwc_tablet_destroy(struct cwc_tablet *tablet)
 {
     lua_State *L = g_config_get_lua_State();
-    cwc_object_emit_signal_simple("tablet::destroy", L, tablet);
+    cwc_object_emit_signal_simple_id(CWC_SIGNAL("tablet::destroy"), L, tablet);
     luaC_object_unregister(L, tablet);
 
     wl_list_remove(&tablet->link);
@@ -334,7 +334,7 @@ struct cwc_tablet *cwc_tablet_create(struct cwc_seat *seat,
 
     lua_State *L = g_config_get_lua_State();
     luaC_object_tablet_register(L, tablet);
-    cwc_object_emit_signal_simple("tablet::new", L, tablet);
+    cwc_object_emit_signal_simple_id(CWC_SIGNAL("tablet::new"), L, tablet);
 
     return tablet;
 }
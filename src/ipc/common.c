@@ -16,22 +16,33 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <stdlib.h>
 #include <string.h>
 
 #include "cwc/ipc.h"
 
+/* buffer bigger than this is released once it's drained so one huge message
+ * doesn't pin the memory for the rest of the connection.
+ */
+#define IPC_BUFFER_KEEP_SIZE (64 << 10)
+
+void ipc_write_header(char *dest, enum cwc_ipc_opcode opcode, uint32_t body_len)
+{
+    memcpy(dest, IPC_HEADER, IPC_HEADER_LEN);
+    dest[IPC_HEADER_LEN] = opcode;
+    memcpy(&dest[IPC_HEADER_LEN + 1], &body_len, sizeof(body_len));
+}
+
 int ipc_create_message_n(
     char *dest, int maxlen, enum cwc_ipc_opcode opcode, const char *body, int n)
 {
     int num_written = HEADER_SIZE + n;
 
-    if (num_written > maxlen)
+    if (n < 0 || num_written > maxlen)
         return -1;
 
-    strcpy(dest, IPC_HEADER);
-    char opcstr[4] = {'\n', opcode, '\n', '\x00'};
-    strcat(dest, opcstr);
-    strncat(dest, body, n);
+    ipc_write_header(dest, opcode, n);
+    memcpy(&dest[HEADER_SIZE], body, n);
 
     return num_written;
 }
@@ -46,26 +57,143 @@ int ipc_create_message(char *dest,
 
 bool check_header(const char *msg)
 {
-    int hlen = sizeof(IPC_HEADER);
+    return memcmp(IPC_HEADER, msg, IPC_HEADER_LEN) == 0;
+}
 
-    if (strncmp(IPC_HEADER, msg, hlen - 1) != 0)
-        return false;
+const char *ipc_get_body(const char *msg, enum cwc_ipc_opcode *opcode)
+{
+    if (!check_header(msg))
+        return NULL;
 
-    if (msg[hlen - 1] == '\n' && msg[hlen + 1] == '\n')
-        return true;
+    if (opcode)
+        *opcode = (unsigned char)msg[IPC_HEADER_LEN];
 
-    return false;
+    return &msg[HEADER_SIZE];
 }
 
-const char *ipc_get_body(const char *msg, enum cwc_ipc_opcode *opcode)
+long ipc_parse_frame(const char *data,
+                     size_t len,
+                     enum cwc_ipc_opcode *opcode,
+                     const char **body,
+                     uint32_t *body_len)
 {
-    if (!check_header(msg))
+    if (len == 0)
+        return 0;
+
+    if (len < IPC_HEADER_LEN)
+        return memcmp(IPC_HEADER, data, len) == 0 ? 0 : -1;
+
+    if (!check_header(data))
+        return -1;
+
+    if (len < HEADER_SIZE)
+        return 0;
+
+    uint32_t n;
+    memcpy(&n, &data[IPC_HEADER_LEN + 1], sizeof(n));
+    if (n > IPC_MAX_BODY_SIZE)
+        return -1;
+
+    if (len - HEADER_SIZE < n)
+        return 0;
+
+    if (opcode)
+        *opcode = (unsigned char)data[IPC_HEADER_LEN];
+    if (body)
+        *body = &data[HEADER_SIZE];
+    if (body_len)
+        *body_len = n;
+
+    return HEADER_SIZE + n;
+}
+
+char *ipc_buffer_reserve(struct ipc_buffer *buf, size_t n)
+{
+    if (buf->cap - buf->start - buf->len >= n)
+        return buf->data + buf->start + buf->len;
+
+    // slide the pending bytes to the front before growing
+    if (buf->start) {
+        memmove(buf->data, buf->data + buf->start, buf->len);
+        buf->start = 0;
+        if (buf->cap - buf->len >= n)
+            return buf->data + buf->len;
+    }
+
+    size_t newcap = buf->cap ? buf->cap : 4096;
+    while (newcap - buf->len < n)
+        newcap *= 2;
+
+    char *newdata = realloc(buf->data, newcap);
+    if (!newdata)
         return NULL;
 
-    int hlen = sizeof(IPC_HEADER);
-    if (opcode) {
-        *opcode = msg[hlen];
+    buf->data = newdata;
+    buf->cap  = newcap;
+
+    return buf->data + buf->len;
+}
+
+bool ipc_buffer_append(struct ipc_buffer *buf, const void *data, size_t n)
+{
+    char *tail = ipc_buffer_reserve(buf, n);
+    if (!tail)
+        return false;
+
+    memcpy(tail, data, n);
+    buf->len += n;
+
+    return true;
+}
+
+bool ipc_buffer_append_message(struct ipc_buffer *buf,
+                               enum cwc_ipc_opcode opcode,
+                               const char *body,
+                               size_t n)
+{
+    if (n > IPC_MAX_BODY_SIZE)
+        return false;
+
+    char *tail = ipc_buffer_reserve(buf, HEADER_SIZE + n);
+    if (!tail)
+        return false;
+
+    ipc_write_header(tail, opcode, n);
+    memcpy(tail + HEADER_SIZE, body, n);
+    buf->len += HEADER_SIZE + n;
+
+    return true;
+}
+
+void ipc_buffer_consume(struct ipc_buffer *buf, size_t n)
+{
+    if (n >= buf->len) {
+        buf->start = 0;
+        buf->len   = 0;
+
+        if (buf->cap > IPC_BUFFER_KEEP_SIZE)
+            ipc_buffer_fini(buf);
+
+        return;
     }
 
-    return &msg[hlen + 2];
+    buf->start += n;
+    buf->len -= n;
+}
+
+bool ipc_signal_batch_repeat(struct ipc_buffer *batch,
+                             size_t last_len,
+                             const char *event,
+                             size_t len)
+{
+    if (!len || last_len != len || batch->len < len)
+        return false;
+
+    return memcmp(ipc_buffer_head(batch) + batch->len - len, event, len) == 0;
+}
+
+void ipc_buffer_fini(struct ipc_buffer *buf)
+{
+    free(buf->data);
+    *buf = (struct ipc_buffer){0};
 }
@@ -0,0 +1,356 @@
+/* ipc/query.c - native object snapshot for ipc client
+ *
+ * Copyright (C) 2025 Dwi Asmoro Bangun <dwiaceromo@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* The snapshot is written straight from the compositor struct into the output
+ * buffer as JSON so the query never touch the lua state.
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <wayland-util.h>
+#include <wlr/types/wlr_output.h>
+#include <wlr/util/box.h>
+
+#include "cwc/desktop/output.h"
+#include "cwc/desktop/toplevel.h"
+#include "cwc/ipc.h"
+#include "cwc/layout/container.h"
+#include "cwc/layout/master.h"
+#include "cwc/server.h"
+#include "cwc/types.h"
+#include "cwc/util.h"
+#include "private/server.h"
+
+static void json_printf(struct ipc_buffer *buf, const char *fmt, ...)
+{
+    char tmp[128];
+    va_list args;
+
+    va_start(args, fmt);
+    int n = vsnprintf(tmp, sizeof(tmp), fmt, args);
+    va_end(args);
+
+    if (n < 0)
+        return;
+
+    if ((size_t)n < sizeof(tmp)) {
+        ipc_buffer_append(buf, tmp, n);
+        return;
+    }
+
+    char *tail = ipc_buffer_reserve(buf, n + 1);
+    if (!tail)
+        return;
+
+    va_start(args, fmt);
+    vsnprintf(tail, n + 1, fmt, args);
+    va_end(args);
+    buf->len += n;
+}
+
+static void json_string(struct ipc_buffer *buf, const char *str)
+{
+    if (!str) {
+        ipc_buffer_append(buf, "null", 4);
+        return;
+    }
+
+    ipc_buffer_append(buf, "\"", 1);
+
+    const char *plain = str;
+    for (; *str; str++) {
+        unsigned char ch = *str;
+        if (ch >= 0x20 && ch != '"' && ch != '\\')
+            continue;
+
+        ipc_buffer_append(buf, plain, str - plain);
+        plain = str + 1;
+
+        switch (ch) {
+        case '"':
+            ipc_buffer_append(buf, "\\\"", 2);
+            break;
+        case '\\':
+            ipc_buffer_append(buf, "\\\\", 2);
+            break;
+        case '\n':
+            ipc_buffer_append(buf, "\\n", 2);
+            break;
+        case '\t':
+            ipc_buffer_append(buf, "\\t", 2);
+            break;
+        default:
+            json_printf(buf, "\\u%04x", ch);
+            break;
+        }
+    }
+
+    ipc_buffer_append(buf, plain, str - plain);
+    ipc_buffer_append(buf, "\"", 1);
+}
+
+static void json_key(struct ipc_buffer *buf, const char *key, bool first)
+{
+    json_printf(buf, first ? "\"%s\":" : ",\"%s\":", key);
+}
+
+static void json_key_string(struct ipc_buffer *buf,
+                            const char *key,
+                            const char *value)
+{
+    json_key(buf, key, false);
+    json_string(buf, value);
+}
+
+static void json_key_bool(struct ipc_buffer *buf, const char *key, bool value)
+{
+    json_printf(buf, ",\"%s\":%s", key, value ? "true" : "false");
+}
+
+static void json_key_int(struct ipc_buffer *buf, const char *key, long value)
+{
+    json_printf(buf, ",\"%s\":%ld", key, value);
+}
+
+static void json_key_box(struct ipc_buffer *buf,
+                         const char *key,
+                         struct wlr_box *box)
+{
+    json_printf(buf, ",\"%s\":{\"x\":%d,\"y\":%d,\"width\":%d,\"height\":%d}",
+                key, box->x, box->y, box->width, box->height);
+}
+
+static void json_key_ptr(struct ipc_buffer *buf, const char *key, void *ptr)
+{
+    if (ptr)
+        json_printf(buf, ",\"%s\":\"%p\"", key, ptr);
+    else
+        json_printf(buf, ",\"%s\":null", key);
+}
+
+static void query_client(struct ipc_buffer *buf, struct cwc_toplevel *toplevel)
+{
+    struct cwc_container *container = toplevel->container;
+    struct wlr_box geom             = cwc_toplevel_get_box(toplevel);
+
+    json_printf(buf, "{\"id\":\"%p\"", (void *)toplevel);
+    json_key_string(buf, "title", cwc_toplevel_get_title(toplevel));
+    json_key_string(buf, "appid", cwc_toplevel_get_app_id(toplevel));
+    json_key_int(buf, "pid", cwc_toplevel_get_pid(toplevel));
+    json_key_string(buf, "screen", container->output->wlr_output->name);
+    json_key_ptr(buf, "container", container);
+    json_key_ptr(buf, "parent", cwc_toplevel_get_parent(toplevel));
+    json_key_int(buf, "tag", container->tag);
+    json_key_int(buf, "workspace", container->workspace);
+    json_key_box(buf, "geometry", &geom);
+    json_printf(buf, ",\"opacity\":%.3f", cwc_toplevel_get_opacity(toplevel));
+    json_key_bool(buf, "mapped", cwc_toplevel_is_mapped(toplevel));
+    json_key_bool(buf, "visible", cwc_toplevel_is_visible(toplevel));
+    json_key_bool(buf, "x11", cwc_toplevel_is_x11(toplevel));
+    json_key_bool(buf, "unmanaged", cwc_toplevel_is_unmanaged(toplevel));
+    json_key_bool(buf, "fullscreen", cwc_toplevel_is_fullscreen(toplevel));
+    json_key_bool(buf, "maximized", cwc_toplevel_is_maximized(toplevel));
+    json_key_bool(buf, "floating", cwc_toplevel_is_floating(toplevel));
+    json_key_bool(buf, "minimized", cwc_toplevel_is_minimized(toplevel));
+    json_key_bool(buf, "sticky", cwc_toplevel_is_sticky(toplevel));
+    json_key_bool(buf, "urgent", cwc_toplevel_is_urgent(toplevel));
+    json_key_bool(buf, "focused", toplevel == cwc_toplevel_get_focused());
+    ipc_buffer_append(buf, "}", 1);
+}
+
+/* same order as cwc.client.get() */
+static void query_clients(struct ipc_buffer *buf)
+{
+    bool first = true;
+    struct cwc_toplevel *toplevel;
+
+    ipc_buffer_append(buf, "[", 1);
+    wl_list_for_each_reverse(toplevel, &server.toplevels, link)
+    {
+        if (!toplevel->container)
+            continue;
+
+        if (!first)
+            ipc_buffer_append(buf, ",", 1);
+        first = false;
+
+        query_client(buf, toplevel);
+    }
+    ipc_buffer_append(buf, "]", 1);
+}
+
+static void query_screen(struct ipc_buffer *buf, struct cwc_output *output)
+{
+    struct wlr_output *wlr_output = output->wlr_output;
+
+    json_printf(buf, "{\"id\":\"%p\"", (void *)output);
+    json_key_string(buf, "name", wlr_output->name);
+    json_key_string(buf, "description", wlr_output->description);
+    json_key_string(buf, "make", wlr_output->make);
+    json_key_string(buf, "model", wlr_output->model);
+    json_key_string(buf, "serial", wlr_output->serial);
+    json_key_bool(buf, "enabled", output->enabled);
+    json_key_bool(buf, "dpms", wlr_output->enabled);
+    json_key_int(buf, "width", wlr_output->width);
+    json_key_int(buf, "height", wlr_output->height);
+    json_key_int(buf, "refresh", wlr_output->refresh);
+    json_key_int(buf, "phys_width", wlr_output->phys_width);
+    json_key_int(buf, "phys_height", wlr_output->phys_height);
+    json_printf(buf, ",\"scale\":%.3f", wlr_output->scale);
+    json_key_box(buf, "geometry", &output->output_layout_box);
+    json_key_box(buf, "workarea", &output->usable_area);
+    json_key_int(buf, "active_tag", output->state->active_tag);
+    json_key_int(buf, "active_workspace", output->state->active_workspace);
+    json_key_int(buf, "max_general_workspace",
+                 output->state->max_general_workspace);
+    json_key_bool(buf, "restored", output->restored);
+    json_key_bool(buf, "non_desktop", wlr_output->non_desktop);
+    json_key_bool(buf, "allow_tearing", output->tearing_allowed);
+    json_key_bool(buf, "adaptive_sync",
+                  wlr_output->adaptive_sync_status
+                      == WLR_OUTPUT_ADAPTIVE_SYNC_ENABLED);
+    json_key_bool(buf, "focused", output == server.focused_output);
+    ipc_buffer_append(buf, "}", 1);
+}
+
+static void query_screens(struct ipc_buffer *buf)
+{
+    bool first = true;
+    struct cwc_output *output;
+
+    ipc_buffer_append(buf, "[", 1);
+    wl_list_for_each(output, &server.outputs, link)
+    {
+        if (!first)
+            ipc_buffer_append(buf, ",", 1);
+        first = false;
+
+        query_screen(buf, output);
+    }
+    ipc_buffer_append(buf, "]", 1);
+}
+
+static const char *layout_mode_name[CWC_LAYOUT_LENGTH] = {
+    [CWC_LAYOUT_FLOATING] = "floating",
+    [CWC_LAYOUT_MASTER]   = "master",
+    [CWC_LAYOUT_BSP]      = "bsp",
+};
+
+static void query_tag(struct ipc_buffer *buf,
+                      struct cwc_output *output,
+                      struct cwc_tag_info *tag)
+{
+    struct master_state *master = &tag->master_state;
+
+    json_key(buf, "screen", true);
+    json_string(buf, output->wlr_output->name);
+    json_key_int(buf, "index", tag->index);
+    json_key_string(buf, "label", tag->label);
+    json_key_bool(buf, "active",
+                  output->state->active_tag & (1 << (tag->index - 1)));
+    json_key_bool(buf, "selected",
+                  output->state->active_workspace == tag->index);
+    json_key_bool(buf, "hidden", tag->hidden);
+    json_key_int(buf, "client_count", tag->client_count);
+    json_key_int(buf, "urgent_count", tag->urgent_count);
+    json_key_int(buf, "focused_count", tag->focused_count);
+    json_key_string(buf, "layout_mode", layout_mode_name[tag->layout_mode]);
+    json_key_string(buf, "layout",
+                    master->current_layout ? master->current_layout->name
+                                           : NULL);
+    json_key_int(buf, "useless_gaps", tag->useless_gaps);
+    json_printf(buf, ",\"mwfact\":%.3f", master->mwfact);
+    json_key_int(buf, "master_count", master->master_count);
+    json_key_int(buf, "column_count", master->column_count);
+}
+
+/* the general workspace of every screen */
+static void query_tags(struct ipc_buffer *buf)
+{
+    bool first = true;
+    struct cwc_output *output;
+
+    ipc_buffer_append(buf, "[", 1);
+    wl_list_for_each(output, &server.outputs, link)
+    {
+        for (int i = 1; i <= output->state->max_general_workspace; i++) {
+            ipc_buffer_append(buf, first ? "{" : ",{", first ? 1 : 2);
+            first = false;
+
+            query_tag(buf, output, cwc_output_get_tag(output, i));
+            ipc_buffer_append(buf, "}", 1);
+        }
+    }
+    ipc_buffer_append(buf, "]", 1);
+}
+
+struct query_pools_data {
+    struct ipc_buffer *buf;
+    bool first;
+};
+
+static void query_pool(struct cwc_pool *pool, void *data)
+{
+    struct query_pools_data *q = data;
+    struct ipc_buffer *buf     = q->buf;
+
+    ipc_buffer_append(buf, q->first ? "{" : ",{", q->first ? 1 : 2);
+    q->first = false;
+
+    json_key(buf, "name", true);
+    json_string(buf, pool->name);
+    json_key_int(buf, "size", pool->elem_size);
+    json_key_int(buf, "live", pool->stats.live);
+    json_key_int(buf, "peak", pool->stats.peak);
+    json_key_int(buf, "reuse", pool->stats.reuse);
+    json_key_int(buf, "allocs", pool->stats.allocs);
+    json_key_int(buf, "slabs", pool->stats.slabs);
+    json_key_int(buf, "capacity", pool->stats.slabs * pool->slab_len);
+    ipc_buffer_append(buf, "}", 1);
+}
+
+/* pool that never allocate is not listed */
+static void query_pools(struct ipc_buffer *buf)
+{
+    struct query_pools_data data = {.buf = buf, .first = true};
+
+    ipc_buffer_append(buf, "[", 1);
+    cwc_pool_for_each(query_pool, &data);
+    ipc_buffer_append(buf, "]", 1);
+}
+
+bool ipc_query_snapshot(struct ipc_buffer *buf, const char *kind, size_t len)
+{
+#define IS_KIND(name) (len == strlen(name) && memcmp(kind, name, len) == 0)
+
+    if (IS_KIND("clients"))
+        query_clients(buf);
+    else if (IS_KIND("screens"))
+        query_screens(buf);
+    else if (IS_KIND("tags"))
+        query_tags(buf);
+    else if (IS_KIND("pools"))
+        query_pools(buf);
+    else
+        return false;
+
+#undef IS_KIND
+
+    return true;
+}
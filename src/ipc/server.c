@@ -16,6 +16,9 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#define _GNU_SOURCE
+
+#include <errno.h>
 #include <fcntl.h>
 #include <lauxlib.h>
 #include <lua.h>
@@ -28,22 +31,64 @@
 #include <unistd.h>
 #include <wayland-server-core.h>
 #include <wayland-util.h>
+#include <xxhash.h>
 
 #include "cwc/config.h"
 #include "cwc/ipc.h"
+#include "cwc/luac.h"
 #include "cwc/server.h"
+#include "cwc/signal.h"
 #include "cwc/util.h"
 #include "lauxlib.h"
+#include "private/server.h"
 
-#define BUFFER_SIZE 1e6
+#define READ_CHUNK_SIZE 65536
+/* stop reading request when the client doesn't read the responses */
+#define OUTPUT_HIGH_WATERMARK (16 << 20)
+/* drop signal event when the client has this much unread data */
+#define SIGNAL_BACKLOG_LIMIT (1 << 20)
+/* compiled IPC_EVAL chunk kept around */
+#define IPC_EVAL_CACHE_SIZE 64
 
 struct wl_list client_list;
 struct ipc_client {
     struct wl_list link; // client_list
     int fd;
     struct wl_event_source *event_source;
+    uint32_t event_mask;
+
+    struct ipc_buffer in;
+    struct ipc_buffer out;
+    bool read_closed; // peer stopped sending, close once out is drained
+
+    /* subscribed signal name, NULL if never subscribe */
+    struct cwc_strmap *subscriptions;
+    /* events waiting for the next flush and the length of the last one */
+    struct ipc_buffer signal_batch;
+    size_t batch_last_len;
+    uint32_t dropped_events;
 };
 
+static struct wl_event_source *signal_flush_idle = NULL;
+static struct ipc_buffer event_scratch;
+
+static void ipc_flush_signal_batches(void *data);
+
+static void ipc_client_unsubscribe_all(struct ipc_client *c)
+{
+    if (!c->subscriptions)
+        return;
+
+    struct cwc_strmap *map = c->subscriptions;
+    for (uint64_t i = 0; i < map->alloc; i++) {
+        if (cwc_strmap_slot_is_full(map, i))
+            cwc_signal_ipc_unsubscribe(map->table[i].key);
+    }
+
+    cwc_strmap_destroy(map);
+    c->subscriptions = NULL;
+}
+
 static void ipc_client_close(struct ipc_client *c)
 {
     cwc_log(CWC_DEBUG, "closing ipc connection for fd: %d", c->fd);
@@ -53,80 +98,553 @@ static void ipc_client_close(struct ipc_client *c)
     wl_list_remove(&c->link);
     wl_event_source_remove(c->event_source);
 
+    ipc_client_unsubscribe_all(c);
+
+    ipc_buffer_fini(&c->signal_batch);
+    ipc_buffer_fini(&c->in);
+    ipc_buffer_fini(&c->out);
     free(c);
 }
 
-static void handle_eval_msg(int fd, char *msg_buffer)
+static void ipc_client_update_mask(struct ipc_client *c)
+{
+    uint32_t mask = 0;
+    if (!c->read_closed && c->out.len < OUTPUT_HIGH_WATERMARK)
+        mask |= WL_EVENT_READABLE;
+    if (c->out.len)
+        mask |= WL_EVENT_WRITABLE;
+
+    if (mask == c->event_mask)
+        return;
+
+    c->event_mask = mask;
+    wl_event_source_fd_update(c->event_source, mask);
+}
+
+/* write as much as the socket accept, return false on error */
+static bool ipc_client_flush(struct ipc_client *c)
+{
+    while (c->out.len) {
+        ssize_t n = send(c->fd, ipc_buffer_head(&c->out), c->out.len,
+                         MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                break;
+
+            return false;
+        }
+
+        ipc_buffer_consume(&c->out, n);
+    }
+
+    // the client caught up, let it know about the dropped events
+    if (c->dropped_events && c->out.len < SIGNAL_BACKLOG_LIMIT
+        && !signal_flush_idle)
+        signal_flush_idle = wl_event_loop_add_idle(
+            server.wl_event_loop, ipc_flush_signal_batches, NULL);
+
+    ipc_client_update_mask(c);
+    return true;
+}
+
+static void ipc_client_send(struct ipc_client *c,
+                            enum cwc_ipc_opcode opcode,
+                            const char *body,
+                            size_t len)
+{
+    if (!ipc_buffer_append_message(&c->out, opcode, body, len)) {
+        cwc_log(CWC_ERROR, "failed to queue %zu bytes ipc response for fd: %d",
+                len, c->fd);
+        ipc_buffer_append_message(&c->out, opcode, "", 0);
+    }
+}
+
+/* compiled IPC_EVAL chunk, the monitoring kind of client send the same few
+ * expression over and over so keep them to skip the parser.
+ */
+struct eval_chunk {
+    struct wl_list link; // eval_cache_lru, most recently used first
+    uint64_t hash;
+    char *source; // to tell apart hash collision
+    size_t len;
+    int luaref;
+};
+
+static struct cwc_imap *eval_cache = NULL; // struct eval_chunk
+static struct wl_list eval_cache_lru;
+static int eval_cache_len = 0;
+
+static void eval_chunk_destroy(struct eval_chunk *chunk, lua_State *L)
+{
+    if (L)
+        luaL_unref(L, LUA_REGISTRYINDEX, chunk->luaref);
+
+    cwc_imap_remove(eval_cache, chunk->hash);
+    wl_list_remove(&chunk->link);
+    eval_cache_len--;
+    free(chunk->source);
+    free(chunk);
+}
+
+/* the refs die with the old lua state so just forget them */
+static void eval_cache_clear(void *data)
+{
+    struct eval_chunk *chunk, *tmp;
+    wl_list_for_each_safe(chunk, tmp, &eval_cache_lru, link)
+    {
+        eval_chunk_destroy(chunk, NULL);
+    }
+}
+
+/* push the compiled chunk of the source, return non zero with the error
+ * message pushed when it doesn't compile.
+ */
+static int eval_cache_load(lua_State *L, const char *src, size_t len)
 {
-    const char *body = ipc_get_body(msg_buffer, NULL);
+    uint64_t hash             = XXH3_64bits(src, len);
+    struct eval_chunk *cached = cwc_imap_get(eval_cache, hash);
 
-    lua_State *L        = g_config_get_lua_State();
+    if (cached && cached->len == len && memcmp(cached->source, src, len) == 0) {
+        wl_list_remove(&cached->link);
+        wl_list_insert(&eval_cache_lru, &cached->link);
+        lua_rawgeti(L, LUA_REGISTRYINDEX, cached->luaref);
+        return 0;
+    }
+
+    int error = luaL_loadbuffer(L, src, len, "=ipc");
+    // don't bother with collision, it's just not cached
+    if (error || cached)
+        return error;
+
+    if (eval_cache_len >= IPC_EVAL_CACHE_SIZE) {
+        struct eval_chunk *lru =
+            wl_container_of(eval_cache_lru.prev, lru, link);
+        eval_chunk_destroy(lru, L);
+    }
+
+    struct eval_chunk *chunk = malloc(sizeof(*chunk));
+    char *source             = malloc(len ? len : 1);
+    if (!chunk || !source) {
+        free(chunk);
+        free(source);
+        return 0;
+    }
+
+    memcpy(source, src, len);
+    chunk->hash   = hash;
+    chunk->source = source;
+    chunk->len    = len;
+    lua_pushvalue(L, -1);
+    chunk->luaref = luaL_ref(L, LUA_REGISTRYINDEX);
+
+    cwc_imap_insert(eval_cache, hash, chunk);
+    wl_list_insert(&eval_cache_lru, &chunk->link);
+    eval_cache_len++;
+
+    return 0;
+}
+
+/* call the function below nargs arguments on top of the stack and answer
+ * with the last returned value.
+ */
+static void ipc_client_call(struct ipc_client *c,
+                            lua_State *L,
+                            int nargs,
+                            int stack_size)
+{
     size_t returned_len = 0;
-    int stack_size      = lua_gettop(L);
-    int error           = luaL_dostring(L, body);
-    if (error) {
+    const char *res     = "";
+
+    if (lua_pcall(L, nargs, LUA_MULTRET, 0)) {
         cwc_log(CWC_ERROR, "%s", lua_tostring(L, -1));
-        const char *dostring_res = lua_tolstring(L, -1, &returned_len);
-        returned_len =
-            ipc_create_message_n(msg_buffer, BUFFER_SIZE, IPC_EVAL_RESPONSE,
-                                 dostring_res, returned_len);
+        res = lua_tolstring(L, -1, &returned_len);
     } else if (stack_size != lua_gettop(L)) {
-        lua_getglobal(L, "tostring");
-        lua_pushvalue(L, -2);
-        if (lua_pcall(L, 1, 1, 0) != LUA_OK) {
-            cwc_log(CWC_ERROR, "%s", lua_tostring(L, -1));
-            goto send_response;
+        switch (lua_type(L, -1)) {
+        case LUA_TNUMBER:
+        case LUA_TSTRING:
+            res = lua_tolstring(L, -1, &returned_len);
+            break;
+        case LUA_TNIL:
+            res          = "nil";
+            returned_len = 3;
+            break;
+        case LUA_TBOOLEAN:
+            res          = lua_toboolean(L, -1) ? "true" : "false";
+            returned_len = strlen(res);
+            break;
+        default:
+            lua_getglobal(L, "tostring");
+            lua_pushvalue(L, -2);
+            if (lua_pcall(L, 1, 1, 0)) {
+                cwc_log(CWC_ERROR, "%s", lua_tostring(L, -1));
+                break;
+            }
+
+            res = lua_tolstring(L, -1, &returned_len);
+            break;
         }
+    }
 
-        const char *dostring_res = lua_tolstring(L, -1, &returned_len);
-        returned_len =
-            ipc_create_message_n(msg_buffer, BUFFER_SIZE, IPC_EVAL_RESPONSE,
-                                 dostring_res, returned_len);
-    } else {
-        returned_len = ipc_create_message_n(msg_buffer, BUFFER_SIZE,
-                                            IPC_EVAL_RESPONSE, "", 0);
+    ipc_client_send(c, IPC_EVAL_RESPONSE, res ? res : "", returned_len);
+    lua_settop(L, stack_size);
+}
+
+static void handle_eval_msg(struct ipc_client *c, const char *body, size_t len)
+{
+    lua_State *L   = g_config_get_lua_State();
+    int stack_size = lua_gettop(L);
+
+    if (eval_cache_load(L, body, len)) {
+        cwc_log(CWC_ERROR, "%s", lua_tostring(L, -1));
+        size_t returned_len;
+        const char *res = lua_tolstring(L, -1, &returned_len);
+        ipc_client_send(c, IPC_EVAL_RESPONSE, res, returned_len);
+        lua_settop(L, stack_size);
+        return;
+    }
+
+    ipc_client_call(c, L, 0, stack_size);
+}
+
+/* body is the function name and the arguments, all null separated */
+static void handle_call_msg(struct ipc_client *c, const char *body, size_t len)
+{
+    lua_State *L    = g_config_get_lua_State();
+    int stack_size  = lua_gettop(L);
+    const char *end = body + len;
+
+    const char *name_end = memchr(body, '\0', len);
+    size_t name_len      = (name_end ? name_end : end) - body;
+
+    lua_getfield(L, LUA_REGISTRYINDEX, LUAC_IPC_FUNCTION_REGISTRY_KEY);
+    if (lua_istable(L, -1)) {
+        lua_pushlstring(L, body, name_len);
+        lua_rawget(L, -2);
     }
 
-send_response:
-    send(fd, msg_buffer, returned_len, 0);
+    if (!lua_isfunction(L, -1)) {
+        char err[128];
+        int n = snprintf(err, sizeof(err), "no ipc function named \"%.*s\"",
+                         (int)(name_len > 64 ? 64 : name_len), body);
+        cwc_log(CWC_ERROR, "%s", err);
+        ipc_client_send(c, IPC_EVAL_RESPONSE, err, n);
+        lua_settop(L, stack_size);
+        return;
+    }
+
+    lua_replace(L, stack_size + 1);
+    lua_settop(L, stack_size + 1);
+
+    // every separator start an argument, including an empty last one
+    int nargs = 0;
+    for (const char *sep = name_end; sep && lua_checkstack(L, 1); nargs++) {
+        const char *arg = sep + 1;
+        sep             = memchr(arg, '\0', end - arg);
+        lua_pushlstring(L, arg, (sep ? sep : end) - arg);
+    }
+
+    ipc_client_call(c, L, nargs, stack_size);
+}
+
+/* the snapshot is written in place right after the frame header */
+static void handle_query_msg(struct ipc_client *c, const char *body, size_t len)
+{
+    size_t header_at = c->out.len;
+    if (!ipc_buffer_reserve(&c->out, HEADER_SIZE)) {
+        static const char msg[] = "out of memory";
+        ipc_client_send(c, IPC_ERROR, msg, sizeof(msg) - 1);
+        return;
+    }
+    c->out.len += HEADER_SIZE;
+
+    if (!ipc_query_snapshot(&c->out, body, len)) {
+        c->out.len = header_at;
+
+        char msg[128];
+        int n = snprintf(msg, sizeof(msg),
+                         "unknown query \"%.*s\", use clients, screens, tags "
+                         "or pools",
+                         (int)(len > 64 ? 64 : len), body);
+        ipc_client_send(c, IPC_ERROR, msg, n);
+        return;
+    }
+
+    size_t body_len = c->out.len - header_at - HEADER_SIZE;
+    ipc_write_header(ipc_buffer_head(&c->out) + header_at, IPC_QUERY_RESPONSE,
+                     body_len);
+}
+
+/* body is newline separated signal name, prefix with '-' to unsubscribe */
+static void
+handle_signal_msg(struct ipc_client *c, const char *body, size_t len)
+{
+    if (!c->subscriptions)
+        c->subscriptions = cwc_strmap_create(8);
+
+    const char *end = body + len;
+    while (body < end) {
+        const char *newline = memchr(body, '\n', end - body);
+        size_t line_len     = (newline ? newline : end) - body;
+
+        bool unsubscribe = line_len && body[0] == '-';
+        char *name       = strndup(body + unsubscribe, line_len - unsubscribe);
+        body += line_len + 1;
+
+        if (!name[0]) {
+            free(name);
+            continue;
+        }
+
+        bool subscribed = cwc_strmap_get_entry(c->subscriptions, name);
+        if (unsubscribe && subscribed) {
+            cwc_strmap_remove(c->subscriptions, name);
+            cwc_signal_ipc_unsubscribe(name);
+        } else if (!unsubscribe && !subscribed) {
+            cwc_strmap_insert(c->subscriptions, name, c);
+            cwc_signal_ipc_subscribe(name);
+        }
+
+        free(name);
+    }
+}
+
+/* process every complete frame in the input buffer, return false if the
+ * stream is corrupted.
+ */
+static bool ipc_client_process(struct ipc_client *c)
+{
+    while (c->in.len && c->out.len < OUTPUT_HIGH_WATERMARK) {
+        enum cwc_ipc_opcode opcode;
+        const char *body;
+        uint32_t body_len;
+        long frame_len = ipc_parse_frame(ipc_buffer_head(&c->in), c->in.len,
+                                         &opcode, &body, &body_len);
+        if (frame_len < 0) {
+            cwc_log(CWC_ERROR, "invalid ipc message from fd: %d", c->fd);
+            return false;
+        }
+
+        if (frame_len == 0)
+            break;
+
+        switch (opcode) {
+        case IPC_EVAL:
+            handle_eval_msg(c, body, body_len);
+            break;
+        case IPC_SIGNAL:
+            handle_signal_msg(c, body, body_len);
+            break;
+        case IPC_CALL:
+            handle_call_msg(c, body, body_len);
+            break;
+        case IPC_QUERY:
+            handle_query_msg(c, body, body_len);
+            break;
+        default:
+            break;
+        }
+
+        ipc_buffer_consume(&c->in, frame_len);
+    }
+
+    return true;
+}
+
+/* read until the socket is drained, return false when the peer is gone */
+static bool ipc_client_read(struct ipc_client *c)
+{
+    while (true) {
+        char *tail = ipc_buffer_reserve(&c->in, READ_CHUNK_SIZE);
+        if (!tail)
+            return false;
+
+        ssize_t n = recv(c->fd, tail, READ_CHUNK_SIZE, MSG_DONTWAIT);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+
+        if (n == 0)
+            return false;
+
+        c->in.len += n;
+    }
 }
 
 static int ipc_handle_client_msg(int fd, uint32_t mask, void *data)
 {
     struct ipc_client *c = data;
-    if (mask & WL_EVENT_ERROR || mask & WL_EVENT_HANGUP) {
+
+    if (mask & WL_EVENT_READABLE && !c->read_closed)
+        c->read_closed = !ipc_client_read(c);
+
+    // answer what already arrived even when the peer stop sending, keep going
+    // as long as the socket take the responses
+    do {
+        if (!ipc_client_process(c) || !ipc_client_flush(c)) {
+            ipc_client_close(c);
+            return 0;
+        }
+    } while (c->out.len < OUTPUT_HIGH_WATERMARK
+             && ipc_parse_frame(ipc_buffer_head(&c->in), c->in.len, NULL, NULL,
+                                NULL)
+                    > 0);
+
+    // a half closed peer still get the queued responses
+    if (mask & WL_EVENT_ERROR || mask & WL_EVENT_HANGUP
+        || (c->read_closed && !c->out.len))
         ipc_client_close(c);
-        return 0;
-    }
 
-    char *msg_buffer     = malloc(BUFFER_SIZE + 1);
-    int read_len         = read(fd, msg_buffer, BUFFER_SIZE);
-    msg_buffer[read_len] = 0;
+    return 0;
+}
 
-    enum cwc_ipc_opcode opcode;
-    const char *body = ipc_get_body(msg_buffer, &opcode);
-    if (!body) {
-        cwc_log(CWC_ERROR, "ipc message error: %s", msg_buffer);
-        goto free_and_exit;
+static void event_append_escaped(struct ipc_buffer *buf,
+                                 const char *str,
+                                 size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        char ch = str[i];
+        switch (ch) {
+        case '\t':
+            ipc_buffer_append(buf, "\\t", 2);
+            break;
+        case '\n':
+            ipc_buffer_append(buf, "\\n", 2);
+            break;
+        case '\\':
+            ipc_buffer_append(buf, "\\\\", 2);
+            break;
+        default:
+            ipc_buffer_append(buf, &ch, 1);
+        }
     }
+}
 
-    switch (opcode) {
-    case IPC_EVAL:
-        handle_eval_msg(fd, msg_buffer);
+/* write the lua value at idx without calling into lua */
+static void event_append_value(struct ipc_buffer *buf, lua_State *L, int idx)
+{
+    char tmp[64];
+    int n = 0;
+
+    switch (lua_type(L, idx)) {
+    case LUA_TNIL:
+        n = snprintf(tmp, sizeof(tmp), "nil");
+        break;
+    case LUA_TBOOLEAN:
+        n = snprintf(tmp, sizeof(tmp), "%s",
+                     lua_toboolean(L, idx) ? "true" : "false");
+        break;
+    case LUA_TNUMBER:
+        n = snprintf(tmp, sizeof(tmp), "%.14g", lua_tonumber(L, idx));
         break;
+    case LUA_TSTRING: {
+        size_t len;
+        const char *str = lua_tolstring(L, idx, &len);
+        event_append_escaped(buf, str, len);
+        return;
+    }
+    case LUA_TUSERDATA:
+        // only cwc object has __name, see luaC_register_class
+        if (luaL_getmetafield(L, idx, "__name")) {
+            struct luaC_object_udata *udata = lua_touserdata(L, idx);
+            n = snprintf(tmp, sizeof(tmp), "%s:%p", lua_tostring(L, -1),
+                         udata->pointer);
+            lua_pop(L, 1);
+            break;
+        }
+        // fallthrough
     default:
+        n = snprintf(tmp, sizeof(tmp), "%s:%p", luaL_typename(L, idx),
+                     lua_topointer(L, idx));
         break;
     }
 
-free_and_exit:
-    free(msg_buffer);
-    return 0;
+    ipc_buffer_append(buf, tmp, n);
+}
+
+static void ipc_flush_signal_batches(void *data)
+{
+    signal_flush_idle = NULL;
+
+    struct ipc_client *c, *tmp;
+    wl_list_for_each_safe(c, tmp, &client_list, link)
+    {
+        if (!c->signal_batch.len && !c->dropped_events)
+            continue;
+
+        // tell what's lost once the client has room again
+        if (c->dropped_events && c->out.len < SIGNAL_BACKLOG_LIMIT) {
+            char notice[32];
+            int n = snprintf(notice, sizeof(notice), "!dropped\t%u\n",
+                             c->dropped_events);
+            ipc_buffer_append(&c->signal_batch, notice, n);
+            c->dropped_events = 0;
+        }
+
+        if (c->signal_batch.len)
+            ipc_buffer_append_message(&c->out, IPC_SIGNAL,
+                                      ipc_buffer_head(&c->signal_batch),
+                                      c->signal_batch.len);
+
+        ipc_buffer_consume(&c->signal_batch, c->signal_batch.len);
+        c->batch_last_len = 0;
+
+        if (!ipc_client_flush(c) || (c->read_closed && !c->out.len))
+            ipc_client_close(c);
+    }
+}
+
+void ipc_signal_forward(const char *name, lua_State *L, int nargs)
+{
+    struct ipc_buffer *ev = &event_scratch;
+    ipc_buffer_consume(ev, ev->len);
+
+    event_append_escaped(ev, name, strlen(name));
+    int top = L ? lua_gettop(L) : 0;
+    for (int i = top - nargs + 1; i <= top; i++) {
+        ipc_buffer_append(ev, "\t", 1);
+        event_append_value(ev, L, i);
+    }
+    ipc_buffer_append(ev, "\n", 1);
+
+    if (!ev->data)
+        return;
+
+    struct ipc_client *c;
+    wl_list_for_each(c, &client_list, link)
+    {
+        if (!c->subscriptions || !cwc_strmap_get_entry(c->subscriptions, name))
+            continue;
+
+        // same event right before it in this batch
+        if (ipc_signal_batch_repeat(&c->signal_batch, c->batch_last_len,
+                                    ipc_buffer_head(ev), ev->len))
+            continue;
+
+        // never block the emitter, slow consumer lose events instead
+        if (c->dropped_events
+            || c->out.len + c->signal_batch.len >= SIGNAL_BACKLOG_LIMIT
+            || !ipc_buffer_append(&c->signal_batch, ipc_buffer_head(ev),
+                                  ev->len)) {
+            c->dropped_events++;
+        } else {
+            c->batch_last_len = ev->len;
+        }
+
+        if (!signal_flush_idle)
+            signal_flush_idle = wl_event_loop_add_idle(
+                server.wl_event_loop, ipc_flush_signal_batches, NULL);
+    }
 }
 
 static int ipc_handle_new_conn(int fd, uint32_t mask, void *data)
 {
     struct cwc_server *s = data;
-    int client_fd        = accept(fd, NULL, NULL);
+    int client_fd = accept4(fd, NULL, NULL, SOCK_CLOEXEC | SOCK_NONBLOCK);
 
     if (client_fd < 0)
         return 0;
@@ -139,7 +657,8 @@ static int ipc_handle_new_conn(int fd, uint32_t mask, void *data)
 
     cwc_log(CWC_DEBUG, "new ipc connection with fd: %d", client_fd);
 
-    c->fd = client_fd;
+    c->fd         = client_fd;
+    c->event_mask = WL_EVENT_READABLE;
     c->event_source =
         wl_event_loop_add_fd(s->wl_event_loop, client_fd, WL_EVENT_READABLE,
                              ipc_handle_client_msg, c);
@@ -157,6 +676,9 @@ void setup_ipc(struct cwc_server *s)
                               getenv("XDG_RUNTIME_DIR"), getuid(), getpid());
 
     wl_list_init(&client_list);
+    wl_list_init(&eval_cache_lru);
+    eval_cache = cwc_imap_create(IPC_EVAL_CACHE_SIZE);
+    cwc_signal_connect("lua::reload", eval_cache_clear);
 
     if (result_len >= path_len) {
         cwc_log(CWC_ERROR, "socket path to long");
@@ -203,12 +725,22 @@ void setup_ipc(struct cwc_server *s)
 
 void cleanup_ipc(struct cwc_server *s)
 {
-    struct ipc_client *c;
-    wl_list_for_each(c, &client_list, link)
+    struct ipc_client *c, *tmp;
+    wl_list_for_each_safe(c, tmp, &client_list, link)
     {
         ipc_client_close(c);
     }
 
+    if (signal_flush_idle) {
+        wl_event_source_remove(signal_flush_idle);
+        signal_flush_idle = NULL;
+    }
+    ipc_buffer_fini(&event_scratch);
+
+    eval_cache_clear(NULL);
+    cwc_imap_destroy(eval_cache);
+    eval_cache = NULL;
+
     if (!s->socket_fd)
         return;
 
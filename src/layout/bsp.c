@@ -28,6 +28,8 @@
 #include "cwc/util.h"
 #include "wlr/util/edges.h"
 
+CWC_POOL_DEFINE(bsp_node, struct bsp_node, 64)
+
 static inline struct bsp_node *
 bsp_node_get_sibling(struct bsp_node *parent_node, struct bsp_node *me)
 {
@@ -48,7 +50,7 @@ static void bsp_node_destroy(struct bsp_node *node)
     if (node->container)
         node->container->bsp_node = NULL;
 
-    free(node);
+    bsp_node_free(node);
 }
 
 static inline void bsp_node_reparent(struct bsp_node *parent,
@@ -95,8 +97,41 @@ static inline void bsp_node_set_size(struct bsp_node *node, int w, int h)
     node->height = h;
 }
 
-static inline void bsp_node_leaf_configure(
-    struct bsp_node *node, int x, int y, int width, int height)
+static inline bool bsp_node_box_equal(struct bsp_node *node,
+                                      struct wlr_box *box)
+{
+    return node->x == box->x && node->y == box->y && node->width == box->width
+           && node->height == box->height;
+}
+
+/* the container may be moved outside of the bsp (e.g. maximize, layout switch
+ * or gaps change) so compare with the actual container geometry too.
+ */
+static bool bsp_leaf_needs_configure(struct bsp_node *node, struct wlr_box *box)
+{
+    if (node->dirty || !bsp_node_box_equal(node, box))
+        return true;
+
+    struct cwc_container *container = node->container;
+    struct wlr_box *layout_box      = &container->output->output_layout_box;
+    int gaps = cwc_output_get_current_tag_info(container->output)->useless_gaps;
+
+    struct wlr_box expected = {
+        .x      = box->x + layout_box->x + gaps,
+        .y      = box->y + layout_box->y + gaps,
+        .width  = box->width,
+        .height = box->height,
+    };
+    // a too small box is clamped so it'll never match the requested size
+    cwc_container_clamp_tiled_size(container, &expected.width,
+                                   &expected.height);
+    struct wlr_box current = cwc_container_get_box(container);
+
+    return !wlr_box_equal(&expected, &current);
+}
+
+static inline void bsp_node_leaf_configure(struct bsp_node *node,
+                                           struct wlr_box *box)
 {
     struct cwc_container *container = node->container;
 
@@ -106,12 +141,14 @@ static inline void bsp_node_leaf_configure(
     if (!cwc_container_is_floating(container)
         && cwc_output_get_current_tag_info(container->output)->layout_mode
                == CWC_LAYOUT_BSP) {
-        struct wlr_box box = {x, y, width, height};
-        cwc_container_set_box_gap(container, &box);
+        if (bsp_leaf_needs_configure(node, box))
+            cwc_container_set_box_gap(container, box);
+
+        node->dirty = false;
     }
 
-    bsp_node_set_position(node, x, y);
-    bsp_node_set_size(node, width, height);
+    bsp_node_set_position(node, box->x, box->y);
+    bsp_node_set_size(node, box->width, box->height);
 }
 
 static struct bsp_node *_bsp_node_leaf_get(struct bsp_node *node, bool to_left)
@@ -134,72 +171,88 @@ static inline struct bsp_node *find_closes_leaf_sibling(struct bsp_node *me)
     return _bsp_node_leaf_get(parent->right, true);
 }
 
-static void bsp_update_node(struct bsp_node *parent)
+static void _bsp_update_node(struct bsp_node *parent, bool prune);
+
+static void
+bsp_update_child(struct bsp_node *node, struct wlr_box *box, bool prune)
 {
-    struct bsp_node *left  = parent->left;
-    struct bsp_node *right = parent->right;
+    if (!node->enabled) {
+        // keep the area so it's ready when enabled again
+        bsp_node_set_position(node, box->x, box->y);
+        bsp_node_set_size(node, box->width, box->height);
+        return;
+    }
 
-    left->x = parent->x;
-    left->y = parent->y;
+    if (node->type == BSP_NODE_LEAF) {
+        bsp_node_leaf_configure(node, box);
+        return;
+    }
+
+    // nothing inside can change when the area stay the same
+    if (prune && !node->dirty && bsp_node_box_equal(node, box))
+        return;
+
+    bsp_node_set_position(node, box->x, box->y);
+    bsp_node_set_size(node, box->width, box->height);
+    _bsp_update_node(node, prune);
+}
+
+static void _bsp_update_node(struct bsp_node *parent, bool prune)
+{
+    struct wlr_box left  = {.x = parent->x, .y = parent->y};
+    struct wlr_box right = left;
 
     // calculate width and height for left and right according to left width
     // factor
     switch (parent->split_type) {
     case BSP_SPLIT_HORIZONTAL:
-        left->width  = parent->width * parent->left_wfact;
-        left->height = parent->height;
+        left.width  = parent->width * parent->left_wfact;
+        left.height = parent->height;
 
-        right->width  = parent->width - left->width;
-        right->height = parent->height;
-        right->x      = left->x + left->width;
-        right->y      = left->y;
+        right.width  = parent->width - left.width;
+        right.height = parent->height;
+        right.x      = left.x + left.width;
         break;
     case BSP_SPLIT_VERTICAL:
-        left->width  = parent->width;
-        left->height = parent->height * parent->left_wfact;
+        left.width  = parent->width;
+        left.height = parent->height * parent->left_wfact;
 
-        right->width  = parent->width;
-        right->height = parent->height - left->height;
-        right->x      = left->x;
-        right->y      = left->y + left->height;
+        right.width  = parent->width;
+        right.height = parent->height - left.height;
+        right.y      = left.y + left.height;
         break;
     case BSP_SPLIT_AUTO:
         unreachable_();
         break;
     }
 
-    if (!right->enabled) {
-        left->width  = parent->width;
-        left->height = parent->height;
+    if (!parent->right->enabled) {
+        left.width  = parent->width;
+        left.height = parent->height;
     }
 
-    if (left->enabled) {
-        // update position/size for left
-        if (left->type == BSP_NODE_LEAF) {
-            bsp_node_leaf_configure(left, parent->x, parent->y, left->width,
-                                    left->height);
-        } else {
-            bsp_node_set_position(left, parent->x, parent->y);
-            bsp_update_node(left);
-        }
-    } else {
-        right->x      = parent->x;
-        right->y      = parent->y;
-        right->width  = parent->width;
-        right->height = parent->height;
+    if (!parent->left->enabled) {
+        right.x      = parent->x;
+        right.y      = parent->y;
+        right.width  = parent->width;
+        right.height = parent->height;
     }
 
-    if (right->enabled) {
-        // update position/size for right
-        if (right->type == BSP_NODE_LEAF) {
-            bsp_node_leaf_configure(right, right->x, right->y, right->width,
-                                    right->height);
-        } else {
-            bsp_update_node(right);
-        }
-    }
+    parent->dirty = false;
+    bsp_update_child(parent->left, &left, prune);
+    bsp_update_child(parent->right, &right, prune);
+}
+
+/* only walk into the subtree which area changed or marked dirty */
+static void bsp_update_node(struct bsp_node *parent)
+{
+    _bsp_update_node(parent, true);
 }
 
+/* The whole tree is walked since something outside of the bsp may have
+ * changed (e.g. gaps or layout mode), but only leaf which geometry differ get
+ * configured.
+ */
 void bsp_update_root(struct cwc_output *output, int workspace)
 {
     struct bsp_root_entry *entry = bsp_entry_get(output, workspace);
@@ -212,21 +265,39 @@ void bsp_update_root(struct cwc_output *output, int workspace)
     struct wlr_box usable_area = output->usable_area;
 
     if (root->type == BSP_NODE_LEAF) {
-        bsp_node_leaf_configure(root, usable_area.x, usable_area.y,
-                                usable_area.width, usable_area.height);
+        bsp_node_leaf_configure(root, &usable_area);
         return;
     }
 
     bsp_node_set_size(root, usable_area.width, usable_area.height);
     bsp_node_set_position(root, usable_area.x, usable_area.y);
 
-    bsp_update_node(root);
+    _bsp_update_node(root, false);
+}
+
+void bsp_node_mark_dirty(struct bsp_node *node)
+{
+    for (; node; node = node->parent)
+        node->dirty = true;
+}
+
+void bsp_node_set_wfact(struct bsp_node *node, double wfact)
+{
+    if (node->left_wfact == wfact)
+        return;
+
+    node->left_wfact = wfact;
+    if (node->enabled)
+        bsp_update_node(node);
 }
 
-/* enable all the node until root */
+/* enable all the node until root, the path is marked dirty so the update
+ * reach the enabled node even when the area doesn't change
+ */
 static struct bsp_node *_bsp_node_enable(struct bsp_node *node)
 {
     node->enabled = true;
+    node->dirty   = true;
 
     if (!node->parent)
         return node;
@@ -293,7 +364,7 @@ static struct bsp_node *bsp_node_internal_create(struct bsp_node *parent,
                                                  enum bsp_split_type split,
                                                  enum Position pos)
 {
-    struct bsp_node *node_data = calloc(1, sizeof(*node_data));
+    struct bsp_node *node_data = bsp_node_alloc();
     node_data->type            = BSP_NODE_INTERNAL;
     node_data->enabled         = true;
     node_data->split_type      = split;
@@ -313,7 +384,7 @@ static struct bsp_node *bsp_node_leaf_create(struct bsp_node *parent,
                                              struct cwc_container *container,
                                              enum Position pos)
 {
-    struct bsp_node *node_data = calloc(1, sizeof(*node_data));
+    struct bsp_node *node_data = bsp_node_alloc();
     node_data->type            = BSP_NODE_LEAF;
     node_data->container       = container;
     node_data->enabled         = true;
@@ -50,6 +50,7 @@ static void cairo_buffer_destroy(struct wlr_buffer *wlr_buffer)
     struct border_buffer *border = wl_container_of(wlr_buffer, border, base);
     wlr_buffer_finish(&border->base);
     cairo_surface_destroy(border->surface);
+    free(border);
 }
 
 static bool cairo_buffer_begin_data_ptr_access(struct wlr_buffer *wlr_buffer,
@@ -196,33 +197,132 @@ static cairo_pattern_t *process_pattern(cairo_pattern_t *reference_pattern,
     return pattern;
 }
 
-static inline void _draw_border(cairo_surface_t *cr_surf,
-                                cairo_pattern_t *pattern,
-                                int bw,
-                                int bh,
-                                enum wlr_direction dir)
+/* slices are stretched to the border size, so solid color border only need a
+ * tiny set of slices for any size while gradient is rasterized again when the
+ * size cross the step.
+ */
+#define BORDER_GRADIENT_STEP 64
+
+struct border_tileset {
+    struct wl_list link; // border_tilesets
+    int refcount;
+
+    cairo_pattern_t *pattern;
+    int rotation;
+    int thickness;
+    int ref_w, ref_h; // rectangle size the slices rasterized from
+
+    struct border_buffer *slice[BORDER_SLICE_COUNT];
+};
+
+static struct wl_list border_tilesets = {&border_tilesets, &border_tilesets};
+
+static void border_slice_box(enum border_slice slice,
+                             int w,
+                             int h,
+                             int thickness,
+                             struct wlr_box *box)
 {
-    cairo_t *cr   = cairo_create(cr_surf);
-    double radius = MIN(bw, bh);
+    int inner_w = w - thickness * 2;
+    int inner_h = h - thickness * 2;
 
-    // border radius
-    switch (dir) {
-    case WLR_DIRECTION_UP:
-        cairo_new_sub_path(cr);
-        cairo_arc(cr, bh, bh, radius, M_PI, M_PI + M_PI / 2);
-        cairo_arc(cr, bw - bh, bh, radius, -M_PI / 2, 0);
-        cairo_close_path(cr);
+    box->width  = thickness;
+    box->height = thickness;
+    switch (slice) {
+    case BORDER_SLICE_TOP_LEFT:
+        box->x = 0;
+        box->y = 0;
         break;
-    case WLR_DIRECTION_DOWN:
-        cairo_new_sub_path(cr);
-        cairo_arc(cr, bh, 0, radius, M_PI / 2, M_PI);
-        cairo_arc(cr, bw - bh, 0, radius, 0, M_PI / 2);
-        cairo_close_path(cr);
+    case BORDER_SLICE_TOP:
+        box->x     = thickness;
+        box->y     = 0;
+        box->width = inner_w;
+        break;
+    case BORDER_SLICE_TOP_RIGHT:
+        box->x = w - thickness;
+        box->y = 0;
+        break;
+    case BORDER_SLICE_RIGHT:
+        box->x      = w - thickness;
+        box->y      = thickness;
+        box->height = inner_h;
+        break;
+    case BORDER_SLICE_BOTTOM_RIGHT:
+        box->x = w - thickness;
+        box->y = h - thickness;
+        break;
+    case BORDER_SLICE_BOTTOM:
+        box->x     = thickness;
+        box->y     = h - thickness;
+        box->width = inner_w;
+        break;
+    case BORDER_SLICE_BOTTOM_LEFT:
+        box->x = 0;
+        box->y = h - thickness;
         break;
     default:
-        cairo_rectangle(cr, 0, 0, bw, bh);
+        box->x      = 0;
+        box->y      = thickness;
+        box->height = inner_h;
         break;
     }
+}
+
+static bool pattern_is_solid(cairo_pattern_t *pattern)
+{
+    return pattern == NULL
+           || cairo_pattern_get_type(pattern) == CAIRO_PATTERN_TYPE_SOLID;
+}
+
+static void border_tileset_ref_size(cairo_pattern_t *pattern,
+                                    int thickness,
+                                    int w,
+                                    int h,
+                                    int *ref_w,
+                                    int *ref_h)
+{
+    int min_size = thickness * 2 + 1;
+
+    if (pattern_is_solid(pattern)) {
+        *ref_w = min_size;
+        *ref_h = min_size;
+        return;
+    }
+
+    w      = (w + BORDER_GRADIENT_STEP - 1) / BORDER_GRADIENT_STEP;
+    h      = (h + BORDER_GRADIENT_STEP - 1) / BORDER_GRADIENT_STEP;
+    *ref_w = MAX(w * BORDER_GRADIENT_STEP, min_size);
+    *ref_h = MAX(h * BORDER_GRADIENT_STEP, min_size);
+}
+
+/* draw the area of the slice from the whole border */
+static void draw_border_slice(cairo_surface_t *cr_surf,
+                              cairo_pattern_t *pattern,
+                              struct wlr_box *slice,
+                              int full_w,
+                              int full_h,
+                              int thickness)
+{
+    cairo_t *cr   = cairo_create(cr_surf);
+    double radius = MIN(full_w, thickness);
+
+    cairo_translate(cr, -slice->x, -slice->y);
+
+    // top and bottom with border radius
+    cairo_new_sub_path(cr);
+    cairo_arc(cr, thickness, thickness, radius, M_PI, M_PI + M_PI / 2);
+    cairo_arc(cr, full_w - thickness, thickness, radius, -M_PI / 2, 0);
+    cairo_close_path(cr);
+
+    cairo_new_sub_path(cr);
+    cairo_arc(cr, thickness, full_h - thickness, radius, M_PI / 2, M_PI);
+    cairo_arc(cr, full_w - thickness, full_h - thickness, radius, 0,
+              M_PI / 2);
+    cairo_close_path(cr);
+
+    cairo_rectangle(cr, 0, thickness, thickness, full_h - thickness * 2);
+    cairo_rectangle(cr, full_w - thickness, thickness, thickness,
+                    full_h - thickness * 2);
 
     cairo_set_source(cr, pattern);
     cairo_fill(cr);
@@ -230,79 +330,178 @@ static inline void _draw_border(cairo_surface_t *cr_surf,
     cairo_destroy(cr);
 }
 
-static void draw_border(struct border_buffer **border,
-                        cairo_pattern_t *pattern,
-                        int rotation,
-                        int bw,
-                        int bh,
-                        int full_w,
-                        int full_h,
-                        enum wlr_direction dir)
+static void border_tileset_destroy(struct border_tileset *set)
 {
-    struct border_buffer *bb = *border = calloc(1, sizeof(**border));
+    for (int i = 0; i < BORDER_SLICE_COUNT; i++) {
+        if (set->slice[i])
+            wlr_buffer_drop(&set->slice[i]->base);
+    }
 
-    wlr_buffer_init(&bb->base, &cairo_border_impl, bw, bh);
-    bb->surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, bw, bh);
+    cairo_pattern_destroy(set->pattern);
+    wl_list_remove(&set->link);
+    free(set);
+}
 
-    if (cairo_surface_status(bb->surface) != CAIRO_STATUS_SUCCESS)
-        return;
+static struct border_tileset *border_tileset_create(cairo_pattern_t *pattern,
+                                                    int rotation,
+                                                    int thickness,
+                                                    int ref_w,
+                                                    int ref_h)
+{
+    struct border_tileset *set = calloc(1, sizeof(*set));
+    if (set == NULL) {
+        cwc_log(CWC_ERROR, "failed to allocate border_tileset");
+        return NULL;
+    }
+
+    set->refcount  = 1;
+    set->pattern   = cairo_pattern_reference(pattern);
+    set->rotation  = rotation;
+    set->thickness = thickness;
+    set->ref_w     = ref_w;
+    set->ref_h     = ref_h;
+    wl_list_insert(&border_tilesets, &set->link);
+
+    cairo_pattern_t *processed_pattern = NULL;
+    if (pattern)
+        processed_pattern = process_pattern(pattern, rotation, ref_w, thickness,
+                                            ref_w, ref_h, WLR_DIRECTION_UP);
+
+    for (int i = 0; i < BORDER_SLICE_COUNT; i++) {
+        struct wlr_box box;
+        border_slice_box(i, ref_w, ref_h, thickness, &box);
+        box.width  = MAX(box.width, 1);
+        box.height = MAX(box.height, 1);
+
+        struct border_buffer *bb = set->slice[i] = calloc(1, sizeof(*bb));
+        if (bb == NULL) {
+            cwc_log(CWC_ERROR, "failed to allocate border_buffer");
+            cairo_pattern_destroy(processed_pattern);
+            border_tileset_destroy(set);
+            return NULL;
+        }
+
+        wlr_buffer_init(&bb->base, &cairo_border_impl, box.width, box.height);
+        bb->surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, box.width,
+                                                 box.height);
+
+        if (processed_pattern == NULL
+            || cairo_surface_status(bb->surface) != CAIRO_STATUS_SUCCESS)
+            continue;
+
+        draw_border_slice(bb->surface, processed_pattern, &box, ref_w, ref_h,
+                          thickness);
+    }
 
-    cairo_pattern_t *processed_pattern =
-        process_pattern(pattern, rotation, bw, bh, full_w, full_h, dir);
-    _draw_border(bb->surface, processed_pattern, bw, bh, dir);
     cairo_pattern_destroy(processed_pattern);
+    return set;
 }
 
-static void border_buffer_init(struct cwc_border *border,
-                               cairo_pattern_t *pattern,
-                               int w,
-                               int h,
-                               int thickness)
+static bool border_tileset_match(struct border_tileset *set,
+                                 cairo_pattern_t *pattern,
+                                 int rotation,
+                                 int thickness,
+                                 int ref_w,
+                                 int ref_h)
 {
-    // clockwise top to left
-    draw_border(&border->buffer[0], pattern, border->pattern_rotation, w,
-                thickness, w, h, WLR_DIRECTION_UP);
-    draw_border(&border->buffer[1], pattern, border->pattern_rotation,
-                thickness, h - thickness * 2, w, h, WLR_DIRECTION_RIGHT);
-    draw_border(&border->buffer[2], pattern, border->pattern_rotation, w,
-                thickness, w, h, WLR_DIRECTION_DOWN);
-    draw_border(&border->buffer[3], pattern, border->pattern_rotation,
-                thickness, h - thickness * 2, w, h, WLR_DIRECTION_LEFT);
+    return set && set->pattern == pattern && set->rotation == rotation
+           && set->thickness == thickness && set->ref_w == ref_w
+           && set->ref_h == ref_h;
 }
 
-static bool is_border_valid(struct cwc_border *border)
+/* get slices that fit the border look, the returned set must be unref'd */
+static struct border_tileset *border_tileset_get(struct cwc_border *border)
 {
-    for (int i = 0; i < 4; ++i) {
-        if (border->buffer[i] == NULL)
-            return false;
+    int ref_w, ref_h;
+    int rotation = border->pattern_rotation;
+    border_tileset_ref_size(border->pattern, border->thickness, border->width,
+                            border->height, &ref_w, &ref_h);
+
+    // rotation doesn't matter for solid color
+    if (pattern_is_solid(border->pattern))
+        rotation = 0;
+
+    struct border_tileset *set;
+    wl_list_for_each(set, &border_tilesets, link)
+    {
+        if (border_tileset_match(set, border->pattern, rotation,
+                                 border->thickness, ref_w, ref_h)) {
+            set->refcount++;
+            return set;
+        }
     }
 
-    return true;
+    return border_tileset_create(border->pattern, rotation, border->thickness,
+                                 ref_w, ref_h);
 }
 
-static void border_buffer_fini(struct cwc_border *border)
+static void border_tileset_unref(struct border_tileset *set)
 {
-    if (!is_border_valid(border))
+    if (set == NULL || --set->refcount > 0)
         return;
 
-    for (int i = 0; i < 4; i++) {
-        wlr_scene_node_destroy(&border->buffer[i]->scene->node);
-        wlr_buffer_drop(&border->buffer[i]->base);
-        free(border->buffer[i]);
-        border->buffer[i] = NULL;
+    border_tileset_destroy(set);
+}
+
+/* tiles may be NULL if the slices failed to render, the border is kept
+ * without buffer until the next update succeed.
+ */
+static bool is_border_valid(struct cwc_border *border)
+{
+    return border->type == DATA_TYPE_BORDER;
+}
+
+/* position and stretch the slices to the border size */
+static void border_scene_update(struct cwc_border *border)
+{
+    if (!border->attached_tree)
+        return;
+
+    for (int i = 0; i < BORDER_SLICE_COUNT; i++) {
+        struct wlr_scene_buffer *scene = border->scene[i];
+        struct wlr_box box;
+        border_slice_box(i, border->width, border->height, border->thickness,
+                         &box);
+
+        wlr_scene_node_set_position(&scene->node, box.x, box.y);
+        if (!wlr_box_empty(&box))
+            wlr_scene_buffer_set_dest_size(scene, box.width, box.height);
+        wlr_scene_node_set_enabled(&scene->node,
+                                   border->enabled && !wlr_box_empty(&box));
     }
 }
 
-static void border_buffer_redraw(struct cwc_border *border)
+/* swap the slices when the look changed, no op if still using the same set */
+static void border_tiles_update(struct cwc_border *border)
 {
-    border_buffer_fini(border);
-    border_buffer_init(border, border->pattern, border->width, border->height,
-                       border->thickness);
+    struct border_tileset *tiles = border->tiles;
+    int ref_w, ref_h;
+    border_tileset_ref_size(border->pattern, border->thickness, border->width,
+                            border->height, &ref_w, &ref_h);
+
+    if (border_tileset_match(tiles, border->pattern,
+                             pattern_is_solid(border->pattern)
+                                 ? 0
+                                 : border->pattern_rotation,
+                             border->thickness, ref_w, ref_h))
+        goto update_scene;
+
+    // keep the old look if failed
+    tiles = border_tileset_get(border);
+    if (tiles == NULL)
+        goto update_scene;
 
-    if (border->attached_tree)
-        cwc_border_attach_to_scene(border, border->attached_tree);
+    if (border->attached_tree) {
+        for (int i = 0; i < BORDER_SLICE_COUNT; i++)
+            wlr_scene_buffer_set_buffer(border->scene[i],
+                                        &tiles->slice[i]->base);
+    }
+
+    border_tileset_unref(border->tiles);
+    border->tiles = tiles;
 
-    cwc_border_set_enabled(border, border->enabled);
+update_scene:
+    border_scene_update(border);
 }
 
 void cwc_border_init(struct cwc_border *border,
@@ -324,7 +523,7 @@ void cwc_border_init(struct cwc_border *border,
     border->enabled          = true;
     border->attached_tree    = NULL;
 
-    border_buffer_init(border, pattern, rect_w, rect_h, thickness);
+    border->tiles = border_tileset_get(border);
 }
 
 void cwc_border_destroy(struct cwc_border *border)
@@ -332,7 +531,12 @@ void cwc_border_destroy(struct cwc_border *border)
     if (!is_border_valid(border))
         return;
 
-    border_buffer_fini(border);
+    if (border->attached_tree) {
+        for (int i = 0; i < BORDER_SLICE_COUNT; i++)
+            wlr_scene_node_destroy(&border->scene[i]->node);
+    }
+
+    border_tileset_unref(border->tiles);
     cairo_pattern_destroy(border->pattern);
 
     *border = (struct cwc_border){0};
@@ -344,20 +548,17 @@ void cwc_border_attach_to_scene(struct cwc_border *border,
     if (!is_border_valid(border))
         return;
 
-    border->attached_tree = scene_tree;
-    for (int i = 0; i < 4; i++) {
-        border->buffer[i]->scene =
-            wlr_scene_buffer_create(scene_tree, &border->buffer[i]->base);
-        wlr_scene_node_lower_to_bottom(&border->buffer[i]->scene->node);
-        border->buffer[i]->scene->node.data = border;
+    struct border_tileset *tiles = border->tiles;
+    border->attached_tree        = scene_tree;
+    for (int i = 0; i < BORDER_SLICE_COUNT; i++) {
+        border->scene[i] = wlr_scene_buffer_create(
+            scene_tree, tiles ? &tiles->slice[i]->base : NULL);
+        wlr_scene_node_lower_to_bottom(&border->scene[i]->node);
+        border->scene[i]->node.data = border;
+        cwc_scene_node_update_opacity(&border->scene[i]->node);
     }
 
-    int bw = border->thickness;
-    wlr_scene_node_set_position(&border->buffer[1]->scene->node,
-                                border->width - bw, bw);
-    wlr_scene_node_set_position(&border->buffer[2]->scene->node, 0,
-                                border->height - bw);
-    wlr_scene_node_set_position(&border->buffer[3]->scene->node, 0, bw);
+    border_scene_update(border);
 }
 
 static void all_toplevel_reposition_tree(struct cwc_toplevel *toplevel,
@@ -385,13 +586,17 @@ void cwc_border_set_enabled(struct cwc_border *border, bool enabled)
     if (!is_border_valid(border))
         return;
 
-    for (int i = 0; i < 4; i++)
-        wlr_scene_node_set_enabled(&border->buffer[i]->scene->node, enabled);
     border->enabled = enabled;
+    border_scene_update(border);
 
     struct cwc_container *container =
         wl_container_of(border, container, border);
     cwc_container_reposition_client_tree(container);
+
+    // the container box stay the same, only the surface inside resized
+    if (container->bsp_node)
+        bsp_node_mark_dirty(container->bsp_node);
+
     transaction_schedule_tag(
         cwc_output_get_current_tag_info(container->output));
 }
@@ -407,7 +612,7 @@ void cwc_border_set_pattern(struct cwc_border *border,
 
     cairo_pattern_destroy(border->pattern);
     border->pattern = cairo_pattern_reference(pattern);
-    border_buffer_redraw(border);
+    border_tiles_update(border);
 }
 
 void cwc_border_set_pattern_rotation(struct cwc_border *border, int rotation)
@@ -421,7 +626,7 @@ void cwc_border_set_pattern_rotation(struct cwc_border *border, int rotation)
 
     rotation                 = CLAMP(rotation, -315, INT_MAX);
     border->pattern_rotation = rotation;
-    border_buffer_redraw(border);
+    border_tiles_update(border);
 }
 
 void cwc_border_set_thickness(struct cwc_border *border, int thickness)
@@ -433,11 +638,16 @@ void cwc_border_set_thickness(struct cwc_border *border, int thickness)
         return;
 
     border->thickness = thickness;
-    border_buffer_redraw(border);
+    border_tiles_update(border);
 
     struct cwc_container *container =
         wl_container_of(border, container, border);
     cwc_container_reposition_client_tree(container);
+
+    // the container box stay the same, only the surface inside resized
+    if (container->bsp_node)
+        bsp_node_mark_dirty(container->bsp_node);
+
     transaction_schedule_tag(
         cwc_output_get_current_tag_info(container->output));
 }
@@ -460,7 +670,7 @@ void cwc_border_resize(struct cwc_border *border, int rect_w, int rect_h)
 
     border->width  = rect_w;
     border->height = rect_h;
-    border_buffer_redraw(border);
+    border_tiles_update(border);
 }
 
 //===================== CONTAINER ==========================
@@ -489,6 +699,7 @@ assign_common:
     toplevel->surf_tree->node.data = toplevel;
     wlr_scene_node_place_below(&toplevel->surf_tree->node,
                                &container->popup_tree->node);
+    cwc_scene_node_update_opacity(&toplevel->surf_tree->node);
 }
 
 static void _decide_should_tiled_part1(struct cwc_toplevel *toplevel,
@@ -556,6 +767,7 @@ void cwc_container_init(struct cwc_output *output,
     cont->tree->node.data      = cont;
     cont->opacity              = 1.0f;
     cont->wfact                = 1.0f;
+    cont->tiled_index          = -1;
 
     int gaps = cwc_output_get_current_tag_info(cont->output)->useless_gaps;
     struct wlr_box geom      = cwc_toplevel_get_geometry(toplevel);
@@ -593,6 +805,7 @@ void cwc_container_init(struct cwc_output *output,
 
     toplevel->container = cont;
     wl_list_insert(&cont->toplevels, &toplevel->link_container);
+    cwc_output_lists_changed();
 
     init_surf_tree(toplevel, cont);
     cwc_container_reposition_client_tree(cont);
@@ -602,10 +815,13 @@ void cwc_container_init(struct cwc_output *output,
 
     wl_list_insert(&cont->output->state->containers,
                    &cont->link_output_container);
+    // head of the list, lower than every key given so far
+    cont->output_order = -(++cont->output->state->container_order);
     wl_list_insert(&cont->output->state->focus_stack,
                    &cont->link_output_fstack);
 
     _decide_should_tiled_part1(toplevel, cont);
+    master_tiled_update_container(cont);
 
 emit_signal:
 #ifdef CWC_XWAYLAND
@@ -617,7 +833,7 @@ emit_signal:
 #endif // CWC_XWAYLAND
 
     luaC_object_container_register(L, cont);
-    cwc_object_emit_signal_simple("container::new", L, cont);
+    cwc_object_emit_signal_simple_id(CWC_SIGNAL("container::new"), L, cont);
 }
 
 static void _cwc_container_insert_toplevel(struct cwc_container *c,
@@ -629,6 +845,7 @@ static void _cwc_container_insert_toplevel(struct cwc_container *c,
 
     toplevel->container = c;
     wl_list_insert(&c->toplevels, &toplevel->link_container);
+    cwc_output_lists_changed();
 
     if (!toplevel->surf_tree)
         init_surf_tree(toplevel, c);
@@ -636,16 +853,20 @@ static void _cwc_container_insert_toplevel(struct cwc_container *c,
         wlr_scene_node_reparent(&toplevel->surf_tree->node, c->tree);
         wlr_scene_node_place_below(&toplevel->surf_tree->node,
                                    &c->popup_tree->node);
+        cwc_scene_node_update_opacity(&toplevel->surf_tree->node);
     }
 
     int bw = cwc_border_get_thickness(&c->border);
     wlr_scene_node_set_position(&toplevel->surf_tree->node, bw, bw);
 
     cwc_container_set_size(c, c->width, c->height);
+    cwc_toplevel_update_tag_stats(toplevel);
+    master_tiled_update_container(c);
 
     if (emit_signal)
-        cwc_object_emit_signal_varr("container::insert",
-                                    g_config_get_lua_State(), 2, c, toplevel);
+        cwc_object_emit_signal_varr_id(CWC_SIGNAL("container::insert"),
+                                       g_config_get_lua_State(), 2, c,
+                                       toplevel);
 }
 
 void cwc_container_insert_toplevel(struct cwc_container *c,
@@ -663,15 +884,18 @@ static void cwc_container_insert_toplevel_silence(struct cwc_container *c,
 static void cwc_container_fini(struct cwc_container *container)
 {
     lua_State *L = g_config_get_lua_State();
-    cwc_object_emit_signal_simple("container::destroy", L, container);
+    cwc_object_emit_signal_simple_id(CWC_SIGNAL("container::destroy"), L,
+                                     container);
 
     if (server.insert_marked == container)
         server.insert_marked = NULL;
 
     if (!cwc_container_is_unmanaged(container)) {
+        master_tiled_remove_container(container);
         wl_list_remove(&container->link_output_container);
         wl_list_remove(&container->link_output_fstack);
     }
+    cwc_output_lists_changed();
 
     if (container->bsp_node)
         bsp_remove_container(container, false);
@@ -700,8 +924,9 @@ static void cwc_container_fini(struct cwc_container *container)
 
 static void _clear_container_stuff_in_toplevel(struct cwc_toplevel *toplevel)
 {
-    cwc_object_emit_signal_varr("container::remove", g_config_get_lua_State(),
-                                2, toplevel->container, toplevel);
+    cwc_object_emit_signal_varr_id(CWC_SIGNAL("container::remove"),
+                                   g_config_get_lua_State(), 2,
+                                   toplevel->container, toplevel);
 
     // toplevel should be inserted to container again when removing from
     // container
@@ -711,6 +936,8 @@ static void _clear_container_stuff_in_toplevel(struct cwc_toplevel *toplevel)
 
     wl_list_remove(&toplevel->link_container);
     toplevel->container = NULL;
+    cwc_toplevel_update_tag_stats(toplevel);
+    cwc_output_lists_changed();
 }
 
 void cwc_container_remove_toplevel(struct cwc_toplevel *toplevel)
@@ -719,8 +946,10 @@ void cwc_container_remove_toplevel(struct cwc_toplevel *toplevel)
 
     _clear_container_stuff_in_toplevel(toplevel);
 
-    if (wl_list_length(&cont->toplevels))
+    if (wl_list_length(&cont->toplevels)) {
+        master_tiled_update_container(cont);
         return;
+    }
 
     cwc_container_fini(cont);
 }
@@ -728,7 +957,12 @@ void cwc_container_remove_toplevel(struct cwc_toplevel *toplevel)
 void cwc_container_remove_toplevel_but_dont_destroy_container_when_empty(
     struct cwc_toplevel *toplevel)
 {
+    struct cwc_container *cont = toplevel->container;
+
     _clear_container_stuff_in_toplevel(toplevel);
+
+    if (wl_list_length(&cont->toplevels))
+        master_tiled_update_container(cont);
 }
 
 void cwc_container_for_each_toplevel_top_to_bottom(
@@ -828,11 +1062,13 @@ static void __cwc_container_move_to_output(struct cwc_container *container,
     if (container->bsp_node)
         bsp_remove_container(container, false);
 
+    master_tiled_remove_container(container);
     container->output = output;
     wl_list_reattach(&output->state->focus_stack,
                      &container->link_output_fstack);
     wl_list_reattach(output->state->containers.prev,
                      &container->link_output_container);
+    container->output_order = ++output->state->container_order;
 
     if (container->link_output_minimized.next)
         wl_list_reattach(output->state->minimized.prev,
@@ -844,6 +1080,9 @@ static void __cwc_container_move_to_output(struct cwc_container *container,
 
     container->tag       = output->state->active_tag;
     container->workspace = output_workspace;
+    cwc_container_update_tag_stats(container);
+    cwc_output_lists_changed();
+    master_tiled_update_container(container);
 
     transaction_schedule_tag(cwc_output_get_current_tag_info(old));
     transaction_schedule_tag(cwc_output_get_current_tag_info(output));
@@ -927,6 +1166,16 @@ void cwc_container_for_each_toplevel(struct cwc_container *container,
     }
 }
 
+static void _update_tag_stats(struct cwc_toplevel *toplevel, void *data)
+{
+    cwc_toplevel_update_tag_stats(toplevel);
+}
+
+void cwc_container_update_tag_stats(struct cwc_container *container)
+{
+    cwc_container_for_each_toplevel(container, _update_tag_stats, NULL);
+}
+
 int cwc_container_get_gaps(struct cwc_container *cont)
 {
     if (cwc_container_is_maximized(cont) || cwc_container_is_fullscreen(cont)
@@ -978,6 +1227,7 @@ void cwc_container_set_front_toplevel(struct cwc_toplevel *toplevel)
     cwc_container_set_size(container, container->width, container->height);
     wlr_scene_node_place_below(&toplevel->surf_tree->node,
                                &container->popup_tree->node);
+    cwc_output_lists_changed();
 
     struct cwc_toplevel *t;
     wl_list_for_each(t, &toplevel->container->toplevels, link_container)
@@ -988,6 +1238,8 @@ void cwc_container_set_front_toplevel(struct cwc_toplevel *toplevel)
         wlr_scene_node_set_enabled(&t->surf_tree->node, false);
         __cwc_toplevel_set_minimized(t, true);
     }
+
+    master_tiled_update_container(container);
 }
 
 static void _focusnext(struct cwc_toplevel *toplevel, int step)
@@ -1082,8 +1334,8 @@ void cwc_container_swap(struct cwc_container *source,
     wl_array_release(&source_temp_array);
     wl_array_release(&target_temp_array);
 
-    cwc_object_emit_signal_varr("container::swap", g_config_get_lua_State(), 2,
-                                source, target);
+    cwc_object_emit_signal_varr_id(CWC_SIGNAL("container::swap"),
+                                   g_config_get_lua_State(), 2, source, target);
 }
 
 inline bool cwc_container_is_floating(struct cwc_container *cont)
@@ -1111,10 +1363,10 @@ void cwc_container_set_enabled(struct cwc_container *container, bool set)
     }
 }
 
-#define EMIT_PROP_SIGNAL_FOR_FRONT_TOPLEVEL(propname, container) \
-    cwc_object_emit_signal_simple("client::prop::" #propname,    \
-                                  g_config_get_lua_State(),      \
-                                  cwc_container_get_front_toplevel(container))
+#define EMIT_PROP_SIGNAL_FOR_FRONT_TOPLEVEL(propname, container)           \
+    cwc_object_emit_signal_simple_id(                                      \
+        CWC_SIGNAL("client::prop::" #propname), g_config_get_lua_State(), \
+        cwc_container_get_front_toplevel(container))
 
 static void all_toplevel_set_floating(struct cwc_toplevel *toplevel, void *data)
 {
@@ -1155,6 +1407,7 @@ void cwc_container_set_floating(struct cwc_container *container, bool set)
 
     cwc_container_for_each_toplevel(container, all_toplevel_set_floating,
                                     (void *)set);
+    master_tiled_update_container(container);
 
     transaction_schedule_tag(
         cwc_output_get_current_tag_info(container->output));
@@ -1164,12 +1417,15 @@ void cwc_container_set_floating(struct cwc_container *container, bool set)
 
 void cwc_container_set_sticky(struct cwc_container *container, bool set)
 {
+    cwc_output_lists_changed();
     if (set) {
         container->state |= CONTAINER_STATE_STICKY;
+        master_tiled_update_container(container);
         return;
     }
 
     container->state &= ~CONTAINER_STATE_STICKY;
+    master_tiled_update_container(container);
     transaction_schedule_output(container->output);
 }
 
@@ -1231,6 +1487,7 @@ void cwc_container_set_fullscreen(struct cwc_container *container, bool set)
 
     cwc_container_for_each_toplevel(container, all_toplevel_set_fullscreen,
                                     (void *)set);
+    master_tiled_update_container(container);
 
     transaction_schedule_tag(
         cwc_output_get_current_tag_info(container->output));
@@ -1284,6 +1541,7 @@ void cwc_container_set_maximized(struct cwc_container *container, bool set)
 
     cwc_container_for_each_toplevel(container, all_toplevel_set_maximized,
                                     (void *)set);
+    master_tiled_update_container(container);
 
     transaction_schedule_tag(
         cwc_output_get_current_tag_info(container->output));
@@ -1327,6 +1585,8 @@ void cwc_container_set_minimized(struct cwc_container *container, bool set)
 
     cwc_container_for_each_toplevel(container, all_toplevel_set_minimized,
                                     (void *)set);
+    cwc_output_lists_changed();
+    master_tiled_update_container(container);
 
     transaction_schedule_tag(
         cwc_output_get_current_tag_info(container->output));
@@ -1373,14 +1633,11 @@ static void all_toplevel_set_size(struct cwc_toplevel *toplevel, void *data)
 
         clip.x = geom.x;
         clip.y = geom.y;
-
-        if (visible && !toplevel->resize_serial)
-            server.resize_count = MAX(1, server.resize_count + 1);
     }
 
-    uint32_t resize_serial = cwc_toplevel_set_size(toplevel, surf_w, surf_h);
-    if (visible)
-        toplevel->resize_serial = resize_serial;
+    uint32_t serial = cwc_toplevel_set_size(toplevel, surf_w, surf_h);
+    if (visible && !cwc_toplevel_is_x11(toplevel))
+        transaction_wait_configure(toplevel, serial);
 
     wlr_scene_subsurface_tree_set_clip(&toplevel->surf_tree->node, &clip);
     box->width  = surf_w;
@@ -1427,6 +1684,18 @@ static inline void update_container_output(struct cwc_container *container)
     cwc_container_move_to_output_without_translate(container, output);
 }
 
+void cwc_container_clamp_tiled_size(struct cwc_container *container,
+                                    int *w,
+                                    int *h)
+{
+    int gaps          = cwc_container_get_gaps(container);
+    int bw            = cwc_border_get_thickness(&container->border);
+    int outside_width = (bw + gaps) * 2;
+
+    *w = MAX(*w - outside_width, MIN_WIDTH) + outside_width;
+    *h = MAX(*h - outside_width, MIN_WIDTH) + outside_width;
+}
+
 void cwc_container_set_size(struct cwc_container *container, int w, int h)
 {
     int gaps = cwc_container_get_gaps(container);
@@ -1597,6 +1866,9 @@ void cwc_container_move_to_tag(struct cwc_container *container, int workspace)
     bool tag_changed      = container->tag != newtag;
     container->tag        = newtag;
     container->workspace  = workspace;
+    cwc_container_update_tag_stats(container);
+    cwc_output_lists_changed();
+    master_tiled_update_container(container);
 
     struct cwc_tag_info *tag_info =
         &container->output->state->tag_info[workspace];
@@ -1611,12 +1883,13 @@ void cwc_container_move_to_tag(struct cwc_container *container, int workspace)
     cwc_container_set_enabled(container, cwc_container_is_visible(container));
 
     lua_State *L = g_config_get_lua_State();
-    cwc_object_emit_signal_simple("client::prop::workspace", L,
-                                  cwc_container_get_front_toplevel(container));
+    cwc_object_emit_signal_simple_id(
+        CWC_SIGNAL("client::prop::workspace"), L,
+        cwc_container_get_front_toplevel(container));
 
     if (tag_changed)
-        cwc_object_emit_signal_simple(
-            "client::prop::tag", L,
+        cwc_object_emit_signal_simple_id(
+            CWC_SIGNAL("client::prop::tag"), L,
             cwc_container_get_front_toplevel(container));
 }
 
@@ -1627,13 +1900,16 @@ void cwc_container_set_tag(struct cwc_container *container, tag_bitfield_t tag)
 
     bool changed   = container->tag != tag;
     container->tag = tag;
+    cwc_container_update_tag_stats(container);
+    cwc_output_lists_changed();
+    master_tiled_update_container(container);
     transaction_schedule_output(container->output);
     cwc_container_set_enabled(container, cwc_container_is_visible(container));
 
     lua_State *L = g_config_get_lua_State();
     if (changed)
-        cwc_object_emit_signal_simple(
-            "client::prop::tag", L,
+        cwc_object_emit_signal_simple_id(
+            CWC_SIGNAL("client::prop::tag"), L,
             cwc_container_get_front_toplevel(container));
 }
 
@@ -1654,22 +1930,26 @@ void cwc_container_raise(struct cwc_container *container)
 {
     wlr_scene_node_raise_to_top(&container->tree->node);
 
-    cwc_object_emit_signal_simple("client::raised", g_config_get_lua_State(),
-                                  cwc_container_get_front_toplevel(container));
+    cwc_object_emit_signal_simple_id(
+        CWC_SIGNAL("client::raised"), g_config_get_lua_State(),
+        cwc_container_get_front_toplevel(container));
 }
 
 void cwc_container_lower(struct cwc_container *container)
 {
     wlr_scene_node_lower_to_bottom(&container->tree->node);
 
-    cwc_object_emit_signal_simple("client::lowered", g_config_get_lua_State(),
-                                  cwc_container_get_front_toplevel(container));
+    cwc_object_emit_signal_simple_id(
+        CWC_SIGNAL("client::lowered"), g_config_get_lua_State(),
+        cwc_container_get_front_toplevel(container));
 }
 
 void cwc_container_set_opacity(struct cwc_container *container, float opacity)
 {
-    opacity            = CLAMP(opacity, 0.0, 1.0);
-    container->opacity = opacity;
+    opacity = CLAMP(opacity, 0.0, 1.0);
+    if (container->opacity == opacity)
+        return;
 
-    wlr_output_schedule_frame(container->output->wlr_output);
+    container->opacity = opacity;
+    cwc_scene_node_update_opacity(&container->tree->node);
 }
@@ -17,6 +17,7 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 #include <wayland-util.h>
 #include <wlr/types/wlr_cursor.h>
 
@@ -135,7 +136,7 @@ static void arrange_tile(struct cwc_toplevel **toplevels,
     int min_item_per_col = sec_len / col_count;
     int item_remainder   = sec_len % col_count;
 
-    for (int i = master_state->column_count - 1; i >= 0; i--) {
+    for (int i = col_count - 1; i >= 0; i--) {
         col_capacities[i] = min_item_per_col;
 
         if (item_remainder >= 1) {
@@ -260,27 +261,265 @@ struct layout_interface *get_default_master_layout()
     return layout_list;
 }
 
-static int get_tiled_toplevel_array(struct cwc_output *output,
-                                    struct cwc_toplevel **toplevels,
-                                    int array_len)
+static inline bool container_is_tiled(struct cwc_container *container)
 {
-    int i = 0;
+    struct cwc_toplevel *front = cwc_container_get_front_toplevel(container);
+    return front && cwc_toplevel_is_tileable(front);
+}
+
+/* return the cache if it's still for the current view, drop it otherwise */
+static struct master_state *tiled_cache_get(struct cwc_output *output)
+{
+    struct master_state *state = output->state->tiled_cache;
+    if (!state)
+        return NULL;
+
+    if (state != &cwc_output_get_current_tag_info(output)->master_state
+        || state->tiled_view != output->state->active_tag) {
+        output->state->tiled_cache = NULL;
+        return NULL;
+    }
+
+    return state;
+}
+
+static void tiled_cache_rebuild(struct cwc_output *output,
+                                struct master_state *state)
+{
+    // only one cache is patched, the other tag need a rebuild
+    output->state->tiled_cache = NULL;
+
+    struct wl_array *cache = &state->tiled_containers;
+    cache->size            = 0;
+
     struct cwc_container *container;
     wl_list_for_each(container, &output->state->containers,
                      link_output_container)
     {
+        if (!container_is_tiled(container))
+            continue;
+
+        struct cwc_container **elem = wl_array_add(cache, sizeof(*elem));
+        if (!elem)
+            return;
+
+        container->tiled_index = cache->size / sizeof(*elem) - 1;
+        *elem                  = container;
+    }
+
+    state->tiled_unsorted      = false;
+    state->tiled_view          = output->state->active_tag;
+    output->state->tiled_cache = state;
+}
+
+static inline int tiled_cache_len(struct master_state *state)
+{
+    return state->tiled_containers.size / sizeof(struct cwc_container *);
+}
+
+/* the slot index is only trusted when the slot points back to the container,
+ * so index left behind by a dropped cache never need to be cleared.
+ */
+static inline bool tiled_cache_has(struct master_state *state,
+                                   struct cwc_container *container)
+{
+    struct cwc_container **cache = state->tiled_containers.data;
+    int idx                      = container->tiled_index;
+
+    return idx >= 0 && idx < tiled_cache_len(state) && cache[idx] == container;
+}
+
+/* move the last element to the hole, the order is restored before use */
+static void tiled_cache_remove(struct master_state *state,
+                               struct cwc_container *container)
+{
+    struct cwc_container **cache = state->tiled_containers.data;
+    int last                     = tiled_cache_len(state) - 1;
+    int idx                      = container->tiled_index;
+
+    if (idx != last) {
+        cache[idx]              = cache[last];
+        cache[idx]->tiled_index = idx;
+        state->tiled_unsorted   = true;
+    }
+
+    container->tiled_index = -1;
+    state->tiled_containers.size -= sizeof(*cache);
+}
+
+static void tiled_cache_append(struct cwc_output *output,
+                               struct master_state *state,
+                               struct cwc_container *container)
+{
+    struct cwc_container **elem =
+        wl_array_add(&state->tiled_containers, sizeof(*elem));
+    if (!elem) {
+        output->state->tiled_cache = NULL;
+        return;
+    }
+
+    container->tiled_index = tiled_cache_len(state) - 1;
+    *elem                  = container;
+    state->tiled_unsorted  = true;
+}
+
+static int compare_output_order(const void *a, const void *b)
+{
+    const struct cwc_container *ca = *(struct cwc_container *const *)a;
+    const struct cwc_container *cb = *(struct cwc_container *const *)b;
+
+    return (ca->output_order > cb->output_order)
+           - (ca->output_order < cb->output_order);
+}
+
+static void tiled_cache_sort(struct master_state *state)
+{
+    if (!state->tiled_unsorted)
+        return;
+
+    struct cwc_container **cache = state->tiled_containers.data;
+    int len                      = tiled_cache_len(state);
+
+    qsort(cache, len, sizeof(*cache), compare_output_order);
+    for (int i = 0; i < len; i++)
+        cache[i]->tiled_index = i;
+
+    state->tiled_unsorted = false;
+}
+
+#ifndef NDEBUG
+/* a missed update hook would silently fall back to the re-check in the
+ * arrange path, compare with a full walk so it fails loudly instead.
+ */
+static void tiled_cache_verify(struct cwc_output *output,
+                               struct master_state *state)
+{
+    struct cwc_container **cache = state->tiled_containers.data;
+    int len                      = tiled_cache_len(state);
+    int idx                      = 0;
+
+    struct cwc_container *container;
+    wl_list_for_each(container, &output->state->containers,
+                     link_output_container)
+    {
+        if (!container_is_tiled(container))
+            continue;
+
+        if (!cwc_assert(idx < len && cache[idx] == container,
+                        "tiled cache out of sync at index %d\n", idx))
+            return;
+
+        idx++;
+    }
+
+    cwc_assert(idx == len, "tiled cache has %d stale container\n", len - idx);
+}
+#endif
+
+void master_tiled_update_container(struct cwc_container *container)
+{
+    if (cwc_container_is_unmanaged(container))
+        return;
+
+    struct cwc_output *output  = container->output;
+    struct master_state *state = tiled_cache_get(output);
+    if (!state)
+        return;
+
+    bool tiled = container_is_tiled(container);
+    if (tiled_cache_has(state, container) == tiled)
+        return;
+
+    if (tiled)
+        tiled_cache_append(output, state, container);
+    else
+        tiled_cache_remove(state, container);
+}
+
+void master_tiled_remove_container(struct cwc_container *container)
+{
+    if (cwc_container_is_unmanaged(container))
+        return;
+
+    struct master_state *state = tiled_cache_get(container->output);
+    if (!state)
+        return;
+
+    if (tiled_cache_has(state, container))
+        tiled_cache_remove(state, container);
+}
+
+void master_tiled_invalidate(struct cwc_output *output)
+{
+    output->state->tiled_cache = NULL;
+}
+
+/* fill the array with the front toplevel of the cached tiled containers, the
+ * result is NULL terminated.
+ */
+static struct cwc_toplevel **
+get_tiled_toplevel_array(struct cwc_output *output,
+                         struct master_state *state,
+                         struct wl_array *tiled,
+                         int *len)
+{
+    if (tiled_cache_get(output) != state)
+        tiled_cache_rebuild(output, state);
+
+    tiled_cache_sort(state);
+#ifndef NDEBUG
+    tiled_cache_verify(output, state);
+#endif
+
+    struct cwc_toplevel **elem;
+    tiled->size = 0;
+
+    struct cwc_container **container;
+    wl_array_for_each(container, &state->tiled_containers)
+    {
+        // the cache only decide the membership, the state is checked again
+        // so a missed patch can't hand a non tiled client to the layout
         struct cwc_toplevel *front =
-            cwc_container_get_front_toplevel(container);
-        if (cwc_toplevel_is_tileable(front))
-            toplevels[i++] = front;
+            cwc_container_get_front_toplevel(*container);
+        if (!cwc_toplevel_is_tileable(front))
+            continue;
 
-        // sanity check
-        if (i >= array_len - 1)
+        if (!(elem = wl_array_add(tiled, sizeof(*elem))))
             break;
+
+        *elem = front;
+    }
+
+    *len = tiled->size / sizeof(*elem);
+
+    if (!(elem = wl_array_add(tiled, sizeof(*elem)))) {
+        *len = 0;
+        return NULL;
     }
 
-    toplevels[i] = NULL;
-    return i;
+    *elem = NULL;
+    return tiled->data;
+}
+
+/* The tiled array is borrowed from the tag while the layout is running so a
+ * signal handler that trigger another arrange gets its own array.
+ */
+static inline struct wl_array tiled_array_take(struct master_state *state)
+{
+    struct wl_array tiled = state->tiled;
+    wl_array_init(&state->tiled);
+    return tiled;
+}
+
+static inline void tiled_array_give_back(struct master_state *state,
+                                         struct wl_array *tiled)
+{
+    if (state->tiled.alloc) {
+        wl_array_release(tiled);
+        return;
+    }
+
+    state->tiled = *tiled;
 }
 
 void master_arrange_update(struct cwc_output *output)
@@ -290,12 +529,16 @@ void master_arrange_update(struct cwc_output *output)
         return;
 
     struct master_state *state = &info->master_state;
+    struct wl_array tiled      = tiled_array_take(state);
 
-    struct cwc_toplevel *tiled_visible[50];
-    int i = get_tiled_toplevel_array(output, tiled_visible, 50);
+    int len;
+    struct cwc_toplevel **tiled_visible =
+        get_tiled_toplevel_array(output, state, &tiled, &len);
 
-    if (i >= 1)
-        state->current_layout->arrange(tiled_visible, i, output, state);
+    if (len >= 1)
+        state->current_layout->arrange(tiled_visible, len, output, state);
+
+    tiled_array_give_back(state, &tiled);
 }
 
 static void _master_resize(struct cwc_output *output,
@@ -305,9 +548,14 @@ static void _master_resize(struct cwc_output *output,
     struct master_state *state =
         &cwc_output_get_current_tag_info(output)->master_state;
     struct layout_interface *layout = state->current_layout;
+    struct wl_array tiled           = tiled_array_take(state);
+
+    int i;
+    struct cwc_toplevel **tiled_visible =
+        get_tiled_toplevel_array(output, state, &tiled, &i);
 
-    struct cwc_toplevel *tiled_visible[50];
-    int i = get_tiled_toplevel_array(output, tiled_visible, 50);
+    if (tiled_visible == NULL)
+        goto give_back;
 
     if (layout->resize_update && stage == UPDATE)
         layout->resize_update(tiled_visible, i, cursor, state);
@@ -317,6 +565,9 @@ static void _master_resize(struct cwc_output *output,
         layout->resize_end(tiled_visible, i, cursor, state);
 
     transaction_schedule_tag(cwc_output_get_current_tag_info(output));
+
+give_back:
+    tiled_array_give_back(state, &tiled);
 }
 
 void master_resize_start(struct cwc_output *output, struct cwc_cursor *cursor)
@@ -355,6 +606,7 @@ void master_set_master(struct cwc_toplevel *toplevel)
 
     wl_list_swap(&toplevel->link_output_toplevels,
                  &master->link_output_toplevels);
+    cwc_output_lists_changed();
 
     transaction_schedule_tag(
         cwc_output_get_current_tag_info(toplevel->container->output));
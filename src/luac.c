@@ -84,14 +84,16 @@ static void reregister_lua_object()
     wl_list_for_each(toplevel, &server.toplevels, link)
     {
         luaC_object_client_register(L, toplevel);
-        cwc_object_emit_signal_simple("client::new", L, toplevel);
+        cwc_object_emit_signal_simple_id(CWC_SIGNAL("client::new"), L,
+                                         toplevel);
     }
 
     struct cwc_container *container;
     wl_list_for_each(container, &server.containers, link)
     {
         luaC_object_container_register(L, container);
-        cwc_object_emit_signal_simple("container::new", L, container);
+        cwc_object_emit_signal_simple_id(CWC_SIGNAL("container::new"), L,
+                                         container);
     }
 
     struct cwc_output *output;
@@ -103,29 +105,31 @@ static void reregister_lua_object()
         }
 
         luaC_object_screen_register(L, output);
-        cwc_object_emit_signal_simple("screen::new", g_config_get_lua_State(),
-                                      output);
+        cwc_object_emit_signal_simple_id(CWC_SIGNAL("screen::new"),
+                                         g_config_get_lua_State(), output);
     }
 
     struct cwc_libinput_device *input_dev;
     wl_list_for_each(input_dev, &server.input->devices, link)
     {
         luaC_object_input_register(L, input_dev);
-        cwc_object_emit_signal_simple("input::new", L, input_dev);
+        cwc_object_emit_signal_simple_id(CWC_SIGNAL("input::new"), L,
+                                         input_dev);
     }
 
     struct cwc_layer_surface *lsurf;
     wl_list_for_each(lsurf, &server.layer_shells, link)
     {
         luaC_object_layer_shell_register(L, lsurf);
-        cwc_object_emit_signal_simple("layer_shell::new", L, lsurf);
+        cwc_object_emit_signal_simple_id(CWC_SIGNAL("layer_shell::new"), L,
+                                         lsurf);
     }
 
     struct cwc_plugin *plugin;
     wl_list_for_each(plugin, &server.plugins, link)
     {
         luaC_object_plugin_register(L, plugin);
-        cwc_object_emit_signal_simple("plugin::load", L, plugin);
+        cwc_object_emit_signal_simple_id(CWC_SIGNAL("plugin::load"), L, plugin);
     }
 
     struct cwc_seat *seat;
@@ -137,7 +141,8 @@ static void reregister_lua_object()
         wl_list_for_each(tablet, &seat->tablet_devs, link)
         {
             luaC_object_tablet_register(L, tablet);
-            cwc_object_emit_signal_simple("tablet::new", L, tablet);
+            cwc_object_emit_signal_simple_id(CWC_SIGNAL("tablet::new"), L,
+                                             tablet);
         }
     }
 }
@@ -444,10 +449,16 @@ static int luaC_unlock_session(lua_State *L)
 }
 
 /** Add event listener.
+ *
+ * A deferred listener is called once per object at the end of the current
+ * transaction instead of on every emission, it only receive the object that
+ * emit the signal (or nothing if not emitted by an object). For
+ * `cwc.emit_signal` the object is the first argument if it's a cwc object.
  *
  * @staticfct connect_signal
  * @tparam string signame The name of the signal.
  * @tparam function func Callback function to run.
+ * @tparam[opt=false] boolean deferred Coalesce the emission.
  * @noreturn
  */
 static int luaC_connect_signal(lua_State *L)
@@ -455,7 +466,10 @@ static int luaC_connect_signal(lua_State *L)
     luaL_checktype(L, 2, LUA_TFUNCTION);
 
     const char *name = luaL_checkstring(L, 1);
-    cwc_signal_connect_lua(name, L, 2);
+    if (lua_toboolean(L, 3))
+        cwc_signal_connect_lua_deferred(name, L, 2);
+    else
+        cwc_signal_connect_lua(name, L, 2);
 
     return 0;
 }
@@ -494,6 +508,116 @@ static int luaC_emit_signal(lua_State *L)
     return 0;
 }
 
+/** Get the signal emission counter.
+ *
+ * The table contain `dispatched` (emission that reach any listener),
+ * `skipped` (nobody listen so the argument is never built) and the deferred
+ * listener counter: `emitted` (emission while a deferred listener is
+ * connected), `collapsed` (emission merged into a queued one), `delivered`
+ * and `dropped` (the object is destroyed before the flush).
+ *
+ * @staticfct signal_stats
+ * @tparam[opt] string signame The name of the signal, total if omitted.
+ * @treturn table The counter or nil if the signal doesn't exist.
+ */
+static int luaC_signal_stats(lua_State *L)
+{
+    const char *name = luaL_optstring(L, 1, NULL);
+    struct cwc_signal_emit_stats emit;
+    struct cwc_signal_deferred_stats stats;
+
+    if (!cwc_signal_get_emit_stats(name, &emit)
+        || !cwc_signal_get_deferred_stats(name, &stats))
+        return 0;
+
+    lua_createtable(L, 0, 6);
+    lua_pushnumber(L, emit.dispatched);
+    lua_setfield(L, -2, "dispatched");
+    lua_pushnumber(L, emit.skipped);
+    lua_setfield(L, -2, "skipped");
+    lua_pushnumber(L, stats.emitted);
+    lua_setfield(L, -2, "emitted");
+    lua_pushnumber(L, stats.collapsed);
+    lua_setfield(L, -2, "collapsed");
+    lua_pushnumber(L, stats.delivered);
+    lua_setfield(L, -2, "delivered");
+    lua_pushnumber(L, stats.dropped);
+    lua_setfield(L, -2, "dropped");
+
+    return 1;
+}
+
+static void push_pool_stats(struct cwc_pool *pool, void *data)
+{
+    lua_State *L = data;
+
+    lua_createtable(L, 0, 6);
+    lua_pushnumber(L, pool->stats.live);
+    lua_setfield(L, -2, "live");
+    lua_pushnumber(L, pool->stats.peak);
+    lua_setfield(L, -2, "peak");
+    lua_pushnumber(L, pool->stats.reuse);
+    lua_setfield(L, -2, "reuse");
+    lua_pushnumber(L, pool->stats.allocs);
+    lua_setfield(L, -2, "allocs");
+    lua_pushnumber(L, pool->stats.slabs);
+    lua_setfield(L, -2, "slabs");
+    lua_pushnumber(L, pool->stats.slabs * pool->slab_len);
+    lua_setfield(L, -2, "capacity");
+    lua_setfield(L, -2, pool->name);
+}
+
+/** Get the object pool allocator counter.
+ *
+ * The table is keyed by the pool name (`bsp_node`, `keybind_info`,
+ * `signal_c_callback`, `signal_lua_callback`, `timer`, `wl_listener`), each
+ * contain `live`, `peak`, `reuse` (allocation served from a freed object),
+ * `allocs`, `slabs` and `capacity`. Pool that never allocate is not listed.
+ *
+ * @staticfct pool_stats
+ * @treturn table The counter of every pool.
+ */
+static int luaC_pool_stats(lua_State *L)
+{
+    lua_newtable(L);
+    cwc_pool_for_each(push_pool_stats, L);
+
+    return 1;
+}
+
+const char *const LUAC_IPC_FUNCTION_REGISTRY_KEY = "cwc.ipc.function";
+
+/** Register a function that ipc client can call by name.
+ *
+ * Calling a registered function from `cwctl --call` skip the lua parser
+ * entirely, the arguments are passed as string.
+ *
+ * @staticfct ipc_register
+ * @tparam string name Name of the function for the ipc client.
+ * @tparam[opt] function func The function, nil to unregister.
+ * @noreturn
+ */
+static int luaC_ipc_register(lua_State *L)
+{
+    const char *name = luaL_checkstring(L, 1);
+    if (!lua_isnoneornil(L, 2))
+        luaL_checktype(L, 2, LUA_TFUNCTION);
+    lua_settop(L, 2);
+
+    lua_getfield(L, LUA_REGISTRYINDEX, LUAC_IPC_FUNCTION_REGISTRY_KEY);
+    if (lua_isnil(L, -1)) {
+        lua_pop(L, 1);
+        lua_newtable(L);
+        lua_pushvalue(L, -1);
+        lua_setfield(L, LUA_REGISTRYINDEX, LUAC_IPC_FUNCTION_REGISTRY_KEY);
+    }
+
+    lua_pushvalue(L, 2);
+    lua_setfield(L, -2, name);
+
+    return 0;
+}
+
 static void create_output(struct wlr_backend *backend, void *data)
 {
     int *total_output = data;
@@ -679,6 +803,10 @@ int luaC_init()
         {"connect_signal",    luaC_connect_signal   },
         {"disconnect_signal", luaC_disconnect_signal},
         {"emit_signal",       luaC_emit_signal      },
+        {"signal_stats",      luaC_signal_stats     },
+        {"pool_stats",        luaC_pool_stats       },
+
+        {"ipc_register",      luaC_ipc_register     },
 
         {"is_nested",         luaC_is_nested        },
         {"is_startup",        luaC_is_startup       },
@@ -795,3 +923,41 @@ void luaC_box_from_table(lua_State *L, int table_pos, struct wlr_box *box)
         box->height = luaL_checkint(L, -1);
     lua_pop(L, 1);
 }
+
+/* replace the list on top of the stack with a shallow copy of it */
+static void luaC_list_copy(lua_State *L)
+{
+    int len = lua_objlen(L, -1);
+    lua_createtable(L, len, 0);
+    for (int i = 1; i <= len; i++) {
+        lua_rawgeti(L, -2, i);
+        lua_rawseti(L, -2, i);
+    }
+
+    lua_replace(L, -2);
+}
+
+bool luaC_list_cache_get(lua_State *L, uint64_t *slot, uint64_t generation)
+{
+    // the table is keyed by the slot address in the registry so it's gone
+    // along with the lua state on reload
+    lua_pushlightuserdata(L, slot);
+    lua_rawget(L, LUA_REGISTRYINDEX);
+    if (*slot == generation && lua_istable(L, -1)) {
+        luaC_list_copy(L);
+        return true;
+    }
+
+    lua_pop(L, 1);
+    return false;
+}
+
+void luaC_list_cache_set(lua_State *L, uint64_t *slot, uint64_t generation)
+{
+    lua_pushlightuserdata(L, slot);
+    lua_pushvalue(L, -2);
+    lua_rawset(L, LUA_REGISTRYINDEX);
+    *slot = generation;
+
+    luaC_list_copy(L);
+}
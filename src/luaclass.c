@@ -19,6 +19,7 @@
 #include "cwc/luac.h"
 #include <lauxlib.h>
 #include <lua.h>
+#include <string.h>
 
 const char *const client_classname      = "cwc_client";
 const char *const container_classname   = "cwc_container";
@@ -42,13 +43,21 @@ const char *const tablet_classname      = "cwc_tablet";
  * 5. Create tests (optional)
  */
 
+/* upvalues of the class __index and __newindex closure */
+#define CLASS_UPVALUE_PROPS lua_upvalueindex(1)
+#define CLASS_UPVALUE_INDEX lua_upvalueindex(2)
+
+/* upvalues of the method table __newindex closure */
+#define METHOD_UPVALUE_INDEX   lua_upvalueindex(1)
+#define METHOD_UPVALUE_GETTERS lua_upvalueindex(2)
+#define METHOD_UPVALUE_SETTERS lua_upvalueindex(3)
+
 /* equivalent lua code:
- * function(t, k)
+ * local getters = { [k] = index["get_" .. k] } -- updated on index write
  *
- *   local mt = getmetatable(t)
- *   local index = mt.__cwcindex
+ * function(t, k)
  *
- *   if index["get_" .. k] then return index["get_" .. k]() end
+ *   if getters[k] then return getters[k](t) end
  *
  *   return index[k]
  *
@@ -56,16 +65,8 @@ const char *const tablet_classname      = "cwc_tablet";
  */
 static int luaC_getter(lua_State *L)
 {
-    if (!lua_getmetatable(L, 1))
-        return 0;
-
-    lua_getfield(L, -1, "__cwcindex");
-
-    lua_pushstring(L, "get_");
     lua_pushvalue(L, 2);
-    lua_concat(L, 2);
-
-    lua_rawget(L, -2);
+    lua_rawget(L, CLASS_UPVALUE_PROPS);
 
     if (lua_isfunction(L, -1)) {
         lua_pushvalue(L, 1);
@@ -75,49 +76,102 @@ static int luaC_getter(lua_State *L)
 
     lua_pop(L, 1);
     lua_pushvalue(L, 2);
-    lua_gettable(L, -2);
+    lua_rawget(L, CLASS_UPVALUE_INDEX);
 
     return 1;
 }
 
 /* equivalent lua code:
- * function(t, k, v)
+ * local setters = { [k] = index["set_" .. k] } -- updated on index write
  *
- *   local mt = getmetatable(t)
- *   local index = mt.__cwcindex
+ * function(t, k, v)
  *
- *   if not index["set_" .. k] then return end
+ *   if not setters[k] then return end
  *
- *   mt.[k](t, v)
+ *   setters[k](t, v)
  *
  * end
  */
 static int luaC_setter(lua_State *L)
 {
-    if (!lua_getmetatable(L, 1))
+    lua_pushvalue(L, 2);
+    lua_rawget(L, CLASS_UPVALUE_PROPS);
+
+    if (lua_isnil(L, -1))
         return 0;
 
-    lua_getfield(L, -1, "__cwcindex");
+    lua_pushvalue(L, 1);
+    lua_pushvalue(L, 3);
 
-    lua_pushstring(L, "set_");
+    lua_call(L, 2, 0);
+
+    return 0;
+}
+
+/* equivalent lua code:
+ * function(t, k, v)
+ *
+ *   index[k] = v
+ *
+ *   if k:sub(1, 4) == "get_" then getters[k:sub(5)] = v end
+ *   if k:sub(1, 4) == "set_" then setters[k:sub(5)] = v end
+ *
+ * end
+ */
+static int luaC_method_newindex(lua_State *L)
+{
+    lua_settop(L, 3);
     lua_pushvalue(L, 2);
-    lua_concat(L, 2);
+    lua_pushvalue(L, 3);
+    lua_rawset(L, METHOD_UPVALUE_INDEX);
 
-    lua_rawget(L, -2);
+    if (lua_type(L, 2) != LUA_TSTRING)
+        return 0;
 
-    if (lua_isnil(L, -1))
+    const char *key = lua_tostring(L, 2);
+    int props;
+    if (strncmp(key, "get_", 4) == 0)
+        props = METHOD_UPVALUE_GETTERS;
+    else if (strncmp(key, "set_", 4) == 0)
+        props = METHOD_UPVALUE_SETTERS;
+    else
         return 0;
 
-    lua_pushvalue(L, 1);
+    if (key[4] == '\0')
+        return 0;
+
+    lua_pushstring(L, key + 4);
     lua_pushvalue(L, 3);
+    lua_rawset(L, props);
 
-    lua_call(L, 2, 0);
+    return 0;
+}
 
-    return 1;
+/* push table that map the property name to the method with the prefix so the
+ * accessor doesn't need to concat string.
+ *
+ * [-0, +1, m]
+ */
+static void luaC_push_property_table(lua_State *L,
+                                     luaL_Reg methods[],
+                                     const char *prefix)
+{
+    size_t prefix_len = strlen(prefix);
+
+    lua_newtable(L);
+    for (luaL_Reg *reg = methods; reg->name; reg++) {
+        if (strncmp(reg->name, prefix, prefix_len) != 0
+            || reg->name[prefix_len] == '\0')
+            continue;
+
+        lua_pushcfunction(L, reg->func);
+        lua_setfield(L, -2, reg->name + prefix_len);
+    }
 }
 
 /* methods that start with `get_` can be accessed without the prefix,
- * for example c:get_fullscreen() is the same as c.fullscreen
+ * for example c:get_fullscreen() is the same as c.fullscreen. Method added
+ * or replaced later through the metatable __cwcindex is picked up too.
  *
  * [-0, +0, -]
  */
@@ -130,19 +184,43 @@ void luaC_register_class(lua_State *L,
     // index and newindex
     luaL_newmetatable(L, classname);
     luaL_register(L, NULL, metamethods);
+    lua_pushstring(L, classname);
+    lua_setfield(L, -2, "__name");
 
     lua_newtable(L);
     luaL_register(L, NULL, methods);
-    lua_setfield(L, -2, "__cwcindex");
 
-    lua_pushcfunction(L, luaC_getter);
-    lua_setfield(L, -2, "__index");
+    // stack: metatable, index
+    luaC_push_property_table(L, methods, "get_");
+    luaC_push_property_table(L, methods, "set_");
+
+    // stack: metatable, index, getters, setters
+    lua_pushvalue(L, -2);
+    lua_pushvalue(L, -4);
+    lua_pushcclosure(L, luaC_getter, 2);
+    lua_setfield(L, -5, "__index");
 
-    lua_pushcfunction(L, luaC_setter);
+    lua_pushvalue(L, -1);
+    lua_pushvalue(L, -4);
+    lua_pushcclosure(L, luaC_setter, 2);
+    lua_setfield(L, -5, "__newindex");
+
+    // the method table exposed as __cwcindex is an empty proxy so every
+    // write reach the newindex below and the property table stay in sync
+    lua_newtable(L);
+    lua_newtable(L);
+    lua_pushvalue(L, -5);
+    lua_setfield(L, -2, "__index");
+    lua_pushvalue(L, -5);
+    lua_pushvalue(L, -5);
+    lua_pushvalue(L, -5);
+    lua_pushcclosure(L, luaC_method_newindex, 3);
     lua_setfield(L, -2, "__newindex");
+    lua_setmetatable(L, -2);
+    lua_setfield(L, -5, "__cwcindex");
 
-    // pop metatable
-    lua_pop(L, 1);
+    // pop setters, getters, index and metatable
+    lua_pop(L, 4);
 }
 
 /* equivalent lua code:
@@ -24,16 +24,23 @@
 const char *const LUAC_OBJECT_REGISTRY_KEY       = "cwc.object.registry";
 const char *const LUAC_OBJECT_UDATA_REGISTRY_KEY = "cwc.object.data.registry";
 
+int luaC_object_registry_ref       = LUA_NOREF;
+int luaC_object_udata_registry_ref = LUA_NOREF;
+
+uint64_t luaC_object_serial = 0;
+
 /** Setup the object system at startup.
  * \param L The Lua VM state.
  */
 void luaC_object_setup(lua_State *L)
 {
-    lua_pushstring(L, LUAC_OBJECT_REGISTRY_KEY);
     lua_newtable(L);
-    lua_rawset(L, LUA_REGISTRYINDEX);
+    lua_pushvalue(L, -1);
+    luaC_object_registry_ref = luaL_ref(L, LUA_REGISTRYINDEX);
+    lua_setfield(L, LUA_REGISTRYINDEX, LUAC_OBJECT_REGISTRY_KEY);
 
-    lua_pushstring(L, LUAC_OBJECT_UDATA_REGISTRY_KEY);
     lua_newtable(L);
-    lua_rawset(L, LUA_REGISTRYINDEX);
+    lua_pushvalue(L, -1);
+    luaC_object_udata_registry_ref = luaL_ref(L, LUA_REGISTRYINDEX);
+    lua_setfield(L, LUA_REGISTRYINDEX, LUAC_OBJECT_UDATA_REGISTRY_KEY);
 }
@@ -20,6 +20,7 @@
 #include <getopt.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <wayland-server-core.h>
 #include <wlr/util/log.h>
@@ -71,6 +72,10 @@ int main(int argc, char **argv)
     int exit_value    = 0;
     char log_level    = WLR_ERROR;
 
+    // must come first, the helper shouldn't touch the compositor state
+    if (argc > 1 && strcmp(argv[1], CWC_SPAWN_HELPER_ARG) == 0)
+        return spawn_helper_main(argc, argv);
+
     // setvbuf(stdout, NULL, _IONBF, 0);
     setenv("XDG_CURRENT_DESKTOP", "cwc", true);
     setenv("_JAVA_AWT_WM_NONREPARENTING", "1", true);
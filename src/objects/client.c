@@ -276,6 +276,8 @@ static int luaC_client_move_to(lua_State *L)
     return 0;
 }
 
+static uint64_t client_get_cache[2];
+
 /** Get all clients into a table.
  *
  * @tparam[opt] cwc_screen screen A screen to filter clients on.
@@ -293,6 +295,12 @@ static int luaC_client_get(lua_State *L)
 
     int skip_unmanaged = lua_toboolean(L, 2);
 
+    uint64_t *cache =
+        screen ? &screen->state->list_cache[OUTPUT_LIST_CLIENTS][skip_unmanaged]
+               : &client_get_cache[skip_unmanaged];
+    if (luaC_list_cache_get(L, cache, server.list_generation))
+        return 1;
+
     lua_newtable(L);
 
     struct cwc_toplevel *toplevel;
@@ -312,6 +320,7 @@ static int luaC_client_get(lua_State *L)
         lua_rawseti(L, -2, i++);
     }
 
+    luaC_list_cache_set(L, cache, server.list_generation);
     return 1;
 }
 
@@ -353,6 +362,19 @@ static int luaC_client_focused(lua_State *L)
     return 1;
 }
 
+/** Get the number of live toplevel capture scene.
+ *
+ * The capture scene only created when the client is being captured.
+ *
+ * @staticfct capture_scene_count
+ * @treturn integer
+ */
+static int luaC_client_capture_scene_count(lua_State *L)
+{
+    lua_pushinteger(L, server.capture_scene_count);
+    return 1;
+}
+
 /** Set the default decoration mode.
  *
  * @tfield number default_decoration_mode
@@ -894,11 +916,8 @@ static int luaC_client_set_bspfact(lua_State *L)
     if (!node || !node->parent)
         return 0;
 
-    double newfact           = CLAMP(luaL_checknumber(L, 2), 0.05, 0.95);
-    node->parent->left_wfact = newfact;
-
-    transaction_schedule_tag(
-        cwc_output_get_current_tag_info(toplevel->container->output));
+    double newfact = CLAMP(luaL_checknumber(L, 2), 0.05, 0.95);
+    bsp_node_set_wfact(node->parent, newfact);
 
     return 0;
 }
@@ -1265,6 +1284,7 @@ void luaC_client_setup(lua_State *L)
         {"get",                       luaC_client_get                      },
         {"at",                        luaC_client_at                       },
         {"focused",                   luaC_client_focused                  },
+        {"capture_scene_count",       luaC_client_capture_scene_count      },
 
         FIELD(default_decoration_mode),
 
@@ -55,7 +55,7 @@ static int luaC_kbindmap_set_active(lua_State *L)
     luaL_checktype(L, 2, LUA_TBOOLEAN);
     struct cwc_keybind_map *kmap = luaC_kbindmap_checkudata(L, 1);
 
-    kmap->active = lua_toboolean(L, 2);
+    cwc_keybind_map_set_active(kmap, lua_toboolean(L, 2));
 
     return 0;
 }
@@ -132,10 +132,10 @@ static int luaC_kbindmap_active_only(lua_State *L)
     struct cwc_keybind_map *input_dev;
     wl_list_for_each(input_dev, &server.kbd_kmaps, link)
     {
-        input_dev->active = false;
+        cwc_keybind_map_set_active(input_dev, false);
     }
 
-    kmap->active = true;
+    cwc_keybind_map_set_active(kmap, true);
 
     return 0;
 }
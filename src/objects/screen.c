@@ -641,6 +641,11 @@ static int luaC_screen_get_containers(lua_State *L)
     struct cwc_output *output = luaC_screen_checkudata(L, 1);
     bool visible_only         = lua_toboolean(L, 2);
 
+    uint64_t *cache =
+        &output->state->list_cache[OUTPUT_LIST_CONTAINERS][visible_only];
+    if (luaC_list_cache_get(L, cache, server.list_generation))
+        return 1;
+
     lua_newtable(L);
 
     struct cwc_container *container;
@@ -662,6 +667,7 @@ static int luaC_screen_get_containers(lua_State *L)
         lua_rawseti(L, -2, i++);
     }
 
+    luaC_list_cache_set(L, cache, server.list_generation);
     return 1;
 }
 
@@ -678,6 +684,11 @@ static int luaC_screen_get_clients(lua_State *L)
     struct cwc_output *output = luaC_screen_checkudata(L, 1);
     bool visible_only         = lua_toboolean(L, 2);
 
+    uint64_t *cache =
+        &output->state->list_cache[OUTPUT_LIST_TOPLEVELS][visible_only];
+    if (luaC_list_cache_get(L, cache, server.list_generation))
+        return 1;
+
     lua_newtable(L);
 
     struct cwc_toplevel *toplevel;
@@ -698,6 +709,7 @@ static int luaC_screen_get_clients(lua_State *L)
         lua_rawseti(L, -2, i++);
     }
 
+    luaC_list_cache_set(L, cache, server.list_generation);
     return 1;
 }
 
@@ -712,6 +724,11 @@ static int luaC_screen_get_focus_stack(lua_State *L)
     struct cwc_output *output = luaC_screen_checkudata(L, 1);
     bool visible_only         = lua_toboolean(L, 2);
 
+    uint64_t *cache =
+        &output->state->list_cache[OUTPUT_LIST_FOCUS_STACK][visible_only];
+    if (luaC_list_cache_get(L, cache, server.list_generation))
+        return 1;
+
     lua_newtable(L);
 
     struct cwc_container *container;
@@ -732,6 +749,7 @@ static int luaC_screen_get_focus_stack(lua_State *L)
         lua_rawseti(L, -2, i++);
     }
 
+    luaC_list_cache_set(L, cache, server.list_generation);
     return 1;
 }
 
@@ -748,6 +766,11 @@ static int luaC_screen_get_minimized(lua_State *L)
     struct cwc_output *output = luaC_screen_checkudata(L, 1);
     bool visible_only         = lua_toboolean(L, 2);
 
+    uint64_t *cache =
+        &output->state->list_cache[OUTPUT_LIST_MINIMIZED][visible_only];
+    if (luaC_list_cache_get(L, cache, server.list_generation))
+        return 1;
+
     lua_newtable(L);
 
     struct cwc_container *container;
@@ -769,6 +792,7 @@ static int luaC_screen_get_minimized(lua_State *L)
         lua_rawseti(L, -2, i++);
     }
 
+    luaC_list_cache_set(L, cache, server.list_generation);
     return 1;
 }
 
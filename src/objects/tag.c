@@ -99,6 +99,51 @@ static int luaC_tag_get_screen(lua_State *L)
     return 1;
 }
 
+/** Number of managed clients in this tag.
+ *
+ * @property client_count
+ * @tparam integer client_count
+ * @readonly
+ * @propertydefault 0
+ */
+static int luaC_tag_get_client_count(lua_State *L)
+{
+    struct cwc_tag_info *tag = luaC_tag_checkudata(L, 1);
+    lua_pushinteger(L, tag->client_count);
+
+    return 1;
+}
+
+/** Number of urgent clients in this tag.
+ *
+ * @property urgent_count
+ * @tparam integer urgent_count
+ * @readonly
+ * @propertydefault 0
+ */
+static int luaC_tag_get_urgent_count(lua_State *L)
+{
+    struct cwc_tag_info *tag = luaC_tag_checkudata(L, 1);
+    lua_pushinteger(L, tag->urgent_count);
+
+    return 1;
+}
+
+/** True if the focused client is in this tag.
+ *
+ * @property focused
+ * @tparam boolean focused
+ * @readonly
+ * @propertydefault false
+ */
+static int luaC_tag_get_focused(lua_State *L)
+{
+    struct cwc_tag_info *tag = luaC_tag_checkudata(L, 1);
+    lua_pushboolean(L, tag->focused_count > 0);
+
+    return 1;
+}
+
 /** The label or name of the tag.
  *
  * @property label
@@ -146,6 +191,7 @@ static int luaC_tag_set_selected(lua_State *L)
         output->state->active_tag |= 1 << (tag->index - 1);
     else
         output->state->active_tag &= ~(1 << (tag->index - 1));
+    cwc_output_lists_changed();
 
     transaction_schedule_output(output);
     transaction_schedule_tag(cwc_output_get_current_tag_info(output));
@@ -384,6 +430,9 @@ void luaC_tag_setup(lua_State *L)
         REG_READ_ONLY(data),
         REG_READ_ONLY(index),
         REG_READ_ONLY(screen),
+        REG_READ_ONLY(client_count),
+        REG_READ_ONLY(urgent_count),
+        REG_READ_ONLY(focused),
 
         // properties
         REG_PROPERTY(label),
@@ -40,10 +40,11 @@
 
 const char *const LUAC_TIMER_REGISTRY_KEY = "cwc.timer.registry";
 
+CWC_POOL_DEFINE(timer, struct cwc_timer, 32)
+
 static inline void luaC_timer_registry_push(lua_State *L)
 {
-    lua_pushstring(L, LUAC_OBJECT_REGISTRY_KEY);
-    lua_rawget(L, LUA_REGISTRYINDEX);
+    luaC_object_registry_push(L);
 }
 
 void cwc_timer_destroy(struct cwc_timer *timer)
@@ -55,7 +56,7 @@ void cwc_timer_destroy(struct cwc_timer *timer)
     luaC_timer_registry_push(L);
     luaL_unref(L, -1, timer->cb_ref);
     luaL_unref(L, -1, timer->data_ref);
-    free(timer);
+    timer_free(timer);
 }
 
 static int timer_timed_out(void *data)
@@ -106,7 +107,7 @@ static int luaC_timer_new(lua_State *L)
     luaL_checktype(L, 2, LUA_TFUNCTION);
     bool has_userdata = !lua_isnoneornil(L, 4);
 
-    struct cwc_timer *timer = calloc(1, sizeof(*timer));
+    struct cwc_timer *timer = timer_alloc();
     timer->timeout_ms       = timeout * 1000;
 
     bool autostart = true;
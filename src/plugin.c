@@ -106,7 +106,7 @@ struct cwc_plugin *__load_plugin(const char *pathname, int __mode)
 
     lua_State *L = g_config_get_lua_State();
     luaC_object_plugin_register(L, p);
-    cwc_object_emit_signal_simple("plugin::load", L, p);
+    cwc_object_emit_signal_simple_id(CWC_SIGNAL("plugin::load"), L, p);
 
     cwc_log(CWC_DEBUG, "loaded plugin: %s", p->name);
     return p;
@@ -134,7 +134,7 @@ void cwc_plugin_unload(struct cwc_plugin *plugin)
         return;
 
     lua_State *L = g_config_get_lua_State();
-    cwc_object_emit_signal_simple("plugin::unload", L, plugin);
+    cwc_object_emit_signal_simple_id(CWC_SIGNAL("plugin::unload"), L, plugin);
 
     cwc_log(CWC_DEBUG, "unloading plugin: %s", plugin->name);
     exit_fn();
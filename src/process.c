@@ -16,14 +16,22 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // POSIX_SPAWN_SETSID and pipe2
+#endif
+
 #include <assert.h>
+#include <errno.h>
 #include <fcntl.h>
 #include <signal.h>
+#include <spawn.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/ioctl.h>
 #include <sys/wait.h>
+#include <time.h>
 #include <unistd.h>
 #include <wayland-server-core.h>
 #include <wayland-util.h>
@@ -77,36 +85,57 @@ static void _spawn_exit_callback_call(struct spawn_obj *obj, int exit_code)
     }
 }
 
-static void free_spawn_obj(struct spawn_obj *obj)
+static void free_callback_info(struct cwc_process_callback_info *info)
 {
-    struct cwc_process_callback_info *info = obj->info;
-
-    if (obj->info->type == CWC_PROCESS_TYPE_LUA) {
+    if (info->type == CWC_PROCESS_TYPE_LUA) {
         lua_State *L = g_config_get_lua_State();
         luaL_unref(L, LUA_REGISTRYINDEX, info->luaref_ioready);
         luaL_unref(L, LUA_REGISTRYINDEX, info->luaref_exited);
         luaL_unref(L, LUA_REGISTRYINDEX, info->luaref_data);
     }
 
-    wl_list_remove(&obj->link);
     free(info);
+}
+
+static void close_spawn_pipe(struct wl_event_source **source, int fd)
+{
+    if (!*source)
+        return;
+
+    wl_event_source_remove(*source);
+    close(fd);
+    *source = NULL;
+}
+
+static void free_spawn_obj(struct spawn_obj *obj)
+{
+    // the child may exit before its output is drained
+    close_spawn_pipe(&obj->out, obj->pipefd_out);
+    close_spawn_pipe(&obj->err, obj->pipefd_err);
+
+    wl_list_remove(&obj->link);
+    free_callback_info(obj->info);
     free(obj);
 }
 
 static void process_dead_child()
 {
     int exit_code;
-    pid_t waited_pid = waitpid(-1, &exit_code, WNOHANG);
-    exit_code        = WEXITSTATUS(exit_code);
+    pid_t waited_pid;
 
-    struct spawn_obj *obj, *obj_temp;
-    wl_list_for_each_safe(obj, obj_temp, &monitored_child, link)
-    {
-        if (waited_pid != obj->pid)
-            continue;
+    // SIGCHLD may be coalesced, reap everything that already exited
+    while ((waited_pid = waitpid(-1, &exit_code, WNOHANG)) > 0) {
+        exit_code = WEXITSTATUS(exit_code);
 
-        _spawn_exit_callback_call(obj, exit_code);
-        free_spawn_obj(obj);
+        struct spawn_obj *obj, *obj_temp;
+        wl_list_for_each_safe(obj, obj_temp, &monitored_child, link)
+        {
+            if (waited_pid != obj->pid)
+                continue;
+
+            _spawn_exit_callback_call(obj, exit_code);
+            free_spawn_obj(obj);
+        }
     }
 }
 
@@ -165,22 +194,117 @@ void cleanup_process(struct cwc_server *s)
     close(sigpfd[1]);
 }
 
+static inline uint64_t get_current_time_usec()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000ULL + now.tv_nsec / 1000;
+}
+
+/* Launch a process in a new session without fork, posix_spawn use vfork
+ * semantic so the compositor address space is never copied. The time the
+ * main loop is blocked is logged in debug level.
+ *
+ * return pid of the child or -1 on failure.
+ */
+static pid_t spawn_process(char *const argv[],
+                           const posix_spawn_file_actions_t *actions,
+                           const char *desc)
+{
+    // don't leak the compositor signal disposition and mask to the child
+    sigset_t sigdefault, sigmask;
+    sigemptyset(&sigmask);
+    sigemptyset(&sigdefault);
+    sigaddset(&sigdefault, SIGINT);
+    sigaddset(&sigdefault, SIGQUIT);
+    sigaddset(&sigdefault, SIGTERM);
+    sigaddset(&sigdefault, SIGCHLD);
+    sigaddset(&sigdefault, SIGPIPE);
+
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    posix_spawnattr_setsigdefault(&attr, &sigdefault);
+    posix_spawnattr_setsigmask(&attr, &sigmask);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSID | POSIX_SPAWN_SETSIGDEF
+                                        | POSIX_SPAWN_SETSIGMASK);
+
+    pid_t pid;
+    uint64_t start = get_current_time_usec();
+    int err        = posix_spawnp(&pid, argv[0], actions, &attr, argv, environ);
+    uint64_t stall = get_current_time_usec() - start;
+
+    posix_spawnattr_destroy(&attr);
+
+    if (err) {
+        cwc_log(CWC_ERROR, "spawn failed [%d]: %s", err, desc);
+        return -1;
+    }
+
+    cwc_log(CWC_DEBUG, "spawned in %lu us: %s", (unsigned long)stall, desc);
+    return pid;
+}
+
+/* Run as `cwc --spawn-helper program args...`, fork the program and exit
+ * right away so the program is reparented to init like a double fork while
+ * the compositor itself never fork. The new session, signal disposition, and
+ * mask set by posix_spawn are inherited by the program.
+ */
+int spawn_helper_main(int argc, char **argv)
+{
+    if (argc < 3)
+        return 1;
+
+    // report exec failure through a cloexec pipe, nobody wait the program
+    int errpipe[2];
+    if (pipe2(errpipe, O_CLOEXEC) == -1)
+        return 1;
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(errpipe[0]);
+        execvp(argv[2], &argv[2]);
+        int err = errno;
+        write(errpipe[1], &err, sizeof(err));
+        _exit(127);
+    }
+
+    close(errpipe[1]);
+    if (pid == -1) {
+        fprintf(stderr, "cwc: can't fork %s: %s\n", argv[2], strerror(errno));
+        return 1;
+    }
+
+    int err;
+    if (read(errpipe[0], &err, sizeof(err)) == sizeof(err)) {
+        fprintf(stderr, "cwc: can't execute %s: %s\n", argv[2], strerror(err));
+        return 127;
+    }
+
+    return 0;
+}
+
+/* spawn the program through the helper mode of our own executable */
+static void spawn_detached(char *const argv[], int argc, const char *desc)
+{
+    char *helper_argv[argc + 3];
+    helper_argv[0] = "/proc/self/exe";
+    helper_argv[1] = CWC_SPAWN_HELPER_ARG;
+    for (int i = 0; i < argc; i++)
+        helper_argv[i + 2] = argv[i];
+    helper_argv[argc + 2] = NULL;
+
+    // the helper exit status is collected by process_dead_child
+    spawn_process(helper_argv, NULL, desc);
+}
+
 void _spawn(void *data)
 {
     struct wl_array *argvarr = data;
     char **argv              = argvarr->data;
+    int argc                 = argvarr->size / sizeof(char *) - 1;
     cwc_log(CWC_DEBUG, "spawning : %s", argv[0]);
-    if (fork() == 0) {
-        setsid();
 
-        // fork again so that it reparent to init when the first fork exited
-        if (fork() == 0) {
-            execvp(argv[0], argv);
-            cwc_log(CWC_ERROR, "spawn failed [%d]: %s", errno, argv[0]);
-        }
-
-        _exit(0);
-    }
+    spawn_detached(argv, argc, argv[0]);
 
     // function has argvarr ownership, release it
     char **s;
@@ -213,16 +337,9 @@ static void _spawn_with_shell(void *data)
 {
     char *command = data;
     cwc_log(CWC_DEBUG, "spawning with shell: %s", command);
-    if (fork() == 0) {
-        setsid();
 
-        if (fork() == 0) {
-            execl("/bin/sh", "/bin/sh", "-c", command, NULL);
-            cwc_log(CWC_ERROR, "spawn with shell failed: %s", command);
-        }
-
-        _exit(0);
-    }
+    char *argv[] = {"/bin/sh", "-c", command, NULL};
+    spawn_detached(argv, 3, command);
 
     free(command);
 }
@@ -272,13 +389,10 @@ static void process_stdfd(int fd, struct spawn_obj *obj, bool is_stdout)
     ioctl(fd, FIONREAD, &ready_bytes);
 
     if (ready_bytes == 0) {
-        if (is_stdout) {
-            wl_event_source_remove(obj->out);
-            close(obj->pipefd_out);
-        } else {
-            wl_event_source_remove(obj->err);
-            close(obj->pipefd_err);
-        }
+        if (is_stdout)
+            close_spawn_pipe(&obj->out, obj->pipefd_out);
+        else
+            close_spawn_pipe(&obj->err, obj->pipefd_err);
         return;
     }
 
@@ -332,9 +446,6 @@ static void _spawn_easy_async(void *data)
     char *command;
     char **argv;
     struct wl_array *argvarr;
-    struct spawn_obj *spawned = calloc(1, sizeof(*spawned));
-    if (!spawned)
-        goto cleanup;
 
     if (userdata->with_shell) {
         command = userdata->command;
@@ -345,36 +456,52 @@ static void _spawn_easy_async(void *data)
         cwc_log(CWC_DEBUG, "spawning : %s", argv[0]);
     }
 
+    struct spawn_obj *spawned = calloc(1, sizeof(*spawned));
+    if (!spawned) {
+        free_callback_info(userdata->info);
+        goto cleanup;
+    }
+
     int pipefd_out[2];
     int pipefd_err[2];
-    pipe(pipefd_out);
-    pipe(pipefd_err);
+    if (pipe2(pipefd_out, O_CLOEXEC) == -1) {
+        cwc_log(CWC_ERROR, "can't create pipe for child process");
+        free_callback_info(userdata->info);
+        free(spawned);
+        goto cleanup;
+    }
+
+    if (pipe2(pipefd_err, O_CLOEXEC) == -1) {
+        cwc_log(CWC_ERROR, "can't create pipe for child process");
+        close(pipefd_out[0]);
+        close(pipefd_out[1]);
+        free_callback_info(userdata->info);
+        free(spawned);
+        goto cleanup;
+    }
+
+    // dup2 clears the cloexec flag so only the write end survive in the child
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, pipefd_out[1], STDOUT_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, pipefd_err[1], STDERR_FILENO);
+
+    pid_t childpid;
+    if (userdata->with_shell) {
+        char *sh_argv[] = {"/bin/sh", "-c", command, NULL};
+        childpid        = spawn_process(sh_argv, &actions, command);
+    } else {
+        childpid = spawn_process(argv, &actions, argv[0]);
+    }
+
+    posix_spawn_file_actions_destroy(&actions);
 
-    pid_t childpid = fork();
     if (childpid == -1) {
-        free(userdata->info);
+        free_callback_info(userdata->info);
         free(spawned);
         close(pipefd_out[0]);
         close(pipefd_err[0]);
-        cwc_log(CWC_ERROR, "can't create child process");
         goto cleanup_fd;
-    } else if (childpid == 0) {
-        setsid();
-
-        close(pipefd_out[0]);
-        close(pipefd_err[0]);
-        dup2(pipefd_out[1], STDOUT_FILENO);
-        dup2(pipefd_err[1], STDERR_FILENO);
-
-        if (userdata->with_shell) {
-            execl("/bin/sh", "/bin/sh", "-c", command, NULL);
-            cwc_log(CWC_ERROR, "spawn with shell failed: %s", command);
-        } else {
-            execvp(argv[0], argv);
-            cwc_log(CWC_ERROR, "spawn failed [%d]: %s", errno, argv[0]);
-        }
-
-        _exit(0);
     }
 
     spawned->pid        = childpid;
@@ -403,6 +530,7 @@ cleanup:
             free(*s);
         }
         wl_array_release(argvarr);
+        free(argvarr);
     }
     free(userdata);
 }
@@ -25,17 +25,50 @@
  * some cleaning up
  */
 
+/* Deferred listener doesn't run on emission, the (signal, object) pair is
+ * queued instead and flushed by the transaction so a property storm (e.g.
+ * switching tag with many clients) only notify the listener once per object.
+ */
+
 #include <stdarg.h>
 #include <stdlib.h>
+#include <string.h>
 #include <wayland-util.h>
 
 #include "cwc/config.h"
+#include "cwc/desktop/transaction.h"
 #include "cwc/luaobject.h"
 #include "cwc/server.h"
 #include "cwc/signal.h"
 #include "cwc/util.h"
 #include "lauxlib.h"
 #include "lua.h"
+#include "private/server.h"
+
+struct signal_deferred {
+    struct cwc_signal_entry *sig_entry;
+    void *object;
+    uint64_t serial; // luaC_object_udata.serial of the object
+};
+
+CWC_POOL_DEFINE(signal_c_callback, struct signal_c_callback, 64)
+CWC_POOL_DEFINE(signal_lua_callback, struct signal_lua_callback, 64)
+
+static struct wl_array deferred_queue; // struct signal_deferred
+static struct cwc_signal_deferred_stats deferred_total;
+static struct cwc_signal_emit_stats emit_total;
+
+/* interned entry indexed by the id, the first element is CWC_SIGNAL_INVALID */
+static struct wl_array signal_table; // struct cwc_signal_entry*
+
+/* return NULL for CWC_SIGNAL_INVALID and id that is never interned */
+static inline struct cwc_signal_entry *signal_entry_from_id(cwc_signal_id_t id)
+{
+    if (id >= signal_table.size / sizeof(struct cwc_signal_entry *))
+        return NULL;
+
+    return ((struct cwc_signal_entry **)signal_table.data)[id];
+}
 
 /* the entry in won't be deleted once create */
 static struct cwc_signal_entry *
@@ -45,49 +78,125 @@ get_signal_entry_or_create_if_not_exist(const char *name)
     if (sig_entry)
         return sig_entry;
 
-    sig_entry = malloc(sizeof(*sig_entry));
+    if (!signal_table.size) {
+        struct cwc_signal_entry **invalid =
+            wl_array_add(&signal_table, sizeof(*invalid));
+        *invalid = NULL;
+    }
+
+    struct cwc_signal_entry **elem =
+        wl_array_add(&signal_table, sizeof(*elem));
+
+    sig_entry       = calloc(1, sizeof(*sig_entry));
+    *elem           = sig_entry;
+    sig_entry->id   = signal_table.size / sizeof(*elem) - 1;
+    sig_entry->name = strdup(name);
     wl_list_init(&sig_entry->c_callbacks);
     wl_list_init(&sig_entry->lua_callbacks);
+    wl_list_init(&sig_entry->deferred_c_callbacks);
+    wl_list_init(&sig_entry->deferred_lua_callbacks);
     cwc_hhmap_insert(server.signal_map, name, sig_entry);
 
     return sig_entry;
 }
 
+cwc_signal_id_t cwc_signal_intern(const char *name)
+{
+    return get_signal_entry_or_create_if_not_exist(name)->id;
+}
+
+cwc_signal_id_t cwc_signal_lookup(const char *name)
+{
+    struct cwc_signal_entry *sig_entry = cwc_hhmap_get(server.signal_map, name);
+
+    return sig_entry ? sig_entry->id : CWC_SIGNAL_INVALID;
+}
+
+const char *cwc_signal_get_name(cwc_signal_id_t id)
+{
+    struct cwc_signal_entry *sig_entry = signal_entry_from_id(id);
+
+    return sig_entry ? sig_entry->name : NULL;
+}
+
 void cwc_signal_connect(const char *name, signal_callback_t callback)
 {
     struct cwc_signal_entry *sig_entry =
         get_signal_entry_or_create_if_not_exist(name);
 
-    struct signal_c_callback *c_callback = malloc(sizeof(*c_callback));
+    struct signal_c_callback *c_callback = signal_c_callback_alloc();
     c_callback->callback                 = callback;
     wl_list_insert(sig_entry->c_callbacks.prev, &c_callback->link);
 }
 
+static void
+signal_lua_callback_create(struct wl_list *list, lua_State *L, int n)
+{
+    struct signal_lua_callback *lua_callback = signal_lua_callback_alloc();
+    wl_list_insert(list->prev, &lua_callback->link);
+
+    lua_pushvalue(L, n);
+    lua_callback->luaref = luaL_ref(L, LUA_REGISTRYINDEX);
+}
+
 void cwc_signal_connect_lua(const char *name, lua_State *L, int n)
 {
     struct cwc_signal_entry *sig_entry =
         get_signal_entry_or_create_if_not_exist(name);
 
-    struct signal_lua_callback *lua_callback = malloc(sizeof(*lua_callback));
-    wl_list_insert(sig_entry->lua_callbacks.prev, &lua_callback->link);
+    signal_lua_callback_create(&sig_entry->lua_callbacks, L, n);
+}
 
-    lua_pushvalue(L, n);
-    lua_callback->luaref = luaL_ref(L, LUA_REGISTRYINDEX);
+static struct cwc_signal_entry *get_deferred_entry(const char *name)
+{
+    struct cwc_signal_entry *sig_entry =
+        get_signal_entry_or_create_if_not_exist(name);
+
+    if (!sig_entry->deferred_queued)
+        sig_entry->deferred_queued = cwc_imap_create(16);
+
+    return sig_entry;
+}
+
+void cwc_signal_connect_deferred(const char *name, signal_callback_t callback)
+{
+    struct cwc_signal_entry *sig_entry = get_deferred_entry(name);
+
+    struct signal_c_callback *c_callback = signal_c_callback_alloc();
+    c_callback->callback                 = callback;
+    wl_list_insert(sig_entry->deferred_c_callbacks.prev, &c_callback->link);
+}
+
+void cwc_signal_connect_lua_deferred(const char *name, lua_State *L, int n)
+{
+    struct cwc_signal_entry *sig_entry = get_deferred_entry(name);
+
+    signal_lua_callback_create(&sig_entry->deferred_lua_callbacks, L, n);
 }
 
 static inline void signal_c_callback_destroy(struct signal_c_callback *c_cb)
 {
     wl_list_remove(&c_cb->link);
-    free(c_cb);
+    signal_c_callback_free(c_cb);
 }
 
-void cwc_signal_disconnect(const char *name, signal_callback_t callback)
+void cwc_signal_ipc_subscribe(const char *name)
 {
-    struct cwc_signal_entry *sig_entry =
-        get_signal_entry_or_create_if_not_exist(name);
+    get_signal_entry_or_create_if_not_exist(name)->ipc_subscribers++;
+}
+
+void cwc_signal_ipc_unsubscribe(const char *name)
+{
+    struct cwc_signal_entry *sig_entry = cwc_hhmap_get(server.signal_map, name);
+    if (sig_entry && sig_entry->ipc_subscribers)
+        sig_entry->ipc_subscribers--;
+}
 
+static void signal_c_callback_remove(struct wl_list *list,
+                                     signal_callback_t callback)
+{
     struct signal_c_callback *c_callback;
-    wl_list_for_each_reverse(c_callback, &sig_entry->c_callbacks, link)
+    wl_list_for_each_reverse(c_callback, list, link)
     {
         if (c_callback->callback == callback) {
             signal_c_callback_destroy(c_callback);
@@ -96,21 +205,38 @@ void cwc_signal_disconnect(const char *name, signal_callback_t callback)
     }
 }
 
+void cwc_signal_disconnect(const char *name, signal_callback_t callback)
+{
+    struct cwc_signal_entry *sig_entry = cwc_hhmap_get(server.signal_map, name);
+    if (!sig_entry)
+        return;
+
+    signal_c_callback_remove(&sig_entry->c_callbacks, callback);
+}
+
+void cwc_signal_disconnect_deferred(const char *name,
+                                    signal_callback_t callback)
+{
+    struct cwc_signal_entry *sig_entry = cwc_hhmap_get(server.signal_map, name);
+    if (!sig_entry)
+        return;
+
+    signal_c_callback_remove(&sig_entry->deferred_c_callbacks, callback);
+}
+
 static inline void signal_lua_callback_destroy(lua_State *L,
                                                struct signal_lua_callback *l_cb)
 {
     luaL_unref(L, LUA_REGISTRYINDEX, l_cb->luaref);
     wl_list_remove(&l_cb->link);
-    free(l_cb);
+    signal_lua_callback_free(l_cb);
 }
 
-void cwc_signal_disconnect_lua(const char *name, lua_State *L, int idx)
+static bool
+signal_lua_callback_remove(struct wl_list *list, lua_State *L, int idx)
 {
-    struct cwc_signal_entry *sig_entry =
-        get_signal_entry_or_create_if_not_exist(name);
-
     struct signal_lua_callback *lua_callback;
-    wl_list_for_each_reverse(lua_callback, &sig_entry->lua_callbacks, link)
+    wl_list_for_each_reverse(lua_callback, list, link)
     {
         lua_pushvalue(L, idx);
         lua_rawgeti(L, LUA_REGISTRYINDEX, lua_callback->luaref);
@@ -120,21 +246,41 @@ void cwc_signal_disconnect_lua(const char *name, lua_State *L, int idx)
 
         if (equal) {
             signal_lua_callback_destroy(L, lua_callback);
-            return;
+            return true;
         }
     }
+
+    return false;
 }
 
-static void signal_entry_wipe_lua(struct cwc_signal_entry *sig_entry)
+void cwc_signal_disconnect_lua(const char *name, lua_State *L, int idx)
+{
+    struct cwc_signal_entry *sig_entry = cwc_hhmap_get(server.signal_map, name);
+    if (!sig_entry)
+        return;
+
+    if (signal_lua_callback_remove(&sig_entry->lua_callbacks, L, idx))
+        return;
+
+    signal_lua_callback_remove(&sig_entry->deferred_lua_callbacks, L, idx);
+}
+
+static void signal_lua_callback_wipe(struct wl_list *list)
 {
     struct signal_lua_callback *cb;
     struct signal_lua_callback *tmp;
-    wl_list_for_each_safe(cb, tmp, &sig_entry->lua_callbacks, link)
+    wl_list_for_each_safe(cb, tmp, list, link)
     {
         signal_lua_callback_destroy(g_config_get_lua_State(), cb);
     }
 }
 
+static void signal_entry_wipe_lua(struct cwc_signal_entry *sig_entry)
+{
+    signal_lua_callback_wipe(&sig_entry->lua_callbacks);
+    signal_lua_callback_wipe(&sig_entry->deferred_lua_callbacks);
+}
+
 void cwc_lua_signal_clear(struct cwc_hhmap *map)
 {
     for (uint64_t i = 0; i < map->alloc; i++) {
@@ -147,22 +293,21 @@ void cwc_lua_signal_clear(struct cwc_hhmap *map)
     }
 }
 
-static void _emit_c(struct cwc_signal_entry *sig_entry, void *data)
+static void _emit_c(struct wl_list *c_callbacks, void *data)
 {
     struct signal_c_callback *c_callback;
-    wl_list_for_each(c_callback, &sig_entry->c_callbacks, link)
+    wl_list_for_each(c_callback, c_callbacks, link)
     {
         c_callback->callback(data);
     }
 }
 
-static void
-_emit_lua(struct cwc_signal_entry *sig_entry, lua_State *L, int nargs)
+static void _emit_lua(struct wl_list *lua_callbacks, lua_State *L, int nargs)
 {
     int initial_stack_size = lua_gettop(L);
 
     struct signal_lua_callback *lua_callback;
-    wl_list_for_each(lua_callback, &sig_entry->lua_callbacks, link)
+    wl_list_for_each(lua_callback, lua_callbacks, link)
     {
         // push function and the argument
         lua_rawgeti(L, LUA_REGISTRYINDEX, lua_callback->luaref);
@@ -178,45 +323,316 @@ _emit_lua(struct cwc_signal_entry *sig_entry, lua_State *L, int nargs)
     }
 }
 
+static inline bool signal_entry_has_deferred(struct cwc_signal_entry *sig_entry)
+{
+    return !wl_list_empty(&sig_entry->deferred_c_callbacks)
+           || !wl_list_empty(&sig_entry->deferred_lua_callbacks);
+}
+
+/* return the pointer and the serial of the cwc object at idx, NULL if it's not
+ * a live cwc object.
+ */
+static void *lua_object_at(lua_State *L, int idx, uint64_t *serial)
+{
+    // only cwc object has __name, see luaC_register_class
+    if (!luaL_getmetafield(L, idx, "__name"))
+        return NULL;
+    lua_pop(L, 1);
+
+    struct luaC_object_udata *udata = lua_touserdata(L, idx);
+    if (!udata || !udata->valid)
+        return NULL;
+
+    *serial = udata->serial;
+    return udata->pointer;
+}
+
+static void _queue_deferred(struct cwc_signal_entry *sig_entry,
+                            void *object,
+                            uint64_t serial)
+{
+    if (!signal_entry_has_deferred(sig_entry))
+        return;
+
+    sig_entry->deferred_stats.emitted++;
+    deferred_total.emitted++;
+
+    // the value is the queue index + 1
+    uintptr_t queued =
+        (uintptr_t)cwc_imap_pget(sig_entry->deferred_queued, object);
+    if (queued) {
+        struct signal_deferred *elem =
+            (struct signal_deferred *)deferred_queue.data + queued - 1;
+
+        // a new object at the address of a destroyed one take over the slot
+        elem->serial = serial;
+        sig_entry->deferred_stats.collapsed++;
+        deferred_total.collapsed++;
+        return;
+    }
+
+    struct signal_deferred *elem = wl_array_add(&deferred_queue, sizeof(*elem));
+    if (!elem)
+        return;
+
+    elem->sig_entry = sig_entry;
+    elem->object    = object;
+    elem->serial    = serial;
+    queued          = deferred_queue.size / sizeof(*elem);
+    cwc_imap_pinsert(sig_entry->deferred_queued, object, (void *)queued);
+
+    transaction_schedule_signal();
+}
+
+/* the object may already be destroyed since it's queued, only deliver if it's
+ * still the same registered object and leave it on the stack. The pointer
+ * alone isn't enough since a pooled object reuse the address.
+ */
+static int push_deferred_object(lua_State *L, void *object, uint64_t serial)
+{
+    if (!object)
+        return 0;
+
+    luaC_object_push(L, object);
+
+    struct luaC_object_udata *udata = lua_touserdata(L, -1);
+    if (udata && udata->serial == serial)
+        return 1;
+
+    lua_pop(L, 1);
+    return -1;
+}
+
+void cwc_signal_flush_deferred()
+{
+    if (!deferred_queue.size)
+        return;
+
+    // listener that emit signal will queue it for the next flush
+    struct wl_array queue = deferred_queue;
+    wl_array_init(&deferred_queue);
+
+    struct signal_deferred *elem;
+    wl_array_for_each(elem, &queue)
+    {
+        if (elem->sig_entry->deferred_queued->size)
+            cwc_imap_clear(elem->sig_entry->deferred_queued);
+    }
+
+    lua_State *L = g_config_get_lua_State();
+    wl_array_for_each(elem, &queue)
+    {
+        struct cwc_signal_entry *sig_entry = elem->sig_entry;
+
+        int nargs = push_deferred_object(L, elem->object, elem->serial);
+        if (nargs < 0) {
+            sig_entry->deferred_stats.dropped++;
+            deferred_total.dropped++;
+            continue;
+        }
+
+        sig_entry->deferred_stats.delivered++;
+        deferred_total.delivered++;
+
+        _emit_c(&sig_entry->deferred_c_callbacks, elem->object);
+        _emit_lua(&sig_entry->deferred_lua_callbacks, L, nargs);
+        lua_pop(L, nargs);
+    }
+
+    wl_array_release(&queue);
+}
+
+bool cwc_signal_get_deferred_stats(const char *name,
+                                   struct cwc_signal_deferred_stats *stats)
+{
+    if (!name) {
+        *stats = deferred_total;
+        return true;
+    }
+
+    struct cwc_signal_entry *sig_entry = cwc_hhmap_get(server.signal_map, name);
+    if (!sig_entry)
+        return false;
+
+    *stats = sig_entry->deferred_stats;
+    return true;
+}
+
+static inline bool signal_entry_has_listener(struct cwc_signal_entry *sig_entry)
+{
+    return !wl_list_empty(&sig_entry->c_callbacks)
+           || !wl_list_empty(&sig_entry->lua_callbacks)
+           || signal_entry_has_deferred(sig_entry)
+           || sig_entry->ipc_subscribers;
+}
+
+/* count the emission and tell whether it's worth to build the argument */
+static bool signal_entry_should_emit(struct cwc_signal_entry *sig_entry)
+{
+    if (!sig_entry) {
+        emit_total.skipped++;
+        return false;
+    }
+
+    if (!signal_entry_has_listener(sig_entry)) {
+        sig_entry->emit_stats.skipped++;
+        emit_total.skipped++;
+        return false;
+    }
+
+    sig_entry->emit_stats.dispatched++;
+    emit_total.dispatched++;
+    return true;
+}
+
+bool cwc_signal_has_listener(cwc_signal_id_t id)
+{
+    struct cwc_signal_entry *sig_entry = signal_entry_from_id(id);
+
+    return sig_entry && signal_entry_has_listener(sig_entry);
+}
+
+bool cwc_signal_prepare_emit(cwc_signal_id_t id)
+{
+    struct cwc_signal_entry *sig_entry = signal_entry_from_id(id);
+    if (sig_entry && signal_entry_has_listener(sig_entry))
+        return true;
+
+    // the dispatch is counted by the emit that follow
+    if (sig_entry)
+        sig_entry->emit_stats.skipped++;
+    emit_total.skipped++;
+    return false;
+}
+
+bool cwc_signal_get_emit_stats(const char *name,
+                               struct cwc_signal_emit_stats *stats)
+{
+    if (!name) {
+        *stats = emit_total;
+        return true;
+    }
+
+    struct cwc_signal_entry *sig_entry = cwc_hhmap_get(server.signal_map, name);
+    if (!sig_entry)
+        return false;
+
+    *stats = sig_entry->emit_stats;
+    return true;
+}
+
+static void _signal_emit_c(struct cwc_signal_entry *sig_entry, void *data)
+{
+    if (!signal_entry_should_emit(sig_entry))
+        return;
+
+    if (sig_entry->ipc_subscribers)
+        ipc_signal_forward(sig_entry->name, NULL, 0);
+
+    _emit_c(&sig_entry->c_callbacks, data);
+    _queue_deferred(sig_entry, NULL, 0);
+}
+
 void cwc_signal_emit_c(const char *name, void *data)
 {
-    struct cwc_signal_entry *sig_entry =
-        get_signal_entry_or_create_if_not_exist(name);
+    _signal_emit_c(cwc_hhmap_get(server.signal_map, name), data);
+}
 
-    _emit_c(sig_entry, data);
+void cwc_signal_emit_c_id(cwc_signal_id_t id, void *data)
+{
+    _signal_emit_c(signal_entry_from_id(id), data);
 }
 
 void cwc_signal_emit_lua(const char *name, lua_State *L, int nargs)
 {
-    struct cwc_signal_entry *sig_entry =
-        get_signal_entry_or_create_if_not_exist(name);
+    struct cwc_signal_entry *sig_entry = cwc_hhmap_get(server.signal_map, name);
+    if (!signal_entry_should_emit(sig_entry))
+        return;
+
+    // object signal emitted from lua collapse per object like the C one
+    uint64_t serial = 0;
+    void *object    = NULL;
+    if (nargs > 0)
+        object = lua_object_at(L, lua_gettop(L) - nargs + 1, &serial);
 
-    _emit_lua(sig_entry, L, nargs);
+    if (sig_entry->ipc_subscribers)
+        ipc_signal_forward(name, L, nargs);
+
+    _emit_lua(&sig_entry->lua_callbacks, L, nargs);
+    _queue_deferred(sig_entry, object, serial);
+}
+
+/* the caller already checked signal_entry_should_emit */
+static void _signal_emit(struct cwc_signal_entry *sig_entry,
+                         void *object,
+                         void *data,
+                         lua_State *L,
+                         int nargs)
+{
+    // the object is pushed as the first argument, an unregistered object keep
+    // the serial 0 and is dropped on flush
+    uint64_t serial = 0;
+    if (object)
+        lua_object_at(L, lua_gettop(L) - nargs + 1, &serial);
+
+    // serialize before any listener touch the stack
+    if (sig_entry->ipc_subscribers)
+        ipc_signal_forward(sig_entry->name, L, nargs);
+
+    _emit_c(&sig_entry->c_callbacks, data);
+    _emit_lua(&sig_entry->lua_callbacks, L, nargs);
+    _queue_deferred(sig_entry, object, serial);
 }
 
 void cwc_signal_emit(const char *name, void *data, lua_State *L, int nargs)
 {
     struct cwc_signal_entry *sig_entry = cwc_hhmap_get(server.signal_map, name);
-    if (!sig_entry)
-        return;
+    if (signal_entry_should_emit(sig_entry))
+        _signal_emit(sig_entry, NULL, data, L, nargs);
+}
 
-    _emit_c(sig_entry, data);
-    _emit_lua(sig_entry, L, nargs);
+void cwc_signal_emit_id(cwc_signal_id_t id, void *data, lua_State *L, int nargs)
+{
+    struct cwc_signal_entry *sig_entry = signal_entry_from_id(id);
+    if (signal_entry_should_emit(sig_entry))
+        _signal_emit(sig_entry, NULL, data, L, nargs);
 }
 
-int cwc_object_emit_signal_simple(const char *name, lua_State *L, void *pointer)
+static void _object_emit_simple(struct cwc_signal_entry *sig_entry,
+                                lua_State *L,
+                                void *pointer)
 {
+    if (!signal_entry_should_emit(sig_entry))
+        return;
+
     luaC_object_push(L, pointer);
-    cwc_signal_emit(name, pointer, L, 1);
+    _signal_emit(sig_entry, pointer, pointer, L, 1);
     lua_pop(L, 1);
+}
+
+int cwc_object_emit_signal_simple(const char *name, lua_State *L, void *pointer)
+{
+    _object_emit_simple(cwc_hhmap_get(server.signal_map, name), L, pointer);
 
     return 0;
 }
 
-void cwc_object_emit_signal_varr(const char *name, lua_State *L, int nargs, ...)
+int cwc_object_emit_signal_simple_id(cwc_signal_id_t id,
+                                     lua_State *L,
+                                     void *pointer)
 {
-    va_list argptr;
-    va_start(argptr, nargs);
+    _object_emit_simple(signal_entry_from_id(id), L, pointer);
+
+    return 0;
+}
+
+static void _object_emit_varr(struct cwc_signal_entry *sig_entry,
+                              lua_State *L,
+                              int nargs,
+                              va_list argptr)
+{
+    if (!signal_entry_should_emit(sig_entry))
+        return;
 
     void **ptr_list[nargs + 1];
     ptr_list[nargs] = NULL;
@@ -227,7 +643,25 @@ void cwc_object_emit_signal_varr(const char *name, lua_State *L, int nargs, ...)
         luaC_object_push(L, data);
     }
 
-    cwc_signal_emit(name, ptr_list, L, nargs);
+    _signal_emit(sig_entry, nargs ? ptr_list[0] : NULL, ptr_list, L, nargs);
+    lua_pop(L, nargs);
+}
+
+void cwc_object_emit_signal_varr(const char *name, lua_State *L, int nargs, ...)
+{
+    va_list argptr;
+    va_start(argptr, nargs);
+    _object_emit_varr(cwc_hhmap_get(server.signal_map, name), L, nargs, argptr);
+    va_end(argptr);
+}
 
+void cwc_object_emit_signal_varr_id(cwc_signal_id_t id,
+                                    lua_State *L,
+                                    int nargs,
+                                    ...)
+{
+    va_list argptr;
+    va_start(argptr, nargs);
+    _object_emit_varr(signal_entry_from_id(id), L, nargs, argptr);
     va_end(argptr);
 }
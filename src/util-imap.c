@@ -0,0 +1,548 @@
+/* util-imap.c - open addressing hashmap with group probed metadata
+ *
+ * Copyright (C) 2026 Dwi Asmoro Bangun <dwiaceromo@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <xxhash.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif /* ifdef __SSE2__ */
+
+#include "cwc/util.h"
+
+#define GROUP_WIDTH  CWC_IMAP_GROUP_WIDTH
+#define CTRL_EMPTY   0x80
+#define CTRL_DELETED 0xfe
+
+//================== GROUP ====================
+
+/* each function return bitmask of the matching slot in the group */
+
+#ifdef __SSE2__
+static inline uint32_t group_match(const uint8_t *group, uint8_t h2)
+{
+    __m128i ctrl = _mm_loadu_si128((const __m128i *)group);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(h2)));
+}
+
+static inline uint32_t group_match_empty(const uint8_t *group)
+{
+    return group_match(group, CTRL_EMPTY);
+}
+
+static inline uint32_t group_match_empty_or_deleted(const uint8_t *group)
+{
+    __m128i ctrl = _mm_loadu_si128((const __m128i *)group);
+    return _mm_movemask_epi8(ctrl);
+}
+#else
+static inline uint32_t group_match(const uint8_t *group, uint8_t h2)
+{
+    uint32_t mask = 0;
+    for (int i = 0; i < GROUP_WIDTH; i++)
+        mask |= (uint32_t)(group[i] == h2) << i;
+
+    return mask;
+}
+
+static inline uint32_t group_match_empty(const uint8_t *group)
+{
+    return group_match(group, CTRL_EMPTY);
+}
+
+static inline uint32_t group_match_empty_or_deleted(const uint8_t *group)
+{
+    uint32_t mask = 0;
+    for (int i = 0; i < GROUP_WIDTH; i++)
+        mask |= (uint32_t)(group[i] >> 7) << i;
+
+    return mask;
+}
+#endif /* ifdef __SSE2__ */
+
+/* lowest set bit index */
+static inline int mask_next(uint32_t mask)
+{
+    return __builtin_ctz(mask);
+}
+
+//================== COMMON ====================
+
+/* finalizer of murmur3, good enough to spread pointer and sequential number */
+static inline uint64_t mix_u64(uint64_t key)
+{
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ULL;
+    key ^= key >> 33;
+    return key;
+}
+
+static inline uint64_t h1(uint64_t hash)
+{
+    return hash >> 7;
+}
+
+static inline uint8_t h2(uint64_t hash)
+{
+    return hash & 0x7f;
+}
+
+/* triangular probing on group granularity, it visit every group when the group
+ * count is power of 2.
+ */
+struct probe_seq {
+    uint64_t mask; // group count - 1
+    uint64_t group;
+    uint64_t stride;
+};
+
+static inline struct probe_seq probe_start(uint64_t hash, uint64_t alloc)
+{
+    uint64_t mask = alloc / GROUP_WIDTH - 1;
+    return (struct probe_seq){.mask = mask, .group = h1(hash) & mask};
+}
+
+static inline void probe_next(struct probe_seq *seq)
+{
+    seq->stride++;
+    seq->group = (seq->group + seq->stride) & seq->mask;
+}
+
+static inline uint64_t initial_alloc(int prealloc_size)
+{
+    uint64_t alloc = GROUP_WIDTH;
+    uint64_t want  = prealloc_size > 0 ? prealloc_size : 0;
+
+    // keep the load factor below 7/8
+    while (alloc - alloc / 8 < want)
+        alloc <<= 1;
+
+    return alloc;
+}
+
+static inline uint64_t capacity_of(uint64_t alloc)
+{
+    return alloc - alloc / 8;
+}
+
+/* find empty or deleted slot for the hash, table must have room */
+static inline uint64_t
+find_insert_slot(uint8_t *ctrl, uint64_t alloc, uint64_t hash)
+{
+    struct probe_seq seq = probe_start(hash, alloc);
+    while (true) {
+        uint8_t *group = &ctrl[seq.group * GROUP_WIDTH];
+        uint32_t mask  = group_match_empty_or_deleted(group);
+        if (mask)
+            return seq.group * GROUP_WIDTH + mask_next(mask);
+
+        probe_next(&seq);
+    }
+}
+
+/* if there's an empty slot in the group, no probe sequence continue past
+ * this group so the slot can be marked empty instead of deleted.
+ */
+static inline bool erase_slot(uint8_t *ctrl, uint64_t idx)
+{
+    uint8_t *group = &ctrl[idx / GROUP_WIDTH * GROUP_WIDTH];
+    if (group_match_empty(group)) {
+        ctrl[idx] = CTRL_EMPTY;
+        return true;
+    }
+
+    ctrl[idx] = CTRL_DELETED;
+    return false;
+}
+
+//================== IMAP ====================
+
+struct cwc_imap *cwc_imap_create(int prealloc_size)
+{
+    struct cwc_imap *m = calloc(1, sizeof(*m));
+    if (!m)
+        return NULL;
+
+    m->alloc       = initial_alloc(prealloc_size);
+    m->growth_left = capacity_of(m->alloc);
+    m->ctrl        = malloc(m->alloc);
+    m->table       = calloc(m->alloc, sizeof(*m->table));
+
+    if (!m->ctrl || !m->table) {
+        free(m->ctrl);
+        free(m->table);
+        free(m);
+        return NULL;
+    }
+
+    memset(m->ctrl, CTRL_EMPTY, m->alloc);
+
+    return m;
+}
+
+void cwc_imap_destroy(struct cwc_imap *map)
+{
+    free(map->ctrl);
+    free(map->table);
+    free(map);
+}
+
+static int64_t imap_find(struct cwc_imap *map, uint64_t key, uint64_t hash)
+{
+    struct probe_seq seq = probe_start(hash, map->alloc);
+    uint8_t tag          = h2(hash);
+
+    // the loop always end since the table never full
+    while (true) {
+        uint8_t *group = &map->ctrl[seq.group * GROUP_WIDTH];
+
+        uint32_t mask = group_match(group, tag);
+        while (mask) {
+            uint64_t idx = seq.group * GROUP_WIDTH + mask_next(mask);
+            if (map->table[idx].key == key)
+                return idx;
+
+            mask &= mask - 1;
+        }
+
+        if (group_match_empty(group))
+            return -1;
+
+        probe_next(&seq);
+    }
+}
+
+static void imap_rehash_to_size(struct cwc_imap *map, uint64_t new_alloc)
+{
+    uint8_t *new_ctrl = malloc(new_alloc);
+    struct cwc_imap_entry *new_table = calloc(new_alloc, sizeof(*new_table));
+    if (!new_ctrl || !new_table) {
+        free(new_ctrl);
+        free(new_table);
+        return;
+    }
+
+    memset(new_ctrl, CTRL_EMPTY, new_alloc);
+
+    for (uint64_t i = 0; i < map->alloc; i++) {
+        if (!cwc_imap_slot_is_full(map, i))
+            continue;
+
+        struct cwc_imap_entry *elem = &map->table[i];
+        uint64_t hash               = mix_u64(elem->key);
+        uint64_t idx = find_insert_slot(new_ctrl, new_alloc, hash);
+
+        new_ctrl[idx]  = h2(hash);
+        new_table[idx] = *elem;
+    }
+
+    free(map->ctrl);
+    free(map->table);
+    map->ctrl        = new_ctrl;
+    map->table       = new_table;
+    map->alloc       = new_alloc;
+    map->growth_left = capacity_of(new_alloc) - map->size;
+}
+
+/* grow when more than half full, otherwise the table is full of tombstones
+ * and rehash in place is enough.
+ */
+static inline void imap_reserve_one(struct cwc_imap *map)
+{
+    if (map->growth_left)
+        return;
+
+    if (map->size * 2 >= capacity_of(map->alloc))
+        imap_rehash_to_size(map, map->alloc * 2);
+    else
+        imap_rehash_to_size(map, map->alloc);
+}
+
+void cwc_imap_insert(struct cwc_imap *map, uint64_t key, void *data)
+{
+    uint64_t hash = mix_u64(key);
+    int64_t found = imap_find(map, key, hash);
+
+    if (found >= 0) {
+        map->table[found].data = data;
+        return;
+    }
+
+    uint64_t idx = find_insert_slot(map->ctrl, map->alloc, hash);
+
+    // reusing tombstone doesn't consume growth
+    if (map->ctrl[idx] == CTRL_EMPTY) {
+        imap_reserve_one(map);
+        if (!map->growth_left)
+            return; // allocation failure
+        idx = find_insert_slot(map->ctrl, map->alloc, hash);
+    }
+
+    if (map->ctrl[idx] == CTRL_EMPTY)
+        map->growth_left--;
+
+    map->ctrl[idx]       = h2(hash);
+    map->table[idx].key  = key;
+    map->table[idx].data = data;
+    map->size++;
+}
+
+void *cwc_imap_get(struct cwc_imap *map, uint64_t key)
+{
+    int64_t found = imap_find(map, key, mix_u64(key));
+    if (found < 0)
+        return NULL;
+
+    return map->table[found].data;
+}
+
+struct cwc_imap_entry *cwc_imap_get_entry(struct cwc_imap *map, uint64_t key)
+{
+    int64_t found = imap_find(map, key, mix_u64(key));
+    if (found < 0)
+        return NULL;
+
+    return &map->table[found];
+}
+
+bool cwc_imap_remove(struct cwc_imap *map, uint64_t key)
+{
+    int64_t found = imap_find(map, key, mix_u64(key));
+    if (found < 0)
+        return false;
+
+    if (erase_slot(map->ctrl, found))
+        map->growth_left++;
+
+    map->table[found] = (struct cwc_imap_entry){0};
+    map->size--;
+
+    return true;
+}
+
+void cwc_imap_clear(struct cwc_imap *map)
+{
+    memset(map->ctrl, CTRL_EMPTY, map->alloc);
+    memset(map->table, 0, map->alloc * sizeof(*map->table));
+    map->size        = 0;
+    map->growth_left = capacity_of(map->alloc);
+}
+
+//================== STRMAP ====================
+
+struct cwc_strmap *cwc_strmap_create(int prealloc_size)
+{
+    struct cwc_strmap *m = calloc(1, sizeof(*m));
+    if (!m)
+        return NULL;
+
+    m->alloc       = initial_alloc(prealloc_size);
+    m->growth_left = capacity_of(m->alloc);
+    m->ctrl        = malloc(m->alloc);
+    m->table       = calloc(m->alloc, sizeof(*m->table));
+
+    if (!m->ctrl || !m->table) {
+        free(m->ctrl);
+        free(m->table);
+        free(m);
+        return NULL;
+    }
+
+    memset(m->ctrl, CTRL_EMPTY, m->alloc);
+
+    return m;
+}
+
+void cwc_strmap_destroy(struct cwc_strmap *map)
+{
+    for (uint64_t i = 0; i < map->alloc; i++) {
+        if (cwc_strmap_slot_is_full(map, i))
+            free(map->table[i].key);
+    }
+
+    free(map->ctrl);
+    free(map->table);
+    free(map);
+}
+
+static int64_t strmap_find(struct cwc_strmap *map,
+                           const char *key,
+                           size_t key_len,
+                           uint64_t hash)
+{
+    struct probe_seq seq = probe_start(hash, map->alloc);
+    uint8_t tag          = h2(hash);
+
+    while (true) {
+        uint8_t *group = &map->ctrl[seq.group * GROUP_WIDTH];
+
+        uint32_t mask = group_match(group, tag);
+        while (mask) {
+            uint64_t idx = seq.group * GROUP_WIDTH + mask_next(mask);
+            struct cwc_strmap_entry *elem = &map->table[idx];
+            if (elem->hash == hash && elem->key_len == key_len
+                && memcmp(elem->key, key, key_len) == 0)
+                return idx;
+
+            mask &= mask - 1;
+        }
+
+        if (group_match_empty(group))
+            return -1;
+
+        probe_next(&seq);
+    }
+}
+
+static void strmap_rehash_to_size(struct cwc_strmap *map, uint64_t new_alloc)
+{
+    uint8_t *new_ctrl                  = malloc(new_alloc);
+    struct cwc_strmap_entry *new_table = calloc(new_alloc, sizeof(*new_table));
+    if (!new_ctrl || !new_table) {
+        free(new_ctrl);
+        free(new_table);
+        return;
+    }
+
+    memset(new_ctrl, CTRL_EMPTY, new_alloc);
+
+    for (uint64_t i = 0; i < map->alloc; i++) {
+        if (!cwc_strmap_slot_is_full(map, i))
+            continue;
+
+        struct cwc_strmap_entry *elem = &map->table[i];
+        uint64_t idx = find_insert_slot(new_ctrl, new_alloc, elem->hash);
+
+        new_ctrl[idx]  = h2(elem->hash);
+        new_table[idx] = *elem;
+    }
+
+    free(map->ctrl);
+    free(map->table);
+    map->ctrl        = new_ctrl;
+    map->table       = new_table;
+    map->alloc       = new_alloc;
+    map->growth_left = capacity_of(new_alloc) - map->size;
+}
+
+static inline void strmap_reserve_one(struct cwc_strmap *map)
+{
+    if (map->growth_left)
+        return;
+
+    if (map->size * 2 >= capacity_of(map->alloc))
+        strmap_rehash_to_size(map, map->alloc * 2);
+    else
+        strmap_rehash_to_size(map, map->alloc);
+}
+
+/* return the entry of the key, inserted with NULL data if not exist */
+static struct cwc_strmap_entry *strmap_find_or_insert(struct cwc_strmap *map,
+                                                      const char *key)
+{
+    size_t key_len = strlen(key);
+    uint64_t hash  = XXH3_64bits(key, key_len);
+    int64_t found  = strmap_find(map, key, key_len, hash);
+
+    if (found >= 0)
+        return &map->table[found];
+
+    uint64_t idx = find_insert_slot(map->ctrl, map->alloc, hash);
+    if (map->ctrl[idx] == CTRL_EMPTY) {
+        strmap_reserve_one(map);
+        if (!map->growth_left)
+            return NULL;
+        idx = find_insert_slot(map->ctrl, map->alloc, hash);
+    }
+
+    char *key_dup = malloc(key_len + 1);
+    if (!key_dup)
+        return NULL;
+    memcpy(key_dup, key, key_len + 1);
+
+    if (map->ctrl[idx] == CTRL_EMPTY)
+        map->growth_left--;
+
+    map->ctrl[idx]  = h2(hash);
+    map->table[idx] = (struct cwc_strmap_entry){
+        .key     = key_dup,
+        .key_len = key_len,
+        .hash    = hash,
+        .data    = NULL,
+    };
+    map->size++;
+
+    return &map->table[idx];
+}
+
+void cwc_strmap_insert(struct cwc_strmap *map, const char *key, void *data)
+{
+    struct cwc_strmap_entry *entry = strmap_find_or_insert(map, key);
+    if (entry)
+        entry->data = data;
+}
+
+struct cwc_strmap_entry *cwc_strmap_get_entry(struct cwc_strmap *map,
+                                              const char *key)
+{
+    size_t key_len = strlen(key);
+    int64_t found =
+        strmap_find(map, key, key_len, XXH3_64bits(key, key_len));
+    if (found < 0)
+        return NULL;
+
+    return &map->table[found];
+}
+
+void *cwc_strmap_get(struct cwc_strmap *map, const char *key)
+{
+    struct cwc_strmap_entry *entry = cwc_strmap_get_entry(map, key);
+    return entry ? entry->data : NULL;
+}
+
+bool cwc_strmap_remove(struct cwc_strmap *map, const char *key)
+{
+    size_t key_len = strlen(key);
+    int64_t found =
+        strmap_find(map, key, key_len, XXH3_64bits(key, key_len));
+    if (found < 0)
+        return false;
+
+    if (erase_slot(map->ctrl, found))
+        map->growth_left++;
+
+    free(map->table[found].key);
+    map->table[found] = (struct cwc_strmap_entry){0};
+    map->size--;
+
+    return true;
+}
+
+const char *cwc_strmap_intern(struct cwc_strmap *map, const char *key)
+{
+    struct cwc_strmap_entry *entry = strmap_find_or_insert(map, key);
+    return entry ? entry->key : NULL;
+}
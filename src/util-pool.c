@@ -0,0 +1,132 @@
+/* util-pool.c - slab allocator for small fixed size object
+ *
+ * Copyright (C) 2026 Dwi Asmoro Bangun <dwiaceromo@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdalign.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wayland-server-core.h>
+
+#include "cwc/util.h"
+
+struct cwc_pool_slab {
+    struct cwc_pool_slab *next;
+    alignas(max_align_t) unsigned char data[];
+};
+
+/* freed object is reused as the free list node */
+struct cwc_pool_free_node {
+    struct cwc_pool_free_node *next;
+};
+
+struct cwc_pool cwc_listener_pool =
+    CWC_POOL_INIT("wl_listener", struct wl_listener, 64);
+
+static struct cwc_pool *registered_pools = NULL;
+
+static inline size_t pool_stride(struct cwc_pool *pool)
+{
+    size_t size  = MAX(pool->elem_size, sizeof(struct cwc_pool_free_node));
+    size_t align = alignof(max_align_t);
+    return (size + align - 1) & ~(align - 1);
+}
+
+static bool pool_grow(struct cwc_pool *pool)
+{
+    struct cwc_pool_slab *slab =
+        malloc(sizeof(*slab) + pool_stride(pool) * pool->slab_len);
+    if (!slab)
+        return false;
+
+    slab->next      = pool->slabs;
+    pool->slabs     = slab;
+    pool->slab_used = 0;
+    pool->stats.slabs++;
+
+    return true;
+}
+
+void *cwc_pool_alloc(struct cwc_pool *pool)
+{
+    if (!pool->registered) {
+        pool->next       = registered_pools;
+        registered_pools = pool;
+        pool->registered = true;
+    }
+
+    void *ptr;
+    size_t stride = pool_stride(pool);
+    if (pool->free_list) {
+        struct cwc_pool_free_node *node = pool->free_list;
+        pool->free_list                 = node->next;
+        ptr                             = node;
+        pool->stats.reuse++;
+    } else {
+        if (!pool->slabs || pool->slab_used >= pool->slab_len) {
+            if (!pool_grow(pool))
+                return NULL;
+        }
+
+        ptr = pool->slabs->data + stride * pool->slab_used++;
+    }
+
+    pool->stats.allocs++;
+    pool->stats.live++;
+    pool->stats.peak = MAX(pool->stats.peak, pool->stats.live);
+
+    return memset(ptr, 0, stride);
+}
+
+void cwc_pool_free(struct cwc_pool *pool, void *ptr)
+{
+    if (!ptr)
+        return;
+
+    struct cwc_pool_free_node *node = ptr;
+    node->next                      = pool->free_list;
+    pool->free_list                 = node;
+    pool->stats.live--;
+}
+
+void cwc_pool_fini(struct cwc_pool *pool)
+{
+    struct cwc_pool_slab *slab = pool->slabs;
+    while (slab) {
+        struct cwc_pool_slab *next = slab->next;
+        free(slab);
+        slab = next;
+    }
+
+    pool->slabs       = NULL;
+    pool->free_list   = NULL;
+    pool->slab_used   = 0;
+    pool->stats.live  = 0;
+    pool->stats.slabs = 0;
+}
+
+void cwc_pool_for_each(void (*fn)(struct cwc_pool *pool, void *data),
+                       void *data)
+{
+    for (struct cwc_pool *pool = registered_pools; pool; pool = pool->next)
+        fn(pool, data);
+}
@@ -0,0 +1,27 @@
+-- micro benchmark, not part of the API test
+
+-- property read throughput, mostly the cost of __index dispatch
+local function client_property_bench()
+    local c = cwc.client.focused()
+    if not c then
+        print("cwc_client property read: no focused client, skipped")
+        return
+    end
+
+    local props = { "title", "appid", "floating", "fullscreen", "tag", "workspace", "pid", "visible" }
+    local loop = 100000
+
+    local start = os.clock()
+    for _ = 1, loop do
+        for i = 1, #props do
+            local _ = c[props[i]]
+        end
+    end
+    local elapsed = os.clock() - start
+
+    print(string.format("cwc_client property read: %.0f reads/s", loop * #props / elapsed))
+end
+
+return function()
+    client_property_bench()
+end
@@ -1,6 +1,8 @@
 #include <assert.h>
 #include <string.h>
+#include <time.h>
 
+#include "cwc/config.h"
 #include "cwc/desktop/toplevel.h"
 #include "cwc/plugin.h"
 #include "cwc/signal.h"
@@ -8,6 +10,57 @@
 
 static int call_counter    = 0;
 static bool already_called = false;
+static int bench_counter   = 0;
+
+static double elapsed_since(struct timespec *start)
+{
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    return (end.tv_sec - start->tv_sec) + (end.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static void on_bench_signal(void *data)
+{
+    bench_counter++;
+}
+
+/* object signal throughput, mostly the cost of pushing the lua object. The
+ * listener is needed since emission without listener skip the push entirely.
+ */
+static void object_signal_bench(struct cwc_toplevel *toplevel)
+{
+    lua_State *L   = g_config_get_lua_State();
+    const int loop = 100000;
+    struct timespec start;
+
+    cwc_signal_id_t id = cwc_signal_intern("bench::object_signal");
+    assert(id == cwc_signal_lookup("bench::object_signal"));
+    assert(strcmp(cwc_signal_get_name(id), "bench::object_signal") == 0);
+    assert(cwc_signal_lookup("bench::not_interned") == CWC_SIGNAL_INVALID);
+    assert(!cwc_signal_has_listener(CWC_SIGNAL_INVALID));
+    assert(!cwc_signal_prepare_emit(cwc_signal_lookup("bench::not_interned")));
+    assert(cwc_signal_get_name(CWC_SIGNAL_INVALID) == NULL);
+
+    cwc_signal_connect("bench::object_signal", on_bench_signal);
+    assert(cwc_signal_has_listener(id));
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < loop; i++)
+        cwc_object_emit_signal_simple("bench::object_signal", L, toplevel);
+    cwc_log(CWC_INFO, "C OBJECT SIGNAL BENCH: %.0f emit/s",
+            loop / elapsed_since(&start));
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < loop; i++)
+        cwc_object_emit_signal_simple_id(id, L, toplevel);
+    cwc_log(CWC_INFO, "C INTERNED OBJECT SIGNAL BENCH: %.0f emit/s",
+            loop / elapsed_since(&start));
+
+    cwc_signal_disconnect("bench::object_signal", on_bench_signal);
+    assert(bench_counter == loop * 2);
+    assert(!cwc_signal_has_listener(id));
+}
 
 static void on_toplevel_map(void *data)
 {
@@ -20,6 +73,8 @@ static void on_toplevel_map(void *data)
     assert(cwc_toplevel_is_fullscreen(toplevel));
 
     cwc_log(CWC_INFO, "C SIGNAL TEST OK");
+
+    object_signal_bench(toplevel);
 }
 
 static void on_custom_signal(void *data)
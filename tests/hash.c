@@ -2,6 +2,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #include "cwc/util.h"
 
@@ -127,19 +128,306 @@ void repeated_read(struct cwc_hhmap *m)
     }
 }
 
+//================ IMAP & STRMAP ==================
+
+static double elapsed_ms(struct timespec *start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) * 1e3
+           + (now.tv_nsec - start->tv_nsec) / 1e6;
+}
+
+/* Every map run the same workload on the same keys so the numbers can be
+ * compared: insert every key, read them in order, read them in a shuffled
+ * order, then remove them. Integer keys are 0..TABLE_SIZE-1 and string keys
+ * are their decimal form.
+ */
+static int *read_order;
+static char (*str_keys)[KEY_LEN];
+
+/* same LCG as hash.cpp so both read in the same order */
+static void setup_workload()
+{
+    read_order = malloc(TABLE_SIZE * sizeof(*read_order));
+    str_keys   = calloc(TABLE_SIZE, KEY_LEN);
+    assert(read_order && str_keys);
+
+    uint64_t state = 69;
+    for (int i = 0; i < TABLE_SIZE; i++) {
+        state         = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        read_order[i] = (state >> 33) % TABLE_SIZE;
+        sprintf(str_keys[i], "%d", i);
+    }
+}
+
+static void destroy_workload()
+{
+    free(read_order);
+    free(str_keys);
+}
+
+struct workload_time {
+    double insert, read, rand_read, remove;
+};
+
+static void print_workload(const char *name, struct workload_time *t)
+{
+    printf("%-13s insert %8.2f  read %8.2f  rand read %8.2f  remove %8.2f ms\n",
+           name, t->insert, t->read, t->rand_read, t->remove);
+}
+
+void imap_workload()
+{
+    struct cwc_imap *m = cwc_imap_create(0);
+    struct workload_time t;
+    struct timespec start;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < TABLE_SIZE; i++)
+        cwc_imap_insert(m, i, str_keys[i]);
+    t.insert = elapsed_ms(&start);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < TABLE_SIZE; i++) {
+        void *value = cwc_imap_get(m, i);
+        assert(value == str_keys[i]);
+    }
+    t.read = elapsed_ms(&start);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < TABLE_SIZE; i++) {
+        void *value = cwc_imap_get(m, read_order[i]);
+        assert(value == str_keys[read_order[i]]);
+    }
+    t.rand_read = elapsed_ms(&start);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < TABLE_SIZE; i++) {
+        bool removed = cwc_imap_remove(m, i);
+        assert(removed);
+    }
+    t.remove = elapsed_ms(&start);
+
+    assert(m->size == 0);
+    print_workload("imap", &t);
+    cwc_imap_destroy(m);
+}
+
+void hhmap_u64_workload()
+{
+    struct cwc_hhmap *m = cwc_hhmap_create(0);
+    struct workload_time t;
+    struct timespec start;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < TABLE_SIZE; i++) {
+        uint64_t k = i;
+        cwc_hhmap_ninsert(m, &k, sizeof(k), str_keys[i]);
+    }
+    t.insert = elapsed_ms(&start);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < TABLE_SIZE; i++) {
+        uint64_t k  = i;
+        void *value = cwc_hhmap_nget(m, &k, sizeof(k));
+        assert(value == str_keys[i]);
+    }
+    t.read = elapsed_ms(&start);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < TABLE_SIZE; i++) {
+        uint64_t k  = read_order[i];
+        void *value = cwc_hhmap_nget(m, &k, sizeof(k));
+        assert(value == str_keys[k]);
+    }
+    t.rand_read = elapsed_ms(&start);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < TABLE_SIZE; i++) {
+        uint64_t k = i;
+        cwc_hhmap_nremove(m, &k, sizeof(k));
+    }
+    t.remove = elapsed_ms(&start);
+
+    print_workload("hhmap (u64)", &t);
+    cwc_hhmap_destroy(m);
+}
+
+void strmap_workload()
+{
+    struct cwc_strmap *m = cwc_strmap_create(0);
+    struct workload_time t;
+    struct timespec start;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < TABLE_SIZE; i++)
+        cwc_strmap_insert(m, str_keys[i], str_keys[i]);
+    t.insert = elapsed_ms(&start);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < TABLE_SIZE; i++) {
+        void *value = cwc_strmap_get(m, str_keys[i]);
+        assert(value == str_keys[i]);
+    }
+    t.read = elapsed_ms(&start);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < TABLE_SIZE; i++) {
+        const char *key = str_keys[read_order[i]];
+        void *value     = cwc_strmap_get(m, key);
+        assert(value == key);
+    }
+    t.rand_read = elapsed_ms(&start);
+
+    for (int i = 0; i < TABLE_SIZE; i += TABLE_SIZE / 16) {
+        const char *interned = cwc_strmap_intern(m, str_keys[i]);
+        assert(interned == cwc_strmap_get_entry(m, str_keys[i])->key);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < TABLE_SIZE; i++) {
+        bool removed = cwc_strmap_remove(m, str_keys[i]);
+        assert(removed);
+    }
+    t.remove = elapsed_ms(&start);
+
+    assert(m->size == 0);
+    print_workload("strmap", &t);
+    cwc_strmap_destroy(m);
+}
+
+void hhmap_str_workload()
+{
+    struct cwc_hhmap *m = cwc_hhmap_create(0);
+    struct workload_time t;
+    struct timespec start;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < TABLE_SIZE; i++)
+        cwc_hhmap_insert(m, str_keys[i], str_keys[i]);
+    t.insert = elapsed_ms(&start);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < TABLE_SIZE; i++) {
+        void *value = cwc_hhmap_get(m, str_keys[i]);
+        assert(value == str_keys[i]);
+    }
+    t.read = elapsed_ms(&start);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < TABLE_SIZE; i++) {
+        const char *key = str_keys[read_order[i]];
+        void *value     = cwc_hhmap_get(m, key);
+        assert(value == key);
+    }
+    t.rand_read = elapsed_ms(&start);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < TABLE_SIZE; i++)
+        cwc_hhmap_remove(m, str_keys[i]);
+    t.remove = elapsed_ms(&start);
+
+    print_workload("hhmap (str)", &t);
+    cwc_hhmap_destroy(m);
+}
+
+/* insert+remove churn with pointer key, the case that break hhmap */
+void imap_churn(struct cwc_imap *m)
+{
+    for (int i = 0; i < TABLE_SIZE; i++) {
+        void *ptr = (void *)(uintptr_t)((i % 64) * 0x40 + 0x7f0000000000);
+        cwc_imap_pinsert(m, ptr, ptr);
+        assert(cwc_imap_pget(m, ptr) == ptr);
+        cwc_imap_premove(m, ptr);
+    }
+
+    assert(m->size == 0);
+}
+
+/* read from small table which is the common case for keybind and signal */
+void small_read()
+{
+    struct cwc_hhmap *hm     = cwc_hhmap_create(0);
+    struct cwc_hhmap *hm_str = cwc_hhmap_create(0);
+    struct cwc_imap *im      = cwc_imap_create(0);
+    struct cwc_strmap *sm    = cwc_strmap_create(0);
+    struct timespec start;
+    const int small = 64;
+    char keys[64][KEY_LEN];
+    for (int i = 0; i < small; i++) {
+        memset(keys[i], 0, KEY_LEN);
+        sprintf(keys[i], "%d", i);
+        uint64_t k = i;
+        cwc_hhmap_ninsert(hm, &k, sizeof(k), keys[i]);
+        cwc_hhmap_insert(hm_str, keys[i], keys[i]);
+        cwc_imap_insert(im, k, keys[i]);
+        cwc_strmap_insert(sm, keys[i], keys[i]);
+    }
+
+    void *volatile sink;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < TABLE_SIZE; i++) {
+        uint64_t k = i % small;
+        sink       = cwc_hhmap_nget(hm, &k, sizeof(k));
+    }
+    printf("small read hhmap (u64):\t%.2f ms\n", elapsed_ms(&start));
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < TABLE_SIZE; i++)
+        sink = cwc_imap_get(im, i % small);
+    printf("small read imap (u64):\t%.2f ms\n", elapsed_ms(&start));
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < TABLE_SIZE; i++)
+        sink = cwc_hhmap_get(hm_str, keys[i % small]);
+    printf("small read hhmap (str):\t%.2f ms\n", elapsed_ms(&start));
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < TABLE_SIZE; i++)
+        sink = cwc_strmap_get(sm, keys[i % small]);
+    printf("small read strmap:\t%.2f ms\n", elapsed_ms(&start));
+
+    (void)sink;
+    cwc_hhmap_destroy(hm);
+    cwc_hhmap_destroy(hm_str);
+    cwc_imap_destroy(im);
+    cwc_strmap_destroy(sm);
+}
+
 int main()
 {
-    TABLE_SIZE          = 1e7;
+    struct timespec start;
+    TABLE_SIZE = 1e7;
+
     struct cwc_hhmap *m = cwc_hhmap_create(0);
     setup_data(m);
 
+    clock_gettime(CLOCK_MONOTONIC, &start);
     for (int i = 0; i < 5; i++) {
         // basic_perf(m);
         repeated_read(m);
     }
+    printf("repeated read hhmap:\t%.2f ms\n", elapsed_ms(&start));
 
     destroy_data(m);
 
     cwc_hhmap_destroy(m);
+
+    setup_workload();
+    hhmap_u64_workload();
+    imap_workload();
+    hhmap_str_workload();
+    strmap_workload();
+    destroy_workload();
+
+    struct cwc_imap *im = cwc_imap_create(0);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    imap_churn(im);
+    printf("churn imap:\t\t%.2f ms\n", elapsed_ms(&start));
+    cwc_imap_destroy(im);
+
+    small_read();
+
     return 0;
 }
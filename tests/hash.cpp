@@ -1,14 +1,18 @@
 #include <boost/unordered/unordered_flat_map.hpp>
 #include <cassert>
+#include <chrono>
+#include <cstdio>
 #include <cstdint>
 #include <string>
 #include <unordered_map>
+#include <vector>
 using namespace std;
 
 static int TABLE_SIZE;
 
 // boost::unordered::unordered_flat_map<string, char*> umap;
 unordered_map<string, char*> umap;
+unordered_map<uint64_t, char*> imap;
 
 void setup_data()
 {
@@ -88,6 +92,65 @@ void repeated_read()
     }
 }
 
+/* same workload as the maps in hash.c: insert, read in order, read in the
+ * shuffled order, then remove every key.
+ */
+static vector<int> read_order;
+static vector<string> str_keys;
+
+static void setup_workload()
+{
+    uint64_t state = 69;
+    for (int i = 0; i < TABLE_SIZE; i++) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        read_order.push_back((state >> 33) % TABLE_SIZE);
+        str_keys.push_back(to_string(i));
+    }
+}
+
+static double elapsed_ms(chrono::steady_clock::time_point start)
+{
+    chrono::duration<double, milli> elapsed =
+        chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+template <typename Map, typename KeyOf>
+static void workload(const char *name, Map &map, KeyOf key_of)
+{
+    double insert, read, rand_read, remove;
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < TABLE_SIZE; ++i)
+        map[key_of(i)] = (char *)(long)i + 1;
+    insert = elapsed_ms(start);
+
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < TABLE_SIZE; ++i) {
+        char *value = map.find(key_of(i))->second;
+        assert(value == (char *)(long)i + 1);
+    }
+    read = elapsed_ms(start);
+
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < TABLE_SIZE; ++i) {
+        int k       = read_order[i];
+        char *value = map.find(key_of(k))->second;
+        assert(value == (char *)(long)k + 1);
+    }
+    rand_read = elapsed_ms(start);
+
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < TABLE_SIZE; ++i) {
+        size_t erased = map.erase(key_of(i));
+        assert(erased == 1);
+    }
+    remove = elapsed_ms(start);
+
+    assert(map.empty());
+    printf("%-13s insert %8.2f  read %8.2f  rand read %8.2f  remove %8.2f ms\n",
+           name, insert, read, rand_read, remove);
+}
+
 int main()
 {
     TABLE_SIZE = 1e7;
@@ -98,5 +161,12 @@ int main()
     }
 
     destroy_data();
+
+    setup_workload();
+    workload("umap (u64)", imap, [](int i) { return (uint64_t)i; });
+    unordered_map<string, char *> smap;
+    workload("umap (str)", smap, [](int i) -> const string & {
+        return str_keys[i];
+    });
     return 0;
 }
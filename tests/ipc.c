@@ -0,0 +1,75 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "cwc/ipc.h"
+
+struct batch {
+    struct ipc_buffer buf;
+    size_t last_len;
+};
+
+/* same as what ipc_signal_forward do for a subscriber */
+static void batch_push(struct batch *batch, const char *event)
+{
+    size_t len = strlen(event);
+    if (ipc_signal_batch_repeat(&batch->buf, batch->last_len, event, len))
+        return;
+
+    bool appended = ipc_buffer_append(&batch->buf, event, len);
+    assert(appended);
+    (void)appended;
+    batch->last_len = len;
+}
+
+static void batch_expect(struct batch *batch, const char *expected)
+{
+    assert(batch->buf.len == strlen(expected));
+    assert(memcmp(ipc_buffer_head(&batch->buf), expected, batch->buf.len) == 0);
+
+    ipc_buffer_consume(&batch->buf, batch->buf.len);
+    batch->last_len = 0;
+}
+
+static void coalesce_test()
+{
+    struct batch batch = {0};
+
+    batch_push(&batch, "client::focus\tA\n");
+    batch_push(&batch, "client::focus\tA\n");
+    batch_push(&batch, "client::focus\tB\n");
+    batch_push(&batch, "client::focus\tB\n");
+    batch_expect(&batch, "client::focus\tA\n"
+                         "client::focus\tB\n");
+
+    // the last state must win even when it was seen earlier in the batch
+    batch_push(&batch, "client::focus\tA\n");
+    batch_push(&batch, "client::focus\tB\n");
+    batch_push(&batch, "client::focus\tA\n");
+    batch_expect(&batch, "client::focus\tA\n"
+                         "client::focus\tB\n"
+                         "client::focus\tA\n");
+
+    // a flushed batch doesn't coalesce with the next one
+    batch_push(&batch, "client::focus\tA\n");
+    batch_expect(&batch, "client::focus\tA\n");
+    batch_push(&batch, "client::focus\tA\n");
+    batch_expect(&batch, "client::focus\tA\n");
+
+    // an event that end with the previous one is a different event
+    batch_push(&batch, "focus\tA\n");
+    batch_push(&batch, "client::focus\tA\n");
+    batch_push(&batch, "focus\tA\n");
+    batch_expect(&batch, "focus\tA\n"
+                         "client::focus\tA\n"
+                         "focus\tA\n");
+
+    ipc_buffer_fini(&batch.buf);
+    puts("Signal batch coalescing test passed");
+}
+
+int main()
+{
+    coalesce_test();
+    return 0;
+}
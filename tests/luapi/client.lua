@@ -60,6 +60,14 @@ end
 local function static_test()
     local cls = cwc.client.get()
     assert(#cls == 20)
+    -- every call get its own copy, modifying it doesn't affect the next one
+    local first = cls[1]
+    table.remove(cls, 1)
+    cls[1] = first
+    assert(cls ~= cwc.client.get())
+    assert(#cwc.client.get() == 20 and cwc.client.get()[1] == first)
+    -- nobody is capturing the test clients
+    assert(cwc.client.capture_scene_count() == 0)
     assert(cwc.client.default_decoration_mode == enum.decoration_mode.SERVER_SIDE)
     cwc.client.default_decoration_mode = enum.decoration_mode.CLIENT_SIDE
     assert(cwc.client.default_decoration_mode == enum.decoration_mode.CLIENT_SIDE)
@@ -172,12 +180,39 @@ local function method_test(c)
     rand:kill()
 end
 
+-- method added to the class after it's registered is reachable as property
+local function late_method_test(c)
+    local index = getmetatable(c).__cwcindex
+    local stored
+    index.get_late_prop = function() return 1 end
+    index.set_late_prop = function(_, v) stored = v end
+    assert(c.late_prop == 1)
+    c.late_prop = 2
+    assert(stored == 2)
+
+    -- replacing and removing is seen after the first lookup
+    index.get_late_prop = function() return 3 end
+    assert(c.late_prop == 3)
+    index.get_late_prop = nil
+    index.set_late_prop = nil
+    assert(c.late_prop == nil)
+    c.late_prop = 4
+    assert(stored == 2)
+
+    local get_title = index.get_title
+    index.get_title = function() return "late" end
+    assert(c.title == "late")
+    index.get_title = get_title
+    assert(c.title == c:get_title())
+end
+
 local function test()
     static_test()
 
     local c = cwc.client.focused()
     readonly_test(c)
     property_test(c)
+    late_method_test(c)
     method_test(c)
 
     print("cwc_client test \27[1;32mPASSED\27[0m")
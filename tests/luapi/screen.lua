@@ -103,6 +103,10 @@ local function method_test(s)
     assert(#s.clients == #s:get_clients())
     assert(#s.containers == #s:get_containers())
     assert(#s.minimized == #s:get_minimized())
+    -- the returned list is a copy
+    local cls = s:get_clients()
+    cls[#cls + 1] = 1
+    assert(cls ~= s:get_clients() and #s:get_clients() == #cls - 1)
     s:get_nearest(enum.direction.LEFT)
     s:focus()
 end
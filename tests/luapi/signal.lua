@@ -20,6 +20,71 @@ local function on_client_unmap(c)
     print("lua client unmap signal \27[1;32mPASSED\27[0m", c)
 end
 
+local deferred_called = 0
+local function on_custom_deferred(...)
+    deferred_called = deferred_called + 1
+    assert(deferred_called == 1)
+    assert(select("#", ...) == 0)
+
+    local stats = cwc.signal_stats("custom::deferred")
+    assert(stats.delivered == 1)
+    print("lua deferred signal test \27[1;32mPASSED\27[0m")
+end
+
+local function test_deferred()
+    cwc.connect_signal("custom::deferred", on_custom_deferred, true)
+    for _ = 1, 3 do
+        cwc.emit_signal("custom::deferred")
+    end
+
+    assert(deferred_called == 0)
+
+    local stats = cwc.signal_stats("custom::deferred")
+    assert(stats.emitted == 3)
+    assert(stats.collapsed == 2)
+    assert(stats.delivered == 0)
+    assert(cwc.signal_stats("custom::not_exist") == nil)
+end
+
+-- signal emitted from lua with an object collapse per object
+local function test_deferred_object(clients)
+    local delivered = {}
+    cwc.connect_signal("custom::deferred_object", function(c, ...)
+        assert(select("#", ...) == 0)
+        delivered[c] = (delivered[c] or 0) + 1
+        assert(delivered[c] == 1)
+        if delivered[clients[1]] and delivered[clients[2]] then
+            print("lua deferred object signal test \27[1;32mPASSED\27[0m")
+        end
+    end, true)
+
+    for _ = 1, 3 do
+        cwc.emit_signal("custom::deferred_object", clients[1], "unused")
+    end
+    cwc.emit_signal("custom::deferred_object", clients[2])
+
+    local stats = cwc.signal_stats("custom::deferred_object")
+    assert(stats.emitted == 4)
+    assert(stats.collapsed == 2)
+    assert(stats.delivered == 0)
+end
+
+local function test_skip()
+    local function noop() end
+    local live = cwc.pool_stats().signal_lua_callback.live
+    cwc.connect_signal("custom::silent", noop)
+    assert(cwc.pool_stats().signal_lua_callback.live == live + 1)
+    cwc.disconnect_signal("custom::silent", noop)
+    assert(cwc.pool_stats().signal_lua_callback.live == live)
+    cwc.emit_signal("custom::silent", "unused")
+    cwc.emit_signal("custom::silent", "unused")
+
+    local stats = cwc.signal_stats("custom::silent")
+    assert(stats.skipped == 2)
+    assert(stats.dispatched == 0)
+    assert(cwc.signal_stats("client::custom").dispatched == 2)
+end
+
 local function test()
     cwc.connect_signal("client::map", on_client_map)
     cwc.connect_signal("client::unmap", on_client_unmap)
@@ -28,6 +93,10 @@ local function test()
     cwc.connect_signal("client::custom", on_client_custom)
     cwc.emit_signal("client::custom", clients[1], "sig1")
     cwc.emit_signal("client::custom", clients[1], "sig2", 100)
+
+    test_deferred()
+    test_deferred_object(clients)
+    test_skip()
 end
 
 return test
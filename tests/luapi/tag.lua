@@ -1,5 +1,6 @@
 -- Test the cwc_tag property
 
+local bit = require("bit")
 local enum = require("cuteful.enum")
 
 local cwc = cwc
@@ -38,14 +39,67 @@ end
 local function readonly_test(tag)
     assert(tag.index == 3)
     assert(tostring(tag.screen):match("cwc_screen"))
+    assert(type(tag.client_count) == "number")
+    assert(tag.urgent_count <= tag.client_count)
+    assert(type(tag.focused) == "boolean")
+end
+
+-- drive a known number of change and check the exact counter value
+local function counter_test(tag)
+    local mask = bit.lshift(1, tag.index - 1)
+    local c
+    for _, cl in ipairs(cwc.client.get(tag.screen, true)) do
+        if bit.band(cl.tag, mask) == 0 then
+            c = cl
+            break
+        end
+    end
+    assert(c and not c.urgent)
+
+    local workspace = c.workspace
+    local clients = tag.client_count
+    local urgents = tag.urgent_count
+
+    c:move_to_tag(tag.index)
+    assert(tag.client_count == clients + 1)
+    assert(tag.urgent_count == urgents)
+
+    c.urgent = true
+    assert(tag.urgent_count == urgents + 1)
+    c.urgent = false
+    assert(tag.urgent_count == urgents)
+
+    c:focus()
+    assert(cwc.client.focused() == c and tag.focused)
+
+    c:move_to_tag(workspace)
+    assert(tag.client_count == clients)
+    assert(tag.urgent_count == urgents)
+
+    local focused = cwc.client.focused()
+    local on_tag = focused ~= nil and focused.screen == tag.screen
+        and bit.band(focused.tag, mask) ~= 0
+    assert(tag.focused == on_tag)
+end
+
+-- the visible list follow the selected tags
+local function visible_list_test(s)
+    local visible = {}
+    for _, c in ipairs(s:get_clients(true)) do visible[c] = true end
+    for _, c in ipairs(s:get_clients()) do
+        assert(c.visible == (visible[c] == true))
+    end
 end
 
 local function property_test(tag)
     assert(tag.selected)
+    visible_list_test(tag.screen)
     tag.selected = not tag.selected
     assert(tag.selected == false)
+    visible_list_test(tag.screen)
     tag:toggle()
     assert(tag.selected)
+    visible_list_test(tag.screen)
 
     assert(tag.label == "3")
     tag.label = "W3"
@@ -87,6 +141,7 @@ local function test()
 
     method_test(tag)
     readonly_test(tag)
+    counter_test(tag)
     property_test(tag)
 
     print("cwc_tag test \27[1;32mPASSED\27[0m")
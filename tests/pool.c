@@ -0,0 +1,110 @@
+#include <assert.h>
+#include <stdalign.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "cwc/util.h"
+
+struct node {
+    struct node *parent;
+    int value;
+    char pad[13];
+};
+
+static struct cwc_pool node_pool = CWC_POOL_INIT("node", struct node, 4);
+
+static void functional_test()
+{
+    struct node *nodes[10];
+
+    for (int i = 0; i < 10; i++) {
+        nodes[i] = cwc_pool_alloc(&node_pool);
+        assert(nodes[i]);
+        assert(nodes[i]->parent == NULL && nodes[i]->value == 0);
+        assert((uintptr_t)nodes[i] % alignof(max_align_t) == 0);
+        nodes[i]->value = i;
+    }
+
+    for (int i = 0; i < 10; i++)
+        assert(nodes[i]->value == i);
+
+    assert(node_pool.stats.live == 10);
+    assert(node_pool.stats.peak == 10);
+    assert(node_pool.stats.slabs == 3);
+    assert(node_pool.stats.reuse == 0);
+
+    // freed object is reused before carving a new slab
+    struct node *freed = nodes[3];
+    cwc_pool_free(&node_pool, freed);
+    cwc_pool_free(&node_pool, NULL);
+    assert(node_pool.stats.live == 9);
+
+    nodes[3] = cwc_pool_alloc(&node_pool);
+    assert(nodes[3] == freed);
+    assert(nodes[3]->parent == NULL && nodes[3]->value == 0);
+    assert(node_pool.stats.reuse == 1);
+    assert(node_pool.stats.slabs == 3);
+
+    for (int i = 0; i < 10; i++)
+        cwc_pool_free(&node_pool, nodes[i]);
+
+    assert(node_pool.stats.live == 0);
+    assert(node_pool.stats.peak == 10);
+    assert(node_pool.stats.allocs == 11);
+
+    cwc_pool_fini(&node_pool);
+    assert(node_pool.stats.slabs == 0);
+    puts("Functional test passed");
+}
+
+static void count_pool(struct cwc_pool *pool, void *data)
+{
+    if (pool == &node_pool)
+        (*(int *)data)++;
+}
+
+static void registry_test()
+{
+    int found = 0;
+    cwc_pool_for_each(count_pool, &found);
+    assert(found == 1);
+    puts("Registry test passed");
+}
+
+static void churn_test()
+{
+    struct node *live[64] = {0};
+
+    for (size_t i = 0; i < 1000000; i++) {
+        int slot = (i * 7919) % 64;
+        if (live[slot]) {
+            assert(live[slot]->value == slot);
+            cwc_pool_free(&node_pool, live[slot]);
+            live[slot] = NULL;
+        } else {
+            live[slot]        = cwc_pool_alloc(&node_pool);
+            live[slot]->value = slot;
+        }
+    }
+
+    assert(node_pool.stats.peak <= 64);
+    assert(node_pool.stats.slabs <= 64 / 4);
+    printf("churn: %lu allocs, %lu reused, %lu slabs\n",
+           node_pool.stats.allocs, node_pool.stats.reuse,
+           node_pool.stats.slabs);
+
+    for (int i = 0; i < 64; i++)
+        cwc_pool_free(&node_pool, live[i]);
+
+    cwc_pool_fini(&node_pool);
+    puts("Churn test passed");
+}
+
+int main()
+{
+    functional_test();
+    registry_test();
+    churn_test();
+}
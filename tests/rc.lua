@@ -14,6 +14,7 @@ local pointer_test = require("luapi.pointer")
 local kbd_test = require("luapi.kbd")
 local tablet_test = require("luapi.tablet")
 local input_test = require("luapi.input")
+local bench = require("bench")
 
 local cwc = cwc
 
@@ -120,6 +121,14 @@ cwc.kbd.bind({}, "F1", function()
     io.flush()
 end)
 
+-- benchmark by pressing F11, kept out of the API test so timing never affect it
+cwc.kbd.bind({}, "F11", function()
+    print("\n--------------------------------- BENCHMARK START ------------------------------------")
+    bench()
+    print("--------------------------------- BENCHMARK END ------------------------------------")
+    io.flush()
+end)
+
 cwc.kbd.bind({ MODKEY, mod.CTRL }, "r", cwc.reload, { description = "reload configuration" })
 kbd.bind({ MODKEY, mod.CTRL }, "Delete", cwc.quit, { description = "exit cwc", group = "cwc" })
 